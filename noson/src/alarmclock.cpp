@@ -132,7 +132,7 @@ void AlarmClock::HandleEventMessage(EventMessagePtr msg)
     return;
   if (msg->event == EVENT_UPNP_PROPCHANGE)
   {
-    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "PROPERTY")
+    if (m_subscription.GetSID() == msg->subject[0] && msg->kind == PROPCHANGE_PROPERTY)
     {
       {
         // BEGIN CRITICAL SECTION
@@ -141,8 +141,7 @@ void AlarmClock::HandleEventMessage(EventMessagePtr msg)
         DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
 
         // check for higher sequence
-        uint32_t seq = 0;
-        string_to_uint32(msg->subject[1].c_str(), &seq);
+        uint32_t seq = msg->seq;
         if (msg->subject[0] != prop->EventSID)
         {
           prop->EventSID = msg->subject[0];
@@ -155,29 +154,37 @@ void AlarmClock::HandleEventMessage(EventMessagePtr msg)
         // tracking serial of the event
         prop->EventSEQ = seq;
 
-        std::vector<std::string>::const_iterator it = msg->subject.begin();
-        while (it != msg->subject.end())
+        for (const EventVariable& var : msg->vars)
         {
           uint32_t num;
-          if (*it == "AlarmListVersion")
-            prop->alarmListVersion.assign(*++it);
-          else if (*it == "DailyIndexRefreshTime")
-            prop->dailyIndexRefreshTime.assign(*++it);
-          else if (*it == "DateFormat")
-            prop->dateFormat.assign(*++it);
-          else if (*it == "TimeFormat")
-            prop->timeFormat.assign(*++it);
-          else if (*it == "TimeGeneration")
+          const std::string& val = msg->Value(var);
+          switch (var.key)
           {
-            string_to_uint32((*++it).c_str(), &num);
+          case EVENT_VAR_AlarmListVersion:
+            prop->alarmListVersion.assign(val);
+            break;
+          case EVENT_VAR_DailyIndexRefreshTime:
+            prop->dailyIndexRefreshTime.assign(val);
+            break;
+          case EVENT_VAR_DateFormat:
+            prop->dateFormat.assign(val);
+            break;
+          case EVENT_VAR_TimeFormat:
+            prop->timeFormat.assign(val);
+            break;
+          case EVENT_VAR_TimeGeneration:
+            string_to_uint32(val.c_str(), &num);
             prop->timeGeneration = (unsigned)num;
+            break;
+          case EVENT_VAR_TimeServer:
+            prop->timeServer.assign(val);
+            break;
+          case EVENT_VAR_TimeZone:
+            prop->timeZone.assign(val);
+            break;
+          default:
+            break;
           }
-          else if (*it == "TimeServer")
-            prop->timeServer.assign(*++it);
-          else if (*it == "TimeZone")
-            prop->timeZone.assign(*++it);
-
-          ++it;
         }
         // END CRITICAL SECTION
       }
@@ -86,7 +86,7 @@ bool AVTransport::GetTransportInfo(ElementList& vars)
 {
   ElementList args;
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  vars = Request("GetTransportInfo", args);
+  vars = RequestCached("GetTransportInfo", args);
   if (!vars.empty() && vars[0]->compare("GetTransportInfoResponse") == 0)
     return true;
   return false;
@@ -116,7 +116,7 @@ bool AVTransport::GetMediaInfo(ElementList& vars)
 {
   ElementList args;
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  vars = Request("GetMediaInfo", args);
+  vars = RequestCached("GetMediaInfo", args);
   if (!vars.empty() && vars[0]->compare("GetMediaInfoResponse") == 0)
     return true;
   return false;
@@ -484,7 +484,7 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
     return;
   if (msg->event == EVENT_UPNP_PROPCHANGE)
   {
-    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "AVT")
+    if (m_subscription.GetSID() == msg->subject[0] && msg->kind == PROPCHANGE_AVT)
     {
       {
         // BEGIN CRITICAL SECTION
@@ -493,8 +493,7 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
         DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
 
         // check for higher sequence
-        uint32_t seq = 0;
-        string_to_uint32(msg->subject[1].c_str(), &seq);
+        uint32_t seq = msg->seq;
         if (msg->subject[0] != prop->EventSID)
         {
           prop->EventSID = msg->subject[0];
@@ -506,106 +505,135 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
         }
         // tracking serial of the event
         prop->EventSEQ = seq;
+        // the state has changed
+        InvalidateCache();
 
-        std::vector<std::string>::const_iterator it = msg->subject.begin();
-        while (it != msg->subject.end())
+        for (const EventVariable& var : msg->vars)
         {
           uint32_t num;
-          if (*it == "TransportState")
-            prop->TransportState.assign(*++it);
-          else if (*it == "CurrentPlayMode")
-            prop->CurrentPlayMode.assign(*++it);
-          else if (*it == "CurrentCrossfadeMode")
-            prop->CurrentCrossfadeMode.assign(*++it);
-          else if (*it == "NumberOfTracks")
+          const std::string& val = msg->Value(var);
+          switch (var.key)
           {
-            string_to_uint32((*++it).c_str(), &num);
+          case EVENT_VAR_TransportState:
+            prop->TransportState.assign(val);
+            break;
+          case EVENT_VAR_CurrentPlayMode:
+            prop->CurrentPlayMode.assign(val);
+            break;
+          case EVENT_VAR_CurrentCrossfadeMode:
+            prop->CurrentCrossfadeMode.assign(val);
+            break;
+          case EVENT_VAR_NumberOfTracks:
+            string_to_uint32(val.c_str(), &num);
             prop->NumberOfTracks = (unsigned)num;
-          }
-          else if (*it == "CurrentTrack")
-          {
-            string_to_uint32((*++it).c_str(), &num);
+            break;
+          case EVENT_VAR_CurrentTrack:
+            string_to_uint32(val.c_str(), &num);
             prop->CurrentTrack = (unsigned)num;
-          }
-          else if (*it == "CurrentSection")
-          {
-            string_to_uint32((*++it).c_str(), &num);
+            break;
+          case EVENT_VAR_CurrentSection:
+            string_to_uint32(val.c_str(), &num);
             prop->CurrentSection = (unsigned)num;
-          }
-          else if (*it == "CurrentTrackURI")
-            prop->CurrentTrackURI.assign(*++it);
-          else if (*it == "CurrentTrackDuration")
-            prop->CurrentTrackDuration.assign(*++it);
-          else if (*it == "CurrentTrackMetaData")
+            break;
+          case EVENT_VAR_CurrentTrackURI:
+            prop->CurrentTrackURI.assign(val);
+            break;
+          case EVENT_VAR_CurrentTrackDuration:
+            prop->CurrentTrackDuration.assign(val);
+            break;
+          case EVENT_VAR_CurrentTrackMetaData:
           {
-            DIDLParser didl((*++it).c_str());
+            DIDLParser didl(val.c_str());
             if (didl.IsValid() && !didl.GetItems().empty())
               prop->CurrentTrackMetaData = didl.GetItems()[0];
             else
               prop->CurrentTrackMetaData.reset(new DigitalItem(DigitalItem::Type_unknown));
+            break;
           }
-          else if (*it == "r:NextTrackURI")
-            prop->r_NextTrackURI.assign(*++it);
-          else if (*it == "r:NextTrackMetaData")
+          case EVENT_VAR_r_NextTrackURI:
+            prop->r_NextTrackURI.assign(val);
+            break;
+          case EVENT_VAR_r_NextTrackMetaData:
           {
-            DIDLParser didl((*++it).c_str());
+            DIDLParser didl(val.c_str());
             if (didl.IsValid() && !didl.GetItems().empty())
               prop->r_NextTrackMetaData = didl.GetItems()[0];
             else
               prop->r_NextTrackMetaData.reset(new DigitalItem(DigitalItem::Type_unknown));
+            break;
           }
-          else if (*it == "r:EnqueuedTransportURI")
-            prop->r_EnqueuedTransportURI.assign(*++it);
-          else if (*it == "r:EnqueuedTransportURIMetaData")
+          case EVENT_VAR_r_EnqueuedTransportURI:
+            prop->r_EnqueuedTransportURI.assign(val);
+            break;
+          case EVENT_VAR_r_EnqueuedTransportURIMetaData:
           {
-            DIDLParser didl((*++it).c_str());
+            DIDLParser didl(val.c_str());
             if (didl.IsValid() && !didl.GetItems().empty())
               prop->r_EnqueuedTransportURIMetaData = didl.GetItems()[0];
             else
               prop->r_EnqueuedTransportURIMetaData.reset(new DigitalItem(DigitalItem::Type_unknown));
+            break;
           }
-          else if (*it == "PlaybackStorageMedium")
-            prop->PlaybackStorageMedium.assign(*++it);
-          else if (*it == "AVTransportURI")
-            prop->AVTransportURI.assign(*++it);
-          else if (*it == "AVTransportURIMetaData")
+          case EVENT_VAR_PlaybackStorageMedium:
+            prop->PlaybackStorageMedium.assign(val);
+            break;
+          case EVENT_VAR_AVTransportURI:
+            prop->AVTransportURI.assign(val);
+            break;
+          case EVENT_VAR_AVTransportURIMetaData:
           {
-            DIDLParser didl((*++it).c_str());
+            DIDLParser didl(val.c_str());
             if (didl.IsValid() && !didl.GetItems().empty())
               prop->AVTransportURIMetaData = didl.GetItems()[0];
             else
               prop->AVTransportURIMetaData.reset(new DigitalItem(DigitalItem::Type_unknown));
+            break;
+          }
+          case EVENT_VAR_NextAVTransportURI:
+            prop->NextAVTransportURI.assign(val);
+            break;
+          case EVENT_VAR_NextAVTransportURIMetaData:
+            prop->NextAVTransportURIMetaData.assign(val);
+            break;
+          case EVENT_VAR_CurrentTransportActions:
+            prop->CurrentTransportActions.assign(val);
+            break;
+          case EVENT_VAR_r_CurrentValidPlayModes:
+            prop->r_CurrentValidPlayModes.assign(val);
+            break;
+          case EVENT_VAR_r_MuseSessions:
+            prop->r_MuseSessions.assign(val);
+            break;
+          case EVENT_VAR_TransportStatus:
+            prop->TransportStatus.assign(val);
+            break;
+          case EVENT_VAR_r_SleepTimerGeneration:
+            prop->r_SleepTimerGeneration.assign(val);
+            break;
+          case EVENT_VAR_r_AlarmRunning:
+            prop->r_AlarmRunning.assign(val);
+            break;
+          case EVENT_VAR_r_AlarmIDRunning:
+            prop->r_AlarmIDRunning.assign(val);
+            break;
+          case EVENT_VAR_r_AlarmLoggedStartTime:
+            prop->r_AlarmLoggedStartTime.assign(val);
+            break;
+          case EVENT_VAR_r_AlarmState:
+            prop->r_AlarmState.assign(val);
+            break;
+          case EVENT_VAR_r_SnoozeRunning:
+            prop->r_SnoozeRunning.assign(val);
+            break;
+          case EVENT_VAR_r_RestartPending:
+            prop->r_RestartPending.assign(val);
+            break;
+          case EVENT_VAR_PossiblePlaybackStorageMedia:
+            prop->PossiblePlaybackStorageMedia.assign(val);
+            break;
+          default:
+            break;
           }
-          else if (*it == "NextAVTransportURI")
-            prop->NextAVTransportURI.assign(*++it);
-          else if (*it == "NextAVTransportURIMetaData")
-            prop->NextAVTransportURIMetaData.assign(*++it);
-          else if (*it == "CurrentTransportActions")
-            prop->CurrentTransportActions.assign(*++it);
-          else if (*it == "r:CurrentValidPlayModes")
-            prop->r_CurrentValidPlayModes.assign(*++it);
-          else if (*it == "r:MuseSessions")
-            prop->r_MuseSessions.assign(*++it);
-          else if (*it == "TransportStatus")
-            prop->TransportStatus.assign(*++it);
-          else if (*it == "r:SleepTimerGeneration")
-            prop->r_SleepTimerGeneration.assign(*++it);
-          else if (*it == "r:AlarmRunning")
-            prop->r_AlarmRunning.assign(*++it);
-          else if (*it == "r:AlarmIDRunning")
-            prop->r_AlarmIDRunning.assign(*++it);
-          else if (*it == "r:AlarmLoggedStartTime")
-            prop->r_AlarmLoggedStartTime.assign(*++it);
-          else if (*it == "r:AlarmState")
-            prop->r_AlarmState.assign(*++it);
-          else if (*it == "r:SnoozeRunning")
-            prop->r_SnoozeRunning.assign(*++it);
-          else if (*it == "r:RestartPending")
-            prop->r_RestartPending.assign(*++it);
-          else if (*it == "PossiblePlaybackStorageMedia")
-            prop->PossiblePlaybackStorageMedia.assign(*++it);
-
-          ++it;
         }
         // END CRITICAL SECTION
       }
@@ -24,7 +24,10 @@
 #include "private/tokenizer.h"
 #include "private/debug.h"
 #include "private/cppdef.h"
+#include "private/wsasyncclient.h"
 
+#include <algorithm>
+#include <deque>
 #include <list>
 
 using namespace NSROOT;
@@ -67,7 +70,7 @@ ContentDirectory::~ContentDirectory()
   }
 }
 
-bool ContentDirectory::Browse(const std::string& objectId, unsigned index, unsigned count, ElementList &vars)
+static ElementList __browseArgs(const std::string& objectId, unsigned index, unsigned count)
 {
   ElementList args;
   args.push_back(ElementPtr(new Element("ObjectID", objectId)));
@@ -76,12 +79,129 @@ bool ContentDirectory::Browse(const std::string& objectId, unsigned index, unsig
   args.push_back(ElementPtr(new Element("StartingIndex", std::to_string(index))));
   args.push_back(ElementPtr(new Element("RequestedCount", std::to_string(count))));
   args.push_back(ElementPtr(new Element("SortCriteria", "")));
-  vars = Request("Browse", args);
+  return args;
+}
+
+bool ContentDirectory::Browse(const std::string& objectId, unsigned index, unsigned count, ElementList &vars)
+{
+  vars = Request("Browse", __browseArgs(objectId, index, count));
   if (!vars.empty() && vars[0]->compare("BrowseResponse") == 0)
     return true;
   return false;
 }
 
+ServiceRequestPtr ContentDirectory::BrowseAsync(const std::string& objectId, unsigned index, unsigned count)
+{
+  return RequestAsync("Browse", __browseArgs(objectId, index, count));
+}
+
+namespace NSROOT
+{
+  struct BrowseChunk
+  {
+    uint32_t updateID = 0;
+    uint32_t totalCount = 0;
+    unsigned count = 0;
+  };
+}
+
+/**
+ * Append the items of the browse response, and extract its summary.
+ */
+static bool __readChunk(const ElementList& vars, BrowseChunk& chunk, std::vector<DigitalItemPtr>& items)
+{
+  ElementList::const_iterator it = vars.FindKey("Result");
+  if (it == vars.end())
+    return false;
+  string_to_uint32(vars.GetValue("UpdateID").c_str(), &chunk.updateID);
+  string_to_uint32(vars.GetValue("TotalMatches").c_str(), &chunk.totalCount);
+  uint32_t cnt = 0;
+  string_to_uint32(vars.GetValue("NumberReturned").c_str(), &cnt);
+  DIDLParser didl((*it)->c_str(), cnt);
+  if (!didl.IsValid())
+    return false;
+  items.insert(items.end(), didl.GetItems().begin(), didl.GetItems().end());
+  chunk.count = (unsigned) didl.GetItems().size();
+  return true;
+}
+
+bool ContentDirectory::BrowseAll(const std::string& objectId, std::vector<DigitalItemPtr>& items, unsigned concurrency, unsigned* updateID)
+{
+  // more chunks would only wait in the queue of the asynchronous client
+  unsigned limit = WSAsyncClient::Instance().GetHostConcurrency();
+  if (concurrency == 0)
+    concurrency = 1;
+  else if (concurrency > limit)
+    concurrency = limit;
+  for (unsigned attempt = 1; attempt <= BROWSE_ATTEMPTS; ++attempt)
+  {
+    items.clear();
+    ElementList vars;
+    BrowseChunk first;
+    if (!Browse(objectId, 0, BROWSE_COUNT, vars) || !__readChunk(vars, first, items))
+      return false;
+    items.reserve(first.totalCount);
+
+    typedef std::pair<unsigned, ServiceRequestPtr> Pending;
+    std::deque<Pending> pending;
+    unsigned requested = (unsigned) items.size();
+    bool failed = false;
+    bool changed = false;
+    while (items.size() < first.totalCount)
+    {
+      while (pending.size() < concurrency && requested < first.totalCount)
+      {
+        unsigned count = std::min<unsigned>(BROWSE_COUNT, first.totalCount - requested);
+        pending.push_back(std::make_pair(requested, BrowseAsync(objectId, requested, count)));
+        requested += count;
+      }
+      unsigned index = (unsigned) items.size();
+      bool ok;
+      vars.clear();
+      if (!pending.empty() && pending.front().first == index)
+      {
+        vars = pending.front().second->Wait();
+        pending.pop_front();
+        ok = (!vars.empty() && vars[0]->compare("BrowseResponse") == 0);
+      }
+      else
+      {
+        // a short chunk left a gap before the next one
+        unsigned next = (pending.empty() ? first.totalCount : pending.front().first);
+        ok = (next > index && Browse(objectId, index, std::min<unsigned>(BROWSE_COUNT, next - index), vars));
+      }
+      BrowseChunk chunk;
+      if (!ok || !__readChunk(vars, chunk, items) || chunk.count == 0)
+      {
+        failed = true;
+        break;
+      }
+      if (chunk.updateID != first.updateID || chunk.totalCount != first.totalCount)
+      {
+        changed = true;
+        break;
+      }
+    }
+    for (Pending& p : pending)
+      p.second->Cancel();
+    if (failed)
+    {
+      DBG(DBG_ERROR, "%s: browse failed at %u of %u\n", __FUNCTION__, (unsigned) items.size(), first.totalCount);
+      return false;
+    }
+    if (!changed)
+    {
+      DBG(DBG_PROTO, "%s: count %u\n", __FUNCTION__, (unsigned) items.size());
+      if (updateID)
+        *updateID = first.updateID;
+      return true;
+    }
+    DBG(DBG_WARN, "%s: content changed while loading (%u)\n", __FUNCTION__, attempt);
+  }
+  items.clear();
+  return false;
+}
+
 bool ContentDirectory::RefreshShareIndex()
 {
   ElementList vars;
@@ -122,7 +242,7 @@ void ContentDirectory::HandleEventMessage(EventMessagePtr msg)
     return;
   if (msg->event == EVENT_UPNP_PROPCHANGE)
   {
-    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "PROPERTY")
+    if (m_subscription.GetSID() == msg->subject[0] && msg->kind == PROPCHANGE_PROPERTY)
     {
       {
         // BEGIN CRITICAL SECTION
@@ -131,8 +251,7 @@ void ContentDirectory::HandleEventMessage(EventMessagePtr msg)
         DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
 
         // check for higher sequence
-        uint32_t seq = 0;
-        string_to_uint32(msg->subject[1].c_str(), &seq);
+        uint32_t seq = msg->seq;
         if (msg->subject[0] != prop->EventSID)
         {
           prop->EventSID = msg->subject[0];
@@ -145,16 +264,19 @@ void ContentDirectory::HandleEventMessage(EventMessagePtr msg)
         // tracking serial of the event
         prop->EventSEQ = seq;
 
-        std::vector<std::string>::const_iterator it = msg->subject.begin();
-        while (it != msg->subject.end())
+        for (const EventVariable& var : msg->vars)
         {
-          if (*it == "SystemUpdateID")
-            prop->SystemUpdateID.assign(*++it);
-          else if (*it == "ContainerUpdateIDs")
+          const std::string& val = msg->Value(var);
+          switch (var.key)
+          {
+          case EVENT_VAR_SystemUpdateID:
+            prop->SystemUpdateID.assign(val);
+            break;
+          case EVENT_VAR_ContainerUpdateIDs:
           {
             prop->ContainerUpdateIDs.clear();
             std::vector<std::string> tokens;
-            tokenize((*++it).c_str(), ",", "", tokens);
+            tokenize(val.c_str(), ",", "", tokens);
             std::vector<std::string>::const_iterator itt = tokens.begin();
             while (itt != tokens.end())
             {
@@ -166,31 +288,42 @@ void ContentDirectory::HandleEventMessage(EventMessagePtr msg)
                   prop->ContainerUpdateIDs.emplace_back(str, num);
               }
             }
+            break;
           }
-          else if (*it == "UserRadioUpdateID")
-            prop->UserRadioUpdateID.assign(*++it);
-          else if (*it == "SavedQueuesUpdateID")
-            prop->SavedQueuesUpdateID.assign(*++it);
-          else if (*it == "ShareListUpdateID")
-            prop->ShareListUpdateID.assign(*++it);
-          else if (*it == "RecentlyPlayedUpdateID")
-            prop->RecentlyPlayedUpdateID.assign(*++it);
-          else if (*it == "RadioFavoritesUpdateID")
-            prop->RadioFavoritesUpdateID.assign(*++it);
-          else if (*it == "RadioLocationUpdateID")
-            prop->RadioLocationUpdateID.assign(*++it);
-          else if (*it == "FavoritesUpdateID")
-            prop->FavoritesUpdateID.assign(*++it);
-          else if (*it == "FavoritePresetsUpdateID")
-            prop->FavoritePresetsUpdateID.assign(*++it);
-          else if (*it == "ShareIndexInProgress")
+          case EVENT_VAR_UserRadioUpdateID:
+            prop->UserRadioUpdateID.assign(val);
+            break;
+          case EVENT_VAR_SavedQueuesUpdateID:
+            prop->SavedQueuesUpdateID.assign(val);
+            break;
+          case EVENT_VAR_ShareListUpdateID:
+            prop->ShareListUpdateID.assign(val);
+            break;
+          case EVENT_VAR_RecentlyPlayedUpdateID:
+            prop->RecentlyPlayedUpdateID.assign(val);
+            break;
+          case EVENT_VAR_RadioFavoritesUpdateID:
+            prop->RadioFavoritesUpdateID.assign(val);
+            break;
+          case EVENT_VAR_RadioLocationUpdateID:
+            prop->RadioLocationUpdateID.assign(val);
+            break;
+          case EVENT_VAR_FavoritesUpdateID:
+            prop->FavoritesUpdateID.assign(val);
+            break;
+          case EVENT_VAR_FavoritePresetsUpdateID:
+            prop->FavoritePresetsUpdateID.assign(val);
+            break;
+          case EVENT_VAR_ShareIndexInProgress:
           {
             int32_t num;
-            string_to_int32((++it)->c_str(), &num);
+            string_to_int32(val.c_str(), &num);
             prop->ShareIndexInProgress = (num != 0);
+            break;
+          }
+          default:
+            break;
           }
-
-          ++it;
         }
         // END CRITICAL SECTION
       }
@@ -263,32 +396,43 @@ unsigned ContentChunk::summarize(const ElementList& vars)
 //// ContentList
 ////
 
-ContentList::ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize)
+ContentList::ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize, unsigned lookahead)
 : m_succeeded(false)
 , m_service(service)
 , m_bulkSize(BROWSE_COUNT)
 , m_root(search.Root())
 , m_browsedCount(0)
+, m_lookahead(lookahead)
+, m_requestedCount(0)
 {
   if (bulksize > 0 && bulksize < BROWSE_COUNT)
     m_bulkSize = bulksize;
-  BrowseContent(0, m_bulkSize, m_list.begin());
+  if (BrowseContent(0, m_bulkSize, m_list.begin()))
+    PrefetchContent();
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
 }
 
-ContentList::ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize)
+ContentList::ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize, unsigned lookahead)
 : m_succeeded(false)
 , m_service(service)
 , m_bulkSize(BROWSE_COUNT)
 , m_root(objectID)
 , m_browsedCount(0)
+, m_lookahead(lookahead)
+, m_requestedCount(0)
 {
   if (bulksize > 0 && bulksize < BROWSE_COUNT)
     m_bulkSize = bulksize;
-  BrowseContent(0, m_bulkSize, m_list.begin());
+  if (BrowseContent(0, m_bulkSize, m_list.begin()))
+    PrefetchContent();
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
 }
 
+ContentList::~ContentList()
+{
+  CancelPrefetch();
+}
+
 bool ContentList::Next(List::iterator& i)
 {
   const List::iterator e(m_list.end());
@@ -297,7 +441,11 @@ bool ContentList::Next(List::iterator& i)
     bool r = true;
     List::iterator n = i;
     if (++n == e)
-      r = BrowseContent(m_browsedCount, m_bulkSize, n);
+    {
+      r = (m_prefetch.empty() ? BrowseContent(m_browsedCount, m_bulkSize, n) : FetchContent(n));
+      if (r)
+        PrefetchContent();
+    }
     ++i; // On failure i becomes end
     return r;
   }
@@ -318,8 +466,31 @@ bool ContentList::BrowseContent(unsigned startingIndex, unsigned count, List::it
 {
   DBG(DBG_PROTO, "%s: browse %u from %u\n", __FUNCTION__, count, startingIndex);
   ElementList vars;
-  ElementList::const_iterator it;
-  if ((m_succeeded = m_service.Browse(m_root, startingIndex, count, vars)) && (it = vars.FindKey("Result")) != vars.end())
+  m_succeeded = m_service.Browse(m_root, startingIndex, count, vars);
+  return m_succeeded && ReadContent(startingIndex, vars, position);
+}
+
+bool ContentList::FetchContent(List::iterator position)
+{
+  Prefetch next = m_prefetch.front();
+  m_prefetch.pop_front();
+  if (next.first != m_browsedCount)
+  {
+    // the peer returned less than requested: the chunks in advance are
+    // misaligned, so restart from the current position
+    CancelPrefetch();
+    return BrowseContent(m_browsedCount, m_bulkSize, position);
+  }
+  DBG(DBG_PROTO, "%s: fetch %u from %u\n", __FUNCTION__, m_bulkSize, next.first);
+  const ElementList& vars = next.second->Wait();
+  m_succeeded = (!vars.empty() && vars[0]->compare("BrowseResponse") == 0);
+  return m_succeeded && ReadContent(next.first, vars, position);
+}
+
+bool ContentList::ReadContent(unsigned startingIndex, const ElementList& vars, List::iterator position)
+{
+  ElementList::const_iterator it = vars.FindKey("Result");
+  if (it != vars.end())
   {
     unsigned cnt = summarize(vars);
     // peer could return a valid result on out of range
@@ -338,6 +509,26 @@ bool ContentList::BrowseContent(unsigned startingIndex, unsigned count, List::it
   return false;
 }
 
+void ContentList::PrefetchContent()
+{
+  if (m_requestedCount < m_browsedCount)
+    m_requestedCount = m_browsedCount;
+  while (m_prefetch.size() < m_lookahead && m_requestedCount < m_totalCount)
+  {
+    DBG(DBG_PROTO, "%s: request %u from %u\n", __FUNCTION__, m_bulkSize, m_requestedCount);
+    m_prefetch.push_back(std::make_pair(m_requestedCount, m_service.BrowseAsync(m_root, m_requestedCount, m_bulkSize)));
+    m_requestedCount += m_bulkSize;
+  }
+}
+
+void ContentList::CancelPrefetch()
+{
+  for (Prefetch& p : m_prefetch)
+    p.second->Cancel();
+  m_prefetch.clear();
+  m_requestedCount = m_browsedCount;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ////
 //// ContentBrowser
@@ -28,11 +28,14 @@
 #include "subscriptionpool.h"
 #include "locked.h"
 
+#include <deque>
 #include <list>
 #include <vector>
 #include <stdint.h>
 
-#define BROWSE_COUNT  100
+#define BROWSE_COUNT        100
+#define BROWSE_CONCURRENCY  2     // Max chunks requested at once by BrowseAll
+#define BROWSE_ATTEMPTS     3     // Max loads of a content changing meanwhile
 
 namespace NSROOT
 {
@@ -60,6 +63,29 @@ namespace NSROOT
 
     bool Browse(const std::string& objectId, unsigned index, unsigned count, ElementList& vars);
 
+    /**
+     * Send the browse request without blocking the caller. The response is
+     * valid when its first element is tagged "BrowseResponse".
+     * @return the handle of the request
+     */
+    ServiceRequestPtr BrowseAsync(const std::string& objectId, unsigned index, unsigned count);
+
+    /**
+     * Load all the items of the container. Once the first chunk gives the
+     * total count, the next chunks are requested concurrently, and the items
+     * are assembled in order. The load restarts when the content changes
+     * meanwhile, i.e the update ID of a chunk differs.
+     * @param objectId the container to load
+     * @param items the list filled with the items
+     * @param concurrency the max count of chunks requested at once, it is
+     * clamped to the requests allowed in flight to a same host by the
+     * asynchronous client, which are shared with the other asynchronous
+     * calls to the player (see WSAsyncClient::SetHostConcurrency)
+     * @param updateID if not null, set with the update ID of the content
+     * @return true on success, else false
+     */
+    bool BrowseAll(const std::string& objectId, std::vector<DigitalItemPtr>& items, unsigned concurrency = BROWSE_CONCURRENCY, unsigned* updateID = nullptr);
+
     bool RefreshShareIndex();
 
     bool DestroyObject(const std::string& objectID);
@@ -151,8 +177,16 @@ namespace NSROOT
 
     friend class iterator;
   public:
-    ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize = BROWSE_COUNT);
-    ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize = BROWSE_COUNT);
+    /**
+     * The content is browsed by chunk of bulksize items, as the iterator
+     * reaches the end of the loaded items. With a lookahead, the next chunks
+     * are requested in background while the caller consumes the current one.
+     * @param bulksize the count of items of a chunk
+     * @param lookahead the count of chunks to request in advance, or 0
+     */
+    ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize = BROWSE_COUNT, unsigned lookahead = 0);
+    ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize = BROWSE_COUNT, unsigned lookahead = 0);
+    ~ContentList();
 
     class iterator
     {
@@ -191,12 +225,21 @@ namespace NSROOT
     unsigned m_bulkSize;
     std::string m_root;
     unsigned m_browsedCount;
+    unsigned m_lookahead;
+    unsigned m_requestedCount;
 
     List m_list;
 
+    typedef std::pair<unsigned, ServiceRequestPtr> Prefetch;
+    std::deque<Prefetch> m_prefetch;
+
     bool Next(List::iterator& i);
     bool Previous(List::iterator& i);
     bool BrowseContent(unsigned startingIndex, unsigned count, List::iterator position);
+    bool FetchContent(List::iterator position);
+    bool ReadContent(unsigned startingIndex, const ElementList& vars, List::iterator position);
+    void PrefetchContent();
+    void CancelPrefetch();
   };
 
   /////////////////////////////////////////////////////////////////////////////
@@ -36,7 +36,7 @@ DeviceProperties::DeviceProperties(const std::string& serviceHost, unsigned serv
 bool DeviceProperties::GetZoneInfo(ElementList& vars)
 {
   ElementList args;
-  vars = Request("GetZoneInfo", args);
+  vars = RequestCached("GetZoneInfo", args);
   if (!vars.empty() && vars[0]->compare("GetZoneInfoResponse") == 0)
     return true;
   return false;
@@ -45,7 +45,7 @@ bool DeviceProperties::GetZoneInfo(ElementList& vars)
 bool DeviceProperties::GetZoneAttributes(ElementList& vars)
 {
   ElementList args;
-  vars = Request("GetZoneAttributes", args);
+  vars = RequestCached("GetZoneAttributes", args);
   if (!vars.empty() && vars[0]->compare("GetZoneAttributesResponse") == 0)
     return true;
   return false;
@@ -54,7 +54,7 @@ bool DeviceProperties::GetZoneAttributes(ElementList& vars)
 bool DeviceProperties::GetHouseholdID(ElementList& vars)
 {
   ElementList args;
-  vars = Request("GetHouseholdID", args);
+  vars = RequestCached("GetHouseholdID", args);
   if (!vars.empty() && vars[0]->compare("GetHouseholdIDResponse") == 0)
     return true;
   return false;
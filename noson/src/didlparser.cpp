@@ -21,9 +21,13 @@
 #include "didlparser.h"
 #include "private/tinyxml2.h"
 #include "private/xmldict.h"
+#include "private/xmlpushparser.h"
 #include "private/debug.h"
 #include "private/cppdef.h"
 
+#include <cstring>
+#include <map>
+
 using namespace NSROOT;
 
 namespace NSROOT
@@ -40,13 +44,13 @@ namespace NSROOT
   static XMLDict DIDLDict = __initDIDLDict();
 }
 
-DIDLParser::DIDLParser(const char* document, unsigned reserve)
+DIDLParser::DIDLParser(const char* document, unsigned reserve, bool streaming)
 : m_document(document)
 , m_parsed(false)
 {
   if (reserve)
     m_items.reserve(reserve);
-  m_parsed = Parse();
+  m_parsed = (streaming ? ParseStream() : Parse());
 }
 
 const char* DIDLParser::KeyForNameSpace(const char* name)
@@ -114,3 +118,144 @@ bool DIDLParser::Parse()
   }
   return false;
 }
+
+namespace NSROOT
+{
+  /**
+   * Build the items while walking the document. It retains what the DOM
+   * parsing retains: the properties are the children of an item having a
+   * text, and the namespaces are learned from the root element.
+   */
+  class DIDLHandler : public XMLPushParser::Handler
+  {
+  public:
+    DIDLHandler(std::vector<DigitalItemPtr>& items)
+    : m_items(items), m_depth(0), m_root(false), m_inItem(false), m_inText(false) { }
+
+    bool IsValid() const { return m_root; }
+
+    virtual bool StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+    {
+      switch (m_depth++)
+      {
+      case 0:
+        if (!XMLNS::NameEqual(qname.c_str(), "DIDL-Lite"))
+          return false;
+        m_root = true;
+        // learn declared namespaces in the element the DIDL-Lite for translations
+        for (unsigned i = 0; i < count; ++i)
+        {
+          if (XMLNS::PrefixEqual(attrs[i].name.c_str(), "xmlns"))
+            m_names.AddXMLNS(XMLNS::LocalName(attrs[i].name.c_str()), attrs[i].value.c_str());
+          else if (XMLNS::NameEqual(attrs[i].name.c_str(), "xmlns"))
+            m_names.AddXMLNS("", attrs[i].value.c_str());
+        }
+        break;
+      case 1:
+        m_inItem = (XMLNS::NameEqual(qname.c_str(), "item") || XMLNS::NameEqual(qname.c_str(), "container"));
+        if (m_inItem)
+        {
+          const std::string* val;
+          val = XMLPushParser::FindAttribute("id", attrs, count);
+          m_id.assign(val ? *val : "-1");
+          val = XMLPushParser::FindAttribute("parentID", attrs, count);
+          m_parentID.assign(val ? *val : "-1");
+          val = XMLPushParser::FindAttribute("restricted", attrs, count);
+          m_restricted = (val && strncmp(val->c_str(), "true", 4) == 0);
+          m_vars.clear();
+        }
+        break;
+      case 2:
+        if (m_inItem)
+        {
+          // the text is appended in place
+          m_inText = true;
+          m_var.reset(new Element(TranslateQName(qname)));
+          for (unsigned i = 0; i < count; ++i)
+            m_var->SetAttribut(attrs[i].name, attrs[i].value);
+        }
+        break;
+      case 3:
+        // the text of the property ends with its first child
+        m_inText = false;
+        break;
+      default:
+        break;
+      }
+      return true;
+    }
+
+    virtual bool EndElement(const std::string& qname)
+    {
+      (void)qname;
+      switch (--m_depth)
+      {
+      case 1:
+        if (m_inItem)
+          m_items.push_back(DigitalItemPtr(new DigitalItem(m_id, m_parentID, m_restricted, m_vars)));
+        m_inItem = false;
+        break;
+      case 2:
+        if (m_inItem && m_var && HasText(*m_var))
+          m_vars.push_back(m_var);
+        m_var.reset();
+        m_inText = false;
+        break;
+      default:
+        break;
+      }
+      return true;
+    }
+
+    virtual bool CharData(const char* data, size_t len)
+    {
+      if (m_inText)
+        m_var->append(data, len);
+      return true;
+    }
+
+  private:
+    std::vector<DigitalItemPtr>& m_items;
+    unsigned m_depth;
+    bool m_root;
+    bool m_inItem;
+    bool m_inText;
+    XMLNames m_names;
+    std::map<std::string, std::string> m_keys; // the translated names
+    std::string m_id;
+    std::string m_parentID;
+    bool m_restricted = false;
+    ElementList m_vars;
+    ElementPtr m_var;
+
+    static bool HasText(const std::string& text)
+    {
+      // a blank text isn't retained by the DOM
+      for (char c : text)
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+          return true;
+      return false;
+    }
+
+    const std::string& TranslateQName(const std::string& qname)
+    {
+      std::map<std::string, std::string>::iterator it = m_keys.find(qname);
+      if (it == m_keys.end())
+        it = m_keys.insert(std::make_pair(qname, DIDLDict.TranslateQName(m_names, qname.c_str()))).first;
+      return it->second;
+    }
+  };
+}
+
+bool DIDLParser::ParseStream()
+{
+  m_items.clear();
+  DIDLHandler handler(m_items);
+  XMLPushParser parser(handler);
+  if (!parser.Feed(m_document, strlen(m_document)) || !parser.Finish() || !handler.IsValid())
+  {
+    m_items.clear();
+    return false;
+  }
+  return true;
+}
@@ -41,7 +41,14 @@ namespace NSROOT
   class DIDLParser
   {
   public:
-    DIDLParser(const char* document, unsigned reserve = 0);
+    /**
+     * Parse the DIDL-Lite document.
+     * @param document the document
+     * @param reserve the count of items to reserve, or 0
+     * @param streaming true to decode the document in one pass without
+     * building a tree, else it is parsed as a DOM; both give the same items
+     */
+    DIDLParser(const char* document, unsigned reserve = 0, bool streaming = true);
     virtual ~DIDLParser() {}
 
     bool IsValid() { return m_parsed; }
@@ -58,6 +65,7 @@ namespace NSROOT
     std::vector<DigitalItemPtr> m_items;
 
     bool Parse();
+    bool ParseStream();
 
   };
 }
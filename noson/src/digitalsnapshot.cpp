@@ -0,0 +1,333 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "digitalsnapshot.h"
+#include "contentdirectory.h"
+#include "private/debug.h"
+#include "private/os/os.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef __WINDOWS__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_MAGIC  0x3153444e  // "NDS1" in little endian
+
+using namespace NSROOT;
+
+DigitalSnapshot::Writer::Writer()
+{
+  // the offset 0 is the empty string
+  m_strings.push_back('\0');
+  m_index.insert(std::make_pair(std::string(), 0));
+}
+
+uint32_t DigitalSnapshot::Writer::Intern(const std::string& str)
+{
+  std::map<std::string, uint32_t>::iterator it = m_index.find(str);
+  if (it != m_index.end())
+    return it->second;
+  uint32_t offset = (uint32_t) m_strings.size();
+  // the strings are null terminated, so they can't contain a null char
+  m_strings.append(str.c_str()).push_back('\0');
+  m_index.insert(std::make_pair(str, offset));
+  return offset;
+}
+
+void DigitalSnapshot::Writer::Add(const DigitalItem& item)
+{
+  ItemRecord rec;
+  rec.objectID = Intern(item.GetObjectID());
+  rec.parentID = Intern(item.GetParentID());
+  rec.firstProp = (uint32_t) m_props.size();
+  rec.propCount = 0;
+  rec.type = (uint8_t) (item.IsContainer() ? DigitalItem::Type_container : item.IsItem() ? DigitalItem::Type_item : DigitalItem::Type_unknown);
+  rec.restricted = item.GetRestricted() ? 1 : 0;
+  std::vector<ElementPtr> vars = item.GetElements();
+  for (const ElementPtr& var : vars)
+  {
+    if (!var || rec.propCount == UINT16_MAX)
+      continue;
+    PropRecord prop;
+    prop.key = Intern(var->GetKey());
+    prop.value = Intern(*var);
+    prop.firstAttr = (uint32_t) m_attrs.size();
+    prop.attrCount = 0;
+    for (const Element& attr : var->Attributs())
+    {
+      AttrRecord a;
+      a.key = Intern(attr.GetKey());
+      a.value = Intern(attr);
+      m_attrs.push_back(a);
+      ++prop.attrCount;
+    }
+    m_props.push_back(prop);
+    ++rec.propCount;
+  }
+  m_items.push_back(rec);
+}
+
+void DigitalSnapshot::Writer::Add(const DigitalItemList& items)
+{
+  for (const DigitalItemPtr& item : items)
+    if (item)
+      Add(*item);
+}
+
+void DigitalSnapshot::Writer::Add(ContentList& list)
+{
+  for (ContentList::iterator it = list.begin(); it != list.end(); ++it)
+    if (*it)
+      Add(**it);
+}
+
+bool DigitalSnapshot::Writer::Save(const std::string& path) const
+{
+  Header header;
+  header.magic = SNAPSHOT_MAGIC;
+  header.itemCount = (uint32_t) m_items.size();
+  header.propCount = (uint32_t) m_props.size();
+  header.attrCount = (uint32_t) m_attrs.size();
+  header.stringSize = (uint32_t) m_strings.size();
+  // write the new file aside, then replace the old one which could be mapped
+  std::string tmp(path);
+  tmp.append(".tmp");
+  FILE * file = fopen(tmp.c_str(), "wb");
+  if (!file)
+  {
+    DBG(DBG_ERROR, "%s: cannot write file (%s)\n", __FUNCTION__, tmp.c_str());
+    return false;
+  }
+  bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+  if (ok && !m_items.empty())
+    ok = (fwrite(m_items.data(), sizeof(ItemRecord), m_items.size(), file) == m_items.size());
+  if (ok && !m_props.empty())
+    ok = (fwrite(m_props.data(), sizeof(PropRecord), m_props.size(), file) == m_props.size());
+  if (ok && !m_attrs.empty())
+    ok = (fwrite(m_attrs.data(), sizeof(AttrRecord), m_attrs.size(), file) == m_attrs.size());
+  if (ok)
+    ok = (fwrite(m_strings.data(), 1, m_strings.size(), file) == m_strings.size());
+  ok = (fclose(file) == 0) && ok;
+  if (ok && rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    // the target cannot be replaced on some platforms
+    remove(path.c_str());
+    ok = (rename(tmp.c_str(), path.c_str()) == 0);
+  }
+  if (!ok)
+  {
+    DBG(DBG_ERROR, "%s: cannot write snapshot (%s)\n", __FUNCTION__, path.c_str());
+    remove(tmp.c_str());
+  }
+  return ok;
+}
+
+const char * DigitalSnapshot::ItemView::GetPropertyKey(unsigned index) const
+{
+  if (index >= m_record->propCount)
+    return "";
+  return m_snapshot->String(Property(index)->key);
+}
+
+const char * DigitalSnapshot::ItemView::GetPropertyValue(unsigned index) const
+{
+  if (index >= m_record->propCount)
+    return "";
+  return m_snapshot->String(Property(index)->value);
+}
+
+const char * DigitalSnapshot::ItemView::GetValue(const char * key) const
+{
+  for (unsigned i = 0; i < m_record->propCount; ++i)
+  {
+    const PropRecord * prop = Property(i);
+    if (strcmp(m_snapshot->String(prop->key), key) == 0)
+      return m_snapshot->String(prop->value);
+  }
+  return "";
+}
+
+const char * DigitalSnapshot::ItemView::GetAttribut(const char * key, const char * name) const
+{
+  for (unsigned i = 0; i < m_record->propCount; ++i)
+  {
+    const PropRecord * prop = Property(i);
+    if (strcmp(m_snapshot->String(prop->key), key) != 0)
+      continue;
+    const AttrRecord * attr = m_snapshot->m_attrs + prop->firstAttr;
+    for (unsigned a = 0; a < prop->attrCount; ++a, ++attr)
+      if (strcmp(m_snapshot->String(attr->key), name) == 0)
+        return m_snapshot->String(attr->value);
+    break;
+  }
+  return "";
+}
+
+DigitalItemPtr DigitalSnapshot::ItemView::ToDigitalItem() const
+{
+  ElementList vars;
+  vars.reserve(m_record->propCount);
+  for (unsigned i = 0; i < m_record->propCount; ++i)
+  {
+    const PropRecord * prop = Property(i);
+    ElementPtr var(new Element(m_snapshot->String(prop->key), m_snapshot->String(prop->value)));
+    const AttrRecord * attr = m_snapshot->m_attrs + prop->firstAttr;
+    for (unsigned a = 0; a < prop->attrCount; ++a, ++attr)
+      var->SetAttribut(m_snapshot->String(attr->key), m_snapshot->String(attr->value));
+    vars.push_back(var);
+  }
+  return DigitalItemPtr(new DigitalItem(GetObjectID(), GetParentID(), GetRestricted(), vars));
+}
+
+DigitalSnapshot::DigitalSnapshot()
+: m_data(nullptr)
+, m_size(0)
+, m_mapped(false)
+, m_header(nullptr)
+, m_items(nullptr)
+, m_props(nullptr)
+, m_attrs(nullptr)
+, m_strings(nullptr)
+{
+}
+
+DigitalSnapshot::~DigitalSnapshot()
+{
+  Close();
+}
+
+bool DigitalSnapshot::Open(const std::string& path)
+{
+  Close();
+#ifdef __WINDOWS__
+  // no mapping: the file is loaded in memory
+  FILE * file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  std::string buf;
+  char chunk[16384];
+  size_t r;
+  while ((r = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    buf.append(chunk, r);
+  fclose(file);
+  if (buf.empty())
+    return false;
+  char * data = new char[buf.size()];
+  memcpy(data, buf.data(), buf.size());
+  m_data = data;
+  m_size = buf.size();
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    close(fd);
+    return false;
+  }
+  void * data = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    DBG(DBG_ERROR, "%s: cannot map file (%s)\n", __FUNCTION__, path.c_str());
+    return false;
+  }
+  m_data = static_cast<const char*>(data);
+  m_size = (size_t) st.st_size;
+  m_mapped = true;
+#endif
+  if (!Check())
+  {
+    DBG(DBG_ERROR, "%s: invalid snapshot (%s)\n", __FUNCTION__, path.c_str());
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void DigitalSnapshot::Close()
+{
+  if (m_data)
+  {
+#ifndef __WINDOWS__
+    if (m_mapped)
+      munmap(const_cast<char*>(m_data), m_size);
+    else
+#endif
+      delete [] m_data;
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+  m_header = nullptr;
+  m_items = nullptr;
+  m_props = nullptr;
+  m_attrs = nullptr;
+  m_strings = nullptr;
+}
+
+bool DigitalSnapshot::Check()
+{
+  // check the layout, then every reference, so the views need no check
+  if (m_size < sizeof(Header))
+    return false;
+  const Header * header = reinterpret_cast<const Header*>(m_data);
+  if (header->magic != SNAPSHOT_MAGIC)
+    return false;
+  uint64_t size = sizeof(Header) + (uint64_t) header->itemCount * sizeof(ItemRecord) +
+          (uint64_t) header->propCount * sizeof(PropRecord) + (uint64_t) header->attrCount * sizeof(AttrRecord);
+  if (header->stringSize == 0 || size + header->stringSize != m_size)
+    return false;
+  const ItemRecord * items = reinterpret_cast<const ItemRecord*>(m_data + sizeof(Header));
+  const PropRecord * props = reinterpret_cast<const PropRecord*>(items + header->itemCount);
+  const AttrRecord * attrs = reinterpret_cast<const AttrRecord*>(props + header->propCount);
+  const char * strings = reinterpret_cast<const char*>(attrs + header->attrCount);
+  if (strings[header->stringSize - 1] != '\0')
+    return false;
+  for (uint32_t i = 0; i < header->itemCount; ++i)
+  {
+    const ItemRecord& rec = items[i];
+    if (rec.objectID >= header->stringSize || rec.parentID >= header->stringSize ||
+            (uint64_t) rec.firstProp + rec.propCount > header->propCount)
+      return false;
+  }
+  for (uint32_t i = 0; i < header->propCount; ++i)
+  {
+    const PropRecord& prop = props[i];
+    if (prop.key >= header->stringSize || prop.value >= header->stringSize ||
+            (uint64_t) prop.firstAttr + prop.attrCount > header->attrCount)
+      return false;
+  }
+  for (uint32_t i = 0; i < header->attrCount; ++i)
+  {
+    if (attrs[i].key >= header->stringSize || attrs[i].value >= header->stringSize)
+      return false;
+  }
+  m_header = header;
+  m_items = items;
+  m_props = props;
+  m_attrs = attrs;
+  m_strings = strings;
+  return true;
+}
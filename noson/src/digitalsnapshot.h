@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DIGITALSNAPSHOT_H
+#define DIGITALSNAPSHOT_H
+
+#include "local_config.h"
+#include "digitalitem.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace NSROOT
+{
+  class ContentList;
+
+  /**
+   * The read-only snapshot of a collection of items. The file is made of a
+   * header, fixed-width records and a table of the strings, so it is mapped
+   * in memory as is. The items are viewed in place without allocation, and
+   * converted to DigitalItem only on demand.
+   * The records are in the byte order of the host that wrote the file: the
+   * snapshot of another byte order is rejected.
+   */
+  class DigitalSnapshot
+  {
+  public:
+    struct Header
+    {
+      uint32_t magic;
+      uint32_t itemCount;
+      uint32_t propCount;
+      uint32_t attrCount;
+      uint32_t stringSize;
+    };
+
+    struct ItemRecord
+    {
+      uint32_t objectID;
+      uint32_t parentID;
+      uint32_t firstProp;
+      uint16_t propCount;
+      uint8_t type;
+      uint8_t restricted;
+    };
+
+    struct PropRecord
+    {
+      uint32_t key;
+      uint32_t value;
+      uint32_t firstAttr;
+      uint32_t attrCount;
+    };
+
+    struct AttrRecord
+    {
+      uint32_t key;
+      uint32_t value;
+    };
+
+    /**
+     * Build the snapshot. The strings are shared in the table, so the keys
+     * and the repeated values are stored once.
+     */
+    class Writer
+    {
+    public:
+      Writer();
+      void Add(const DigitalItem& item);
+      void Add(const DigitalItemList& items);
+      void Add(ContentList& list);
+      /**
+       * Write the snapshot aside, then replace the file: a snapshot opened
+       * from the previous file remains valid.
+       */
+      bool Save(const std::string& path) const;
+      unsigned size() const { return (unsigned) m_items.size(); }
+    private:
+      std::vector<ItemRecord> m_items;
+      std::vector<PropRecord> m_props;
+      std::vector<AttrRecord> m_attrs;
+      std::string m_strings;
+      std::map<std::string, uint32_t> m_index;
+      uint32_t Intern(const std::string& str);
+    };
+
+    /**
+     * The view of an item in the snapshot. It is valid as long as the
+     * snapshot is open.
+     */
+    class ItemView
+    {
+    public:
+      ItemView(const DigitalSnapshot& snapshot, const ItemRecord& record) : m_snapshot(&snapshot), m_record(&record) { }
+
+      const char * GetObjectID() const { return m_snapshot->String(m_record->objectID); }
+
+      const char * GetParentID() const { return m_snapshot->String(m_record->parentID); }
+
+      bool GetRestricted() const { return m_record->restricted != 0; }
+
+      bool IsContainer() const { return m_record->type == DigitalItem::Type_container; }
+
+      bool IsItem() const { return m_record->type == DigitalItem::Type_item; }
+
+      unsigned GetPropertyCount() const { return m_record->propCount; }
+
+      const char * GetPropertyKey(unsigned index) const;
+
+      const char * GetPropertyValue(unsigned index) const;
+
+      /**
+       * @return the value of the first property with the key, else empty
+       */
+      const char * GetValue(const char * key) const;
+
+      /**
+       * @return the value of the attribute of the first property with the
+       * key, else empty
+       */
+      const char * GetAttribut(const char * key, const char * name) const;
+
+      /**
+       * @return the new item converted from the view
+       */
+      DigitalItemPtr ToDigitalItem() const;
+
+    private:
+      const DigitalSnapshot* m_snapshot;
+      const ItemRecord* m_record;
+      const PropRecord* Property(unsigned index) const { return m_snapshot->m_props + m_record->firstProp + index; }
+    };
+
+    class iterator
+    {
+    public:
+      iterator(const DigitalSnapshot& snapshot, unsigned index) : m_snapshot(&snapshot), m_index(index) { }
+      ItemView operator*() const { return (*m_snapshot)[m_index]; }
+      iterator& operator++() { ++m_index; return *this; }
+      bool operator==(const iterator& rhs) const { return rhs.m_index == m_index; }
+      bool operator!=(const iterator& rhs) const { return rhs.m_index != m_index; }
+    private:
+      const DigitalSnapshot* m_snapshot;
+      unsigned m_index;
+    };
+
+    DigitalSnapshot();
+    ~DigitalSnapshot();
+    DigitalSnapshot(const DigitalSnapshot&) = delete;
+    DigitalSnapshot& operator=(const DigitalSnapshot&) = delete;
+
+    /**
+     * Map the snapshot file in memory, and check its records.
+     * @param path the file of the snapshot
+     * @return true on success, else false
+     */
+    bool Open(const std::string& path);
+
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+
+    unsigned size() const { return m_header ? m_header->itemCount : 0; }
+
+    ItemView operator[](unsigned index) const { return ItemView(*this, m_items[index]); }
+
+    iterator begin() const { return iterator(*this, 0); }
+
+    iterator end() const { return iterator(*this, size()); }
+
+  private:
+    const char* m_data;
+    size_t m_size;
+    bool m_mapped;
+    const Header* m_header;
+    const ItemRecord* m_items;
+    const PropRecord* m_props;
+    const AttrRecord* m_attrs;
+    const char* m_strings;
+
+    const char * String(uint32_t offset) const { return m_strings + offset; }
+    bool Check();
+  };
+}
+
+#endif /* DIGITALSNAPSHOT_H */
@@ -49,13 +49,27 @@ namespace NSROOT
     std::string XML() const
     {
       std::string ret;
-      ret.append("<").append(m_key);
-      for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
-        ret.append(" ").append(it->m_key).append("=\"").append(it->XMLEncoded()).append("\"");
-      ret.append(">").append(XMLEncoded()).append("</").append(m_key).append(">");
+      AppendXML(ret);
       return ret;
     }
 
+    /**
+     * Append the XML of the element to the output, escaping in place.
+     */
+    void AppendXML(std::string& out) const
+    {
+      out.append("<").append(m_key);
+      for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
+      {
+        out.append(" ").append(it->m_key).append("=\"");
+        it->AppendXMLEncoded(out);
+        out.append("\"");
+      }
+      out.append(">");
+      AppendXMLEncoded(out);
+      out.append("</").append(m_key).append(">");
+    }
+
     std::string XML(const std::string& ns) const
     {
       if (ns.empty())
@@ -100,20 +114,42 @@ namespace NSROOT
     {
       std::string ret;
       ret.reserve(size());
+      AppendXMLEncoded(ret);
+      return ret;
+    }
+
+    /**
+     * Append the escaped value to the output. The size is counted first, so
+     * the output grows once and the value is escaped in place.
+     */
+    void AppendXMLEncoded(std::string& out) const
+    {
+      size_t len = size();
       for (std::string::const_iterator it = begin(); it != end(); ++it)
       {
-        if (*it == '&')
-          ret.append("&amp;");
-        else if (*it == '<')
-          ret.append("&lt;");
-        else if (*it == '>')
-          ret.append("&gt;");
-        else if (*it == '"')
-          ret.append("&quot;");
-        else
-          ret.push_back(*it);
+        switch (*it)
+        {
+        case '&': len += 4; break;
+        case '<':
+        case '>': len += 3; break;
+        case '"': len += 5; break;
+        default: break;
+        }
+      }
+      size_t pos = out.size();
+      out.resize(pos + len);
+      char * p = &out[pos];
+      for (std::string::const_iterator it = begin(); it != end(); ++it)
+      {
+        switch (*it)
+        {
+        case '&': memcpy(p, "&amp;", 5); p += 5; break;
+        case '<': memcpy(p, "&lt;", 4); p += 4; break;
+        case '>': memcpy(p, "&gt;", 4); p += 4; break;
+        case '"': memcpy(p, "&quot;", 6); p += 6; break;
+        default: *p++ = *it; break;
+        }
       }
-      return ret;
     }
 
   private:
@@ -22,22 +22,206 @@
 #include "private/upnpnotificationbroker.h"
 #include "private/mainpagebroker.h"
 #include "private/os/threads/threadpool.h"
+#include "private/os/threads/timeout.h"
 #include "private/socket.h"
 #include "private/cppdef.h"
 #include "private/builtin.h"
 #include "private/debug.h"
 #include "private/eventbroker.h"
+#include "private/requestrouter.h"
 #include "private/wsresponse.h"
 
 #include <vector>
 #include <map>
 #include <list>
+#include <ctime>
+
+#if HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #define EVENTHANDLER_LOOP_ADDRESS     "127.0.0.1"   // IPv4 localhost
 #define EVENTHANDLER_THREAD_KEEPALIVE 60000         // 60 sec
+#define EVENTHANDLER_POLL_EVENTS      64            // Max events per poll
+#define EVENTHANDLER_IDLE_TIMEOUT     5             // Idle connection timeout in seconds
+#define EVENTHANDLER_DISPATCH_BATCH   16            // Max messages delivered to a subscriber in a row
+#define EVENTHANDLER_ACCEPT_BACKOFF   100           // Pause after a failed accept in millisec
 
 using namespace NSROOT;
 
+///////////////////////////////////////////////////////////////////////////////
+////
+//// EventMessage
+////
+
+namespace
+{
+struct EventVarName
+{
+  const char * name;
+  EVENT_VAR_t key;
+};
+
+const EventVarName g_eventVarNames[] = {
+  { "TransportState", EVENT_VAR_TransportState },
+  { "CurrentPlayMode", EVENT_VAR_CurrentPlayMode },
+  { "CurrentCrossfadeMode", EVENT_VAR_CurrentCrossfadeMode },
+  { "NumberOfTracks", EVENT_VAR_NumberOfTracks },
+  { "CurrentTrack", EVENT_VAR_CurrentTrack },
+  { "CurrentSection", EVENT_VAR_CurrentSection },
+  { "CurrentTrackURI", EVENT_VAR_CurrentTrackURI },
+  { "CurrentTrackDuration", EVENT_VAR_CurrentTrackDuration },
+  { "CurrentTrackMetaData", EVENT_VAR_CurrentTrackMetaData },
+  { "r:NextTrackURI", EVENT_VAR_r_NextTrackURI },
+  { "r:NextTrackMetaData", EVENT_VAR_r_NextTrackMetaData },
+  { "r:EnqueuedTransportURI", EVENT_VAR_r_EnqueuedTransportURI },
+  { "r:EnqueuedTransportURIMetaData", EVENT_VAR_r_EnqueuedTransportURIMetaData },
+  { "PlaybackStorageMedium", EVENT_VAR_PlaybackStorageMedium },
+  { "AVTransportURI", EVENT_VAR_AVTransportURI },
+  { "AVTransportURIMetaData", EVENT_VAR_AVTransportURIMetaData },
+  { "NextAVTransportURI", EVENT_VAR_NextAVTransportURI },
+  { "NextAVTransportURIMetaData", EVENT_VAR_NextAVTransportURIMetaData },
+  { "CurrentTransportActions", EVENT_VAR_CurrentTransportActions },
+  { "r:CurrentValidPlayModes", EVENT_VAR_r_CurrentValidPlayModes },
+  { "r:MuseSessions", EVENT_VAR_r_MuseSessions },
+  { "TransportStatus", EVENT_VAR_TransportStatus },
+  { "r:SleepTimerGeneration", EVENT_VAR_r_SleepTimerGeneration },
+  { "r:AlarmRunning", EVENT_VAR_r_AlarmRunning },
+  { "r:AlarmIDRunning", EVENT_VAR_r_AlarmIDRunning },
+  { "r:AlarmLoggedStartTime", EVENT_VAR_r_AlarmLoggedStartTime },
+  { "r:AlarmState", EVENT_VAR_r_AlarmState },
+  { "r:SnoozeRunning", EVENT_VAR_r_SnoozeRunning },
+  { "r:RestartPending", EVENT_VAR_r_RestartPending },
+  { "PossiblePlaybackStorageMedia", EVENT_VAR_PossiblePlaybackStorageMedia },
+  { "Volume/Master", EVENT_VAR_Volume_Master },
+  { "Volume/LF", EVENT_VAR_Volume_LF },
+  { "Volume/RF", EVENT_VAR_Volume_RF },
+  { "Mute/Master", EVENT_VAR_Mute_Master },
+  { "Mute/LF", EVENT_VAR_Mute_LF },
+  { "Mute/RF", EVENT_VAR_Mute_RF },
+  { "NightMode", EVENT_VAR_NightMode },
+  { "SubGain", EVENT_VAR_SubGain },
+  { "Bass", EVENT_VAR_Bass },
+  { "Treble", EVENT_VAR_Treble },
+  { "OutputFixed", EVENT_VAR_OutputFixed },
+  { "Loudness/Master", EVENT_VAR_Loudness_Master },
+  { "VolumeDB/Master", EVENT_VAR_VolumeDB_Master },
+  { "VolumeDB/LF", EVENT_VAR_VolumeDB_LF },
+  { "VolumeDB/RF", EVENT_VAR_VolumeDB_RF },
+  { "AlarmListVersion", EVENT_VAR_AlarmListVersion },
+  { "DailyIndexRefreshTime", EVENT_VAR_DailyIndexRefreshTime },
+  { "DateFormat", EVENT_VAR_DateFormat },
+  { "TimeFormat", EVENT_VAR_TimeFormat },
+  { "TimeGeneration", EVENT_VAR_TimeGeneration },
+  { "TimeServer", EVENT_VAR_TimeServer },
+  { "TimeZone", EVENT_VAR_TimeZone },
+  { "SystemUpdateID", EVENT_VAR_SystemUpdateID },
+  { "ContainerUpdateIDs", EVENT_VAR_ContainerUpdateIDs },
+  { "UserRadioUpdateID", EVENT_VAR_UserRadioUpdateID },
+  { "SavedQueuesUpdateID", EVENT_VAR_SavedQueuesUpdateID },
+  { "ShareListUpdateID", EVENT_VAR_ShareListUpdateID },
+  { "RecentlyPlayedUpdateID", EVENT_VAR_RecentlyPlayedUpdateID },
+  { "RadioFavoritesUpdateID", EVENT_VAR_RadioFavoritesUpdateID },
+  { "RadioLocationUpdateID", EVENT_VAR_RadioLocationUpdateID },
+  { "FavoritesUpdateID", EVENT_VAR_FavoritesUpdateID },
+  { "FavoritePresetsUpdateID", EVENT_VAR_FavoritePresetsUpdateID },
+  { "ShareIndexInProgress", EVENT_VAR_ShareIndexInProgress },
+  { "ZoneGroupState", EVENT_VAR_ZoneGroupState },
+};
+
+static_assert(sizeof(g_eventVarNames) / sizeof(EventVarName) == EVENT_VAR_COUNT - 1,
+              "the table of names must define every variable");
+
+typedef std::map<std::string, EVENT_VAR_t> EventVarMap;
+
+const EventVarMap& eventVarMap()
+{
+  static EventVarMap map = []() {
+    EventVarMap m;
+    for (const EventVarName& e : g_eventVarNames)
+      m.insert(std::make_pair(std::string(e.name), e.key));
+    return m;
+  }();
+  return map;
+}
+}
+
+EVENT_VAR_t EventMessage::InternName(const std::string& name)
+{
+  const EventVarMap& map = eventVarMap();
+  EventVarMap::const_iterator it = map.find(name);
+  return (it != map.end() ? it->second : EVENT_VAR_UNKNOWN);
+}
+
+void EventMessage::Index()
+{
+  kind = PROPCHANGE_UNKNOWN;
+  seq = 0;
+  vars.clear();
+  if (event != EVENT_UPNP_PROPCHANGE || subject.size() < 3)
+    return;
+  string_to_uint32(subject[1].c_str(), &seq);
+  if (subject[2] == "PROPERTY")
+    kind = PROPCHANGE_PROPERTY;
+  else if (subject[2] == "RCS")
+    kind = PROPCHANGE_RCS;
+  else if (subject[2] == "AVT")
+    kind = PROPCHANGE_AVT;
+  vars.reserve((subject.size() - 3) / 2);
+  for (unsigned i = 3; i + 1 < subject.size(); i += 2)
+  {
+    EventVariable var;
+    var.key = InternName(subject[i]);
+    var.index = i;
+    vars.push_back(var);
+  }
+}
+
+EventMessage * EventMessage::Coalesce(const EventMessage& prev, const EventMessage& next)
+{
+  if (prev.event != EVENT_UPNP_PROPCHANGE || next.event != EVENT_UPNP_PROPCHANGE ||
+          (next.kind != PROPCHANGE_RCS && next.kind != PROPCHANGE_AVT) ||
+          prev.kind != next.kind || prev.SID() != next.SID())
+    return nullptr;
+  // keep the ordering of sequence
+  if (next.seq < prev.seq)
+    return nullptr;
+
+  EventMessage * msg = new EventMessage();
+  msg->event = next.event;
+  msg->subject.reserve(prev.subject.size() + next.subject.size() - 3);
+  msg->subject.push_back(next.subject[0]);
+  msg->subject.push_back(next.subject[1]);
+  msg->subject.push_back(next.subject[2]);
+  std::vector<bool> merged(next.vars.size(), false);
+  for (const EventVariable& pv : prev.vars)
+  {
+    msg->subject.push_back(prev.Name(pv));
+    const std::string * val = &prev.Value(pv);
+    for (size_t j = 0; j < next.vars.size(); ++j)
+    {
+      const EventVariable& nv = next.vars[j];
+      if (nv.key == pv.key && (pv.key != EVENT_VAR_UNKNOWN || next.Name(nv) == prev.Name(pv)))
+      {
+        merged[j] = true;
+        val = &next.Value(nv);
+        break;
+      }
+    }
+    msg->subject.push_back(*val);
+  }
+  for (size_t j = 0; j < next.vars.size(); ++j)
+  {
+    if (!merged[j])
+    {
+      msg->subject.push_back(next.Name(next.vars[j]));
+      msg->subject.push_back(next.Value(next.vars[j]));
+    }
+  }
+  msg->Index();
+  return msg;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ////
 //// EventHandlerThread
@@ -45,109 +229,183 @@ using namespace NSROOT;
 
 EventHandlerThread::EventHandlerThread(unsigned bindingPort)
 : m_port(bindingPort)
+, m_keepAliveTimeout(0)
+, m_keepAliveMax(0)
+, m_coalescingWindow(0)
 {
 }
 
+void EventHandlerThread::SetKeepAlive(unsigned timeout, unsigned maxRequests)
+{
+  m_keepAliveTimeout.store(timeout, std::memory_order_relaxed);
+  m_keepAliveMax.store(maxRequests, std::memory_order_relaxed);
+}
+
 EventHandlerThread::~EventHandlerThread()
 {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ////
-//// SubscriptionHandlerThread
+//// SubscriptionHandler
 ////
 
 namespace NSROOT
 {
-  class SubscriptionHandlerThread : private OS::Thread
+  /**
+   * The messages posted for a subscriber are queued, then delivered in order
+   * by the workers of the dispatcher pool. A queue is drained by one worker at
+   * once, and for a limited batch so that other subscribers are not held back.
+   */
+  class SubscriptionHandler
   {
   public:
-    SubscriptionHandlerThread(EventSubscriber *handle, unsigned subid);
-    virtual ~SubscriptionHandlerThread();
-    EventSubscriber *GetHandle() { return m_handle; }
-    bool IsRunning() { return OS::Thread::is_running(); }
-    void PostMessage(const EventMessagePtr& msg);
+    SubscriptionHandler(EventSubscriber *handle, unsigned subid, OS::ThreadPool& pool, LockedNumber<int>& depth);
+    virtual ~SubscriptionHandler();
+    EventSubscriber *GetHandle() const { return m_state->handle; }
+    void PostMessage(const EventMessagePtr& msg, unsigned coalescingWindow);
+    /**
+     * Drop the pending messages and stop the delivery. It returns once the
+     * running delivery is done, unless called by the subscriber itself.
+     */
+    void Revoke();
 
   private:
-    EventSubscriber *m_handle;
-    unsigned m_subId;
-    mutable OS::Mutex m_mutex;
-    OS::Event m_queueContent;
-    std::list<EventMessagePtr> m_msgQueue;
-
-    bool Start();
-    void Stop();
-    void *process();
+    struct State
+    {
+      EventSubscriber *handle;
+      unsigned subId;
+      OS::ThreadPool& pool;
+      LockedNumber<int>& depth;
+      OS::Mutex mutex;
+      OS::Condition<volatile bool> condition;
+      std::list<EventMessagePtr> msgQueue;
+      int64_t tailTime;       // the time the last message was queued
+      bool scheduled;         // a worker is in charge of the queue
+      bool revoked;
+      volatile bool idle;     // no delivery is running
+      OS::thread_t deliverer; // the thread of the running delivery
+
+      State(EventSubscriber *_handle, unsigned _subid, OS::ThreadPool& _pool, LockedNumber<int>& _depth)
+      : handle(_handle), subId(_subid), pool(_pool), depth(_depth)
+      , scheduled(false), revoked(false), idle(true), deliverer() { }
+    };
+
+    class Drain : public OS::Worker
+    {
+    public:
+      Drain(const SHARED_PTR<State>& state) : m_state(state) { }
+      virtual void process();
+    private:
+      SHARED_PTR<State> m_state;
+    };
+
+    SHARED_PTR<State> m_state;
+
+    static void Schedule(const SHARED_PTR<State>& state);
   };
 }
 
-SubscriptionHandlerThread::SubscriptionHandlerThread(EventSubscriber *handle, unsigned subid)
-: OS::Thread()
-, m_handle(handle)
-, m_subId(subid)
-, m_mutex()
-, m_queueContent()
-, m_msgQueue()
+SubscriptionHandler::SubscriptionHandler(EventSubscriber *handle, unsigned subid, OS::ThreadPool& pool, LockedNumber<int>& depth)
+: m_state(new State(handle, subid, pool, depth))
 {
-  if (m_handle && Start())
-    DBG(DBG_DEBUG, "%s: subscription is started (%p:%u)\n", __FUNCTION__, m_handle, m_subId);
-  else
-    DBG(DBG_ERROR, "%s: subscription failed (%p:%u)\n", __FUNCTION__, m_handle, m_subId);
+  DBG(DBG_DEBUG, "%s: subscription is started (%p:%u)\n", __FUNCTION__, handle, subid);
 }
 
-SubscriptionHandlerThread::~SubscriptionHandlerThread()
+SubscriptionHandler::~SubscriptionHandler()
 {
-  Stop();
-  m_handle = NULL;
+  Revoke();
 }
 
-bool SubscriptionHandlerThread::Start()
+void SubscriptionHandler::Revoke()
 {
-  if (OS::Thread::is_running())
-    return true;
-  return OS::Thread::start_thread();
+  State& st = *m_state;
+  OS::LockGuard lock(st.mutex);
+  if (!st.revoked)
+  {
+    st.revoked = true;
+    st.depth.Sub((int)st.msgQueue.size());
+    st.msgQueue.clear();
+    DBG(DBG_DEBUG, "%s: subscription is stopped (%p:%u)\n", __FUNCTION__, st.handle, st.subId);
+  }
+  // wait for the running delivery, unless the subscriber revokes itself
+  if (!st.idle && !OS::thread_equal(st.deliverer, OS::thread_self()))
+    st.condition.wait(st.mutex, st.idle);
 }
 
-void SubscriptionHandlerThread::Stop()
+void SubscriptionHandler::PostMessage(const EventMessagePtr& msg, unsigned coalescingWindow)
 {
-  if (OS::Thread::is_running())
+  // Critical section
+  OS::LockGuard lock(m_state->mutex);
+  if (m_state->revoked)
+    return;
+  int64_t now = OS::gettime_ms();
+  if (coalescingWindow > 0 && !m_state->msgQueue.empty() && now - m_state->tailTime < (int64_t)coalescingWindow)
   {
-    DBG(DBG_DEBUG, "%s: subscription thread (%p:%u)\n", __FUNCTION__, m_handle, m_subId);
-    // Set stopping. don't wait as we need to signal the thread first
-    OS::Thread::stop_thread(false);
-    m_queueContent.notify_one();
-    // Wait for thread to stop
-    OS::Thread::stop_thread(true);
-    DBG(DBG_DEBUG, "%s: subscription thread (%p:%u) stopped\n", __FUNCTION__, m_handle, m_subId);
+    // the subscriber is behind: merge with the pending update
+    EventMessage * merged = EventMessage::Coalesce(*m_state->msgQueue.back(), *msg);
+    if (merged)
+    {
+      DBG(DBG_PROTO, "%s: coalesce %s SEQ=%s (%p:%u)\n", __FUNCTION__, msg->subject[0].c_str(),
+          msg->subject[1].c_str(), m_state->handle, m_state->subId);
+      m_state->msgQueue.back() = EventMessagePtr(merged);
+      return;
+    }
+  }
+  m_state->msgQueue.push_back(msg);
+  m_state->tailTime = now;
+  m_state->depth.Add(1);
+  if (!m_state->scheduled)
+  {
+    m_state->scheduled = true;
+    Schedule(m_state);
   }
 }
 
-void SubscriptionHandlerThread::PostMessage(const EventMessagePtr& msg)
+void SubscriptionHandler::Schedule(const SHARED_PTR<State>& state)
 {
-  // Critical section
-  OS::LockGuard lock(m_mutex);
-  m_msgQueue.push_back(msg);
-  m_queueContent.notify_one();
+  Drain * worker = new Drain(state);
+  if (!state->pool.enqueue(worker))
+  {
+    DBG(DBG_WARN, "%s: dispatcher is stopped (%p:%u)\n", __FUNCTION__, state->handle, state->subId);
+    state->scheduled = false;
+    delete worker;
+  }
 }
 
-void *SubscriptionHandlerThread::process()
+void SubscriptionHandler::Drain::process()
 {
-  while (!is_stopped())
+  State& st = *m_state;
+  for (unsigned n = 0; n < EVENTHANDLER_DISPATCH_BATCH; ++n)
   {
-    while (!m_msgQueue.empty() && !is_stopped())
+    EventMessagePtr msg;
+    {
+      OS::LockGuard lock(st.mutex);
+      if (st.revoked || st.msgQueue.empty())
+      {
+        st.scheduled = false;
+        return;
+      }
+      msg = st.msgQueue.front();
+      st.msgQueue.pop_front();
+      st.depth.Sub(1);
+      st.idle = false;
+      st.deliverer = OS::thread_self();
+    }
+    // Do work
+    st.handle->HandleEventMessage(msg);
     {
-      // Critical section
-      m_mutex.lock();
-      EventMessagePtr msg = m_msgQueue.front();
-      m_msgQueue.pop_front();
-      m_mutex.unlock();
-      // Do work
-      m_handle->HandleEventMessage(msg);
+      OS::LockGuard lock(st.mutex);
+      st.idle = true;
+      st.condition.notify_all();
     }
-    // The tread is woken up by m_queueContent.Signal();
-    m_queueContent.wait();
   }
-  return NULL;
+  // the batch is done: requeue behind the other subscribers
+  OS::LockGuard lock(st.mutex);
+  if (st.revoked || st.msgQueue.empty())
+    st.scheduled = false;
+  else
+    Schedule(m_state);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -157,7 +415,7 @@ void *SubscriptionHandlerThread::process()
 
 namespace NSROOT
 {
-  class BasicEventHandler : public EventHandlerThread, private OS::Thread
+  class BasicEventHandler : public EventHandlerThread, private OS::Thread, private EventBroker::Poller
   {
   public:
     BasicEventHandler(unsigned bindingPort);
@@ -176,35 +434,82 @@ namespace NSROOT
     virtual void RevokeSubscription(unsigned subid);
     virtual void RevokeAllSubscriptions(EventSubscriber *sub);
     virtual void DispatchEvent(const EventMessagePtr& msg);
+    virtual unsigned GetDispatcherThreadCount();
+    virtual unsigned GetDispatcherQueueDepth();
 
   private:
-    OS::Mutex m_mutex;
+    OS::Mutex m_mutex;  // serialize the changes of the subscription table
+
+    // About connections awaiting the request
+    struct PendingConnection
+    {
+      SHARED_PTR<TcpSocket> sockPtr;
+      unsigned count;
+      time_t deadline;
+    };
+    typedef std::map<net_socket_t, PendingConnection> pendingConnections_t;
+    pendingConnections_t m_pending;
+    OS::Mutex m_pendingLock;
+    int m_pollfd;
+
+    // the workers use the router, so it must outlive the pools
+    RequestRouter m_router;
+    LockedNumber<int> m_dispatchDepth;
+    OS::ThreadPool m_dispatchpool;
     OS::ThreadPool m_threadpool;
+    OS::ThreadPool m_streampool;
     TcpServerSocket *m_socket;
 
-    // About subscriptions
-    typedef std::map<EVENT_t, std::list<unsigned> > subscriptionsByEvent_t;
-    subscriptionsByEvent_t m_subscriptionsByEvent;
-    typedef std::map<unsigned, SubscriptionHandlerThread*> subscriptions_t;
-    subscriptions_t m_subscriptions;
+    // About subscriptions: the table is immutable. It is replaced on change,
+    // so the dispatch reads a snapshot and never waits for a change.
+    typedef SHARED_PTR<SubscriptionHandler> SubscriptionHandlerPtr;
+    struct SubscriptionTable
+    {
+      typedef std::map<unsigned, SubscriptionHandlerPtr> subscriptions_t;
+      typedef std::vector<SubscriptionHandlerPtr> handlers_t;
+      subscriptions_t subscriptions;
+      handlers_t byEvent[EVENT_UNKNOWN + 1];
+    };
+    typedef SHARED_PTR<const SubscriptionTable> SubscriptionTablePtr;
+    Locked<SubscriptionTablePtr> m_table;
+
+    void PublishTable(SubscriptionTable * table);
+    void RevokeHandlers(const std::vector<SubscriptionHandlerPtr>& handlers);
 
     virtual void* process(void);
+    bool ProcessAccept();
+    bool ProcessReactor();
+    bool PollConnection(SHARED_PTR<TcpSocket>& sockPtr, unsigned count, unsigned timeout);
     void AnnounceStatus(const char *status);
 
+    // Implements EventBroker::Poller
+    virtual bool AwaitRequest(SHARED_PTR<TcpSocket>& sockPtr, unsigned count);
+
     typedef std::map<std::string, RequestBrokerPtr> RBList;
     Locked<RBList> m_RBList;
+
+    void UpdateRouter(const RBList& list);
   };
 }
 
 BasicEventHandler::BasicEventHandler(unsigned bindingPort)
 : EventHandlerThread(bindingPort), OS::Thread()
+, m_pollfd(-1)
+, m_dispatchDepth(0)
 , m_socket(new TcpServerSocket)
+, m_table(SubscriptionTablePtr(new SubscriptionTable()))
 , m_RBList(RBList())
 {
   m_listenerAddress = EVENTHANDLER_LOOP_ADDRESS;
   m_threadpool.set_max_size(EVENTHANDLER_THREADS);
   m_threadpool.set_keep_alive(EVENTHANDLER_THREAD_KEEPALIVE);
   m_threadpool.start();
+  m_streampool.set_max_size(EVENTHANDLER_STREAM_THREADS);
+  m_streampool.set_keep_alive(EVENTHANDLER_THREAD_KEEPALIVE);
+  m_streampool.start();
+  m_dispatchpool.set_max_size(EVENTHANDLER_DISPATCH_THREADS);
+  m_dispatchpool.set_keep_alive(EVENTHANDLER_THREAD_KEEPALIVE);
+  m_dispatchpool.start();
 }
 
 BasicEventHandler::~BasicEventHandler()
@@ -212,12 +517,15 @@ BasicEventHandler::~BasicEventHandler()
   Stop();
   UnregisterAllRequestBroker();
   m_threadpool.suspend();
+  m_streampool.suspend();
   {
     OS::LockGuard lock(m_mutex);
-    for (subscriptions_t::iterator it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it)
-      delete it->second;
-    m_subscriptions.clear();
-    m_subscriptionsByEvent.clear();
+    std::vector<SubscriptionHandlerPtr> handlers;
+    SubscriptionTablePtr table = m_table.Load();
+    for (const SubscriptionTable::subscriptions_t::value_type& e : table->subscriptions)
+      handlers.push_back(e.second);
+    PublishTable(new SubscriptionTable());
+    RevokeHandlers(handlers);
   }
   SAFE_DELETE(m_socket);
 }
@@ -249,7 +557,9 @@ void BasicEventHandler::RegisterRequestBroker(RequestBrokerPtr rb)
   if (!rb)
     return;
   DBG(DBG_DEBUG, "%s: register (%s)\n", __FUNCTION__, rb->CommonName());
-  m_RBList.Get()->insert(std::make_pair(rb->CommonName(), rb));
+  Locked<RBList>::pointer p = m_RBList.Get();
+  if (p->insert(std::make_pair(rb->CommonName(), rb)).second)
+    UpdateRouter(*p);
 }
 
 void BasicEventHandler::UnregisterRequestBroker(const std::string &name)
@@ -261,6 +571,7 @@ void BasicEventHandler::UnregisterRequestBroker(const std::string &name)
   {
     it->second->Abort();
     p->erase(it);
+    UpdateRouter(*p);
   }
 }
 
@@ -273,6 +584,7 @@ void BasicEventHandler::UnregisterAllRequestBroker()
     it->second->Abort();
   }
   p->clear();
+  UpdateRouter(*p);
 }
 
 RequestBrokerPtr BasicEventHandler::GetRequestBroker(const std::string &name)
@@ -294,87 +606,152 @@ std::vector<RequestBrokerPtr> BasicEventHandler::AllRequestBroker()
   return vect;
 }
 
+void BasicEventHandler::UpdateRouter(const RBList& list)
+{
+  std::vector<RequestBrokerPtr> vect;
+  vect.reserve(list.size());
+  for (RBList::const_iterator it = list.begin(); it != list.end(); ++it)
+    vect.push_back(it->second);
+  m_router.Update(vect);
+}
+
+void BasicEventHandler::PublishTable(SubscriptionTable * table)
+{
+  // the replaced table is released out of the lock
+  SubscriptionTablePtr old = m_table.Load();
+  m_table.Store(SubscriptionTablePtr(table));
+}
+
+void BasicEventHandler::RevokeHandlers(const std::vector<SubscriptionHandlerPtr>& handlers)
+{
+  // a dispatch could still hold the old table: the revoked handlers ignore
+  // the messages it posts
+  for (const SubscriptionHandlerPtr& handler : handlers)
+    handler->Revoke();
+}
+
 unsigned BasicEventHandler::CreateSubscription(EventSubscriber* sub)
 {
   unsigned id = 0;
   OS::LockGuard lock(m_mutex);
-  subscriptions_t::const_reverse_iterator it = m_subscriptions.rbegin();
-  if (it != m_subscriptions.rend())
+  SubscriptionTablePtr table = m_table.Load();
+  SubscriptionTable::subscriptions_t::const_reverse_iterator it = table->subscriptions.rbegin();
+  if (it != table->subscriptions.rend())
     id = it->first;
-  SubscriptionHandlerThread *handler = new SubscriptionHandlerThread(sub, ++id);
-  if (handler->IsRunning())
+  if (!sub)
   {
-    m_subscriptions.insert(std::make_pair(id, handler));
-    return id;
+    DBG(DBG_ERROR, "%s: subscription failed (%p:%u)\n", __FUNCTION__, sub, id + 1);
+    return 0;
   }
-  // Handler didn't start
-  delete handler;
-  return 0;
+  ++id;
+  SubscriptionTable * next = new SubscriptionTable(*table);
+  next->subscriptions.insert(std::make_pair(id,
+          SubscriptionHandlerPtr(new SubscriptionHandler(sub, id, m_dispatchpool, m_dispatchDepth))));
+  PublishTable(next);
+  return id;
 }
 
 bool BasicEventHandler::SubscribeForEvent(unsigned subid, EVENT_t event)
 {
+  if (event > EVENT_UNKNOWN)
+    return false;
   OS::LockGuard lock(m_mutex);
+  SubscriptionTablePtr table = m_table.Load();
   // Only for registered subscriber
-  subscriptions_t::const_iterator it1 = m_subscriptions.find(subid);
-  if (it1 == m_subscriptions.end())
+  SubscriptionTable::subscriptions_t::const_iterator it = table->subscriptions.find(subid);
+  if (it == table->subscriptions.end())
     return false;
-  std::list<unsigned>::const_iterator it2 = m_subscriptionsByEvent[event].begin();
-  while (it2 != m_subscriptionsByEvent[event].end())
+  for (const SubscriptionHandlerPtr& handler : table->byEvent[event])
   {
-    if (*it2 == subid)
+    if (handler.get() == it->second.get())
       return true;
-    ++it2;
   }
-  m_subscriptionsByEvent[event].push_back(subid);
+  SubscriptionTable * next = new SubscriptionTable(*table);
+  next->byEvent[event].push_back(it->second);
+  PublishTable(next);
   return true;
 }
 
 void BasicEventHandler::RevokeSubscription(unsigned subid)
 {
-  OS::LockGuard lock(m_mutex);
-  subscriptions_t::iterator it;
-  it = m_subscriptions.find(subid);
-  if (it != m_subscriptions.end())
+  std::vector<SubscriptionHandlerPtr> revoked;
   {
-    delete it->second;
-    m_subscriptions.erase(it);
+    OS::LockGuard lock(m_mutex);
+    SubscriptionTablePtr table = m_table.Load();
+    SubscriptionTable::subscriptions_t::const_iterator it = table->subscriptions.find(subid);
+    if (it == table->subscriptions.end())
+      return;
+    revoked.push_back(it->second);
+    SubscriptionTable * next = new SubscriptionTable();
+    for (const SubscriptionTable::subscriptions_t::value_type& e : table->subscriptions)
+    {
+      if (e.first != subid)
+        next->subscriptions.insert(e);
+    }
+    for (int event = 0; event <= EVENT_UNKNOWN; ++event)
+    {
+      for (const SubscriptionHandlerPtr& handler : table->byEvent[event])
+      {
+        if (handler.get() != it->second.get())
+          next->byEvent[event].push_back(handler);
+      }
+    }
+    PublishTable(next);
   }
+  RevokeHandlers(revoked);
 }
 
 void BasicEventHandler::RevokeAllSubscriptions(EventSubscriber *sub)
 {
-  OS::LockGuard lock(m_mutex);
-  std::vector<subscriptions_t::iterator> its;
-  for (subscriptions_t::iterator it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it)
+  std::vector<SubscriptionHandlerPtr> revoked;
   {
-    if (sub == it->second->GetHandle())
-      its.push_back(it);
-  }
-  for (std::vector<subscriptions_t::iterator>::const_iterator it = its.begin(); it != its.end(); ++it)
-  {
-    delete (*it)->second;
-    m_subscriptions.erase(*it);
+    OS::LockGuard lock(m_mutex);
+    SubscriptionTablePtr table = m_table.Load();
+    SubscriptionTable * next = new SubscriptionTable();
+    for (const SubscriptionTable::subscriptions_t::value_type& e : table->subscriptions)
+    {
+      if (sub == e.second->GetHandle())
+        revoked.push_back(e.second);
+      else
+        next->subscriptions.insert(e);
+    }
+    if (revoked.empty())
+    {
+      delete next;
+      return;
+    }
+    for (int event = 0; event <= EVENT_UNKNOWN; ++event)
+    {
+      for (const SubscriptionHandlerPtr& handler : table->byEvent[event])
+      {
+        if (sub != handler->GetHandle())
+          next->byEvent[event].push_back(handler);
+      }
+    }
+    PublishTable(next);
   }
+  RevokeHandlers(revoked);
 }
 
 void BasicEventHandler::DispatchEvent(const EventMessagePtr& msg)
 {
-  OS::LockGuard lock(m_mutex);
-  std::vector<std::list<unsigned>::iterator> revoked;
-  std::list<unsigned>::iterator it1 = m_subscriptionsByEvent[msg->event].begin();
-  while (it1 != m_subscriptionsByEvent[msg->event].end())
-  {
-    subscriptions_t::const_iterator it2 = m_subscriptions.find(*it1);
-    if (it2 != m_subscriptions.end())
-      it2->second->PostMessage(msg);
-    else
-      revoked.push_back(it1);
-    ++it1;
-  }
-  std::vector<std::list<unsigned>::iterator>::const_iterator itr;
-  for (itr = revoked.begin(); itr != revoked.end(); ++itr)
-    m_subscriptionsByEvent[msg->event].erase(*itr);
+  if (msg->event > EVENT_UNKNOWN)
+    return;
+  SubscriptionTablePtr table = m_table.Load();
+  unsigned window = GetCoalescingWindow();
+  for (const SubscriptionHandlerPtr& handler : table->byEvent[msg->event])
+    handler->PostMessage(msg, window);
+}
+
+unsigned BasicEventHandler::GetDispatcherThreadCount()
+{
+  return m_dispatchpool.size();
+}
+
+unsigned BasicEventHandler::GetDispatcherQueueDepth()
+{
+  int depth = m_dispatchDepth.Load();
+  return (depth > 0 ? (unsigned)depth : 0);
 }
 
 void *BasicEventHandler::process()
@@ -398,29 +775,13 @@ void *BasicEventHandler::process()
   if (bound)
   {
     AnnounceStatus(EVENTHANDLER_STARTED);
-    while (!OS::Thread::is_stopped())
-    {
-      SHARED_PTR<TcpSocket> sockPtr(new TcpSocket);
-      TcpServerSocket::AcceptStatus r = m_socket->AcceptConnection(*sockPtr, 1);
-      if (r == TcpServerSocket::ACCEPT_SUCCESS)
-      {
-        DBG(DBG_DEBUG, "%s: accepting new connection\n", __FUNCTION__);
-        EventBroker* eb = new EventBroker(this, sockPtr);
-        m_threadpool.enqueue(eb);
-        continue;
-      }
-      if (r == TcpServerSocket::ACCEPT_FAILURE)
-      {
-        DBG(DBG_WARN, "%s: accept failed (%d)\n", __FUNCTION__, m_socket->GetErrNo());
-        continue;
-      }
-      if (r == TcpServerSocket::ACCEPT_TIMEOUT)
-      {
-        continue;
-      }
+#if HAVE_EPOLL
+    bound = ProcessReactor();
+#else
+    bound = ProcessAccept();
+#endif
+    if (!bound)
       AnnounceStatus(EVENTHANDLER_FAILED);
-      break;
-    }
     AnnounceStatus(EVENTHANDLER_STOPPED);
   }
   else
@@ -433,6 +794,189 @@ void *BasicEventHandler::process()
   return NULL;
 }
 
+bool BasicEventHandler::ProcessAccept()
+{
+  while (!OS::Thread::is_stopped())
+  {
+    SHARED_PTR<TcpSocket> sockPtr(new TcpSocket);
+    TcpServerSocket::AcceptStatus r = m_socket->AcceptConnection(*sockPtr, 1);
+    if (r == TcpServerSocket::ACCEPT_SUCCESS)
+    {
+      DBG(DBG_DEBUG, "%s: accepting new connection\n", __FUNCTION__);
+      EventBroker* eb = new EventBroker(this, &m_router, sockPtr, &m_streampool, this);
+      m_threadpool.enqueue(eb);
+      continue;
+    }
+    if (r == TcpServerSocket::ACCEPT_FAILURE)
+    {
+      DBG(DBG_WARN, "%s: accept failed (%d)\n", __FUNCTION__, m_socket->GetErrNo());
+      continue;
+    }
+    if (r == TcpServerSocket::ACCEPT_TIMEOUT)
+    {
+      continue;
+    }
+    return false;
+  }
+  return true;
+}
+
+namespace NSROOT
+{
+  class IdleConnectionCloser : public OS::Worker
+  {
+  public:
+    IdleConnectionCloser(SHARED_PTR<TcpSocket>& sockPtr) : m_sockPtr(sockPtr) { }
+    virtual void process() { m_sockPtr->Disconnect(); }
+  private:
+    SHARED_PTR<TcpSocket> m_sockPtr;
+  };
+}
+
+#if HAVE_EPOLL
+bool BasicEventHandler::ProcessReactor()
+{
+  int efd = epoll_create1(EPOLL_CLOEXEC);
+  if (efd < 0)
+  {
+    DBG(DBG_WARN, "%s: epoll is not available (%d)\n", __FUNCTION__, errno);
+    return ProcessAccept();
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = m_socket->GetHandle();
+  if (epoll_ctl(efd, EPOLL_CTL_ADD, m_socket->GetHandle(), &ev) != 0)
+  {
+    DBG(DBG_WARN, "%s: epoll control failed (%d)\n", __FUNCTION__, errno);
+    close(efd);
+    return ProcessAccept();
+  }
+  m_pendingLock.lock();
+  m_pollfd = efd;
+  m_pendingLock.unlock();
+
+  struct epoll_event events[EVENTHANDLER_POLL_EVENTS];
+  bool ret = true;
+  while (!OS::Thread::is_stopped())
+  {
+    int n = epoll_wait(efd, events, EVENTHANDLER_POLL_EVENTS, 1000);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      DBG(DBG_ERROR, "%s: epoll wait failed (%d)\n", __FUNCTION__, errno);
+      ret = false;
+      break;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      if (events[i].data.fd == m_socket->GetHandle())
+      {
+        // accept all the pending connections
+        for (;;)
+        {
+          SHARED_PTR<TcpSocket> sockPtr(new TcpSocket);
+          TcpServerSocket::AcceptStatus r = m_socket->AcceptConnection(*sockPtr, 0);
+          if (r == TcpServerSocket::ACCEPT_SUCCESS)
+          {
+            DBG(DBG_DEBUG, "%s: accepting new connection\n", __FUNCTION__);
+            if (!PollConnection(sockPtr, 0, EVENTHANDLER_IDLE_TIMEOUT))
+              // the worker will await the request
+              m_threadpool.enqueue(new EventBroker(this, &m_router, sockPtr, &m_streampool, this));
+            continue;
+          }
+          if (r == TcpServerSocket::ACCEPT_FAILURE)
+          {
+            // i.e out of descriptors: the socket remains readable, so back
+            // off until the next poll rather than retrying at once
+            DBG(DBG_WARN, "%s: accept failed (%d)\n", __FUNCTION__, m_socket->GetErrNo());
+            OS::Thread::pause(EVENTHANDLER_ACCEPT_BACKOFF);
+            break;
+          }
+          if (r == TcpServerSocket::ACCEPT_ERROR)
+            ret = false;
+          break;
+        }
+        if (!ret)
+          break;
+        continue;
+      }
+      // the request is incoming, so process it
+      OS::LockGuard lock(m_pendingLock);
+      pendingConnections_t::iterator it = m_pending.find(events[i].data.fd);
+      if (it != m_pending.end())
+      {
+        epoll_ctl(efd, EPOLL_CTL_DEL, it->first, NULL);
+        m_threadpool.enqueue(new EventBroker(this, &m_router, it->second.sockPtr, &m_streampool, this, it->second.count));
+        m_pending.erase(it);
+      }
+    }
+    if (!ret)
+      break;
+    // close idle connections
+    time_t now = time(NULL);
+    OS::LockGuard lock(m_pendingLock);
+    pendingConnections_t::iterator it = m_pending.begin();
+    while (it != m_pending.end())
+    {
+      if (it->second.deadline <= now)
+      {
+        DBG(DBG_DEBUG, "%s: closing idle connection\n", __FUNCTION__);
+        epoll_ctl(efd, EPOLL_CTL_DEL, it->first, NULL);
+        m_threadpool.enqueue(new IdleConnectionCloser(it->second.sockPtr));
+        m_pending.erase(it++);
+      }
+      else
+        ++it;
+    }
+  }
+  OS::LockGuard lock(m_pendingLock);
+  m_pending.clear();
+  m_pollfd = -1;
+  close(efd);
+  return ret;
+}
+
+bool BasicEventHandler::PollConnection(SHARED_PTR<TcpSocket>& sockPtr, unsigned count, unsigned timeout)
+{
+  OS::LockGuard lock(m_pendingLock);
+  if (m_pollfd < 0)
+    return false;
+  PendingConnection& p = m_pending[sockPtr->GetHandle()];
+  p.sockPtr = sockPtr;
+  p.count = count;
+  p.deadline = time(NULL) + timeout;
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.fd = sockPtr->GetHandle();
+  if (epoll_ctl(m_pollfd, EPOLL_CTL_ADD, sockPtr->GetHandle(), &ev) == 0)
+    return true;
+  m_pending.erase(sockPtr->GetHandle());
+  return false;
+}
+#else
+bool BasicEventHandler::ProcessReactor()
+{
+  return ProcessAccept();
+}
+
+bool BasicEventHandler::PollConnection(SHARED_PTR<TcpSocket>& sockPtr, unsigned count, unsigned timeout)
+{
+  (void)sockPtr;
+  (void)count;
+  (void)timeout;
+  return false;
+}
+#endif
+
+bool BasicEventHandler::AwaitRequest(SHARED_PTR<TcpSocket>& sockPtr, unsigned count)
+{
+  return PollConnection(sockPtr, count, GetKeepAliveTimeout());
+}
+
 void BasicEventHandler::AnnounceStatus(const char *status)
 {
   DBG(DBG_DEBUG, "%s: (%p) %s\n", __FUNCTION__, this, status);
@@ -28,11 +28,17 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <atomic>
 
 #define EVENTHANDLER_STARTED        "STARTED"   // Message on started
 #define EVENTHANDLER_STOPPED        "STOPPED"   // Message on stopped
 #define EVENTHANDLER_FAILED         "FAILED"    // Message on failed
 #define EVENTHANDLER_THREADS        16          // Max worker threads
+#define EVENTHANDLER_STREAM_THREADS 8           // Max workers for streaming brokers
+#define EVENTHANDLER_DISPATCH_THREADS 4         // Max workers delivering messages to subscribers
+#define EVENTHANDLER_KEEPALIVE_MAX  100         // Default max requests per connection
+#define EVENTHANDLER_COALESCING_WINDOW 250      // Default window to merge property updates in millisec
 
 namespace NSROOT
 {
@@ -44,14 +50,140 @@ namespace NSROOT
     EVENT_UNKNOWN,
   } EVENT_t;
 
+  /**
+   * The content of an UPnP property change:
+   * subject = [ SID, SEQ, "PROPERTY"|"RCS"|"AVT", name1, val1, name2, val2, ... ]
+   */
+  typedef enum
+  {
+    PROPCHANGE_UNKNOWN = 0,
+    PROPCHANGE_PROPERTY,          // plain property set
+    PROPCHANGE_RCS,               // LastChange of the rendering control
+    PROPCHANGE_AVT,               // LastChange of the AV transport
+  } PROPCHANGE_t;
+
+  /**
+   * The known variables of the UPnP property changes. A subscriber can switch
+   * on the key in place of comparing the names.
+   */
+  typedef enum
+  {
+    EVENT_VAR_UNKNOWN = 0,
+    // AVT
+    EVENT_VAR_TransportState,
+    EVENT_VAR_CurrentPlayMode,
+    EVENT_VAR_CurrentCrossfadeMode,
+    EVENT_VAR_NumberOfTracks,
+    EVENT_VAR_CurrentTrack,
+    EVENT_VAR_CurrentSection,
+    EVENT_VAR_CurrentTrackURI,
+    EVENT_VAR_CurrentTrackDuration,
+    EVENT_VAR_CurrentTrackMetaData,
+    EVENT_VAR_r_NextTrackURI,
+    EVENT_VAR_r_NextTrackMetaData,
+    EVENT_VAR_r_EnqueuedTransportURI,
+    EVENT_VAR_r_EnqueuedTransportURIMetaData,
+    EVENT_VAR_PlaybackStorageMedium,
+    EVENT_VAR_AVTransportURI,
+    EVENT_VAR_AVTransportURIMetaData,
+    EVENT_VAR_NextAVTransportURI,
+    EVENT_VAR_NextAVTransportURIMetaData,
+    EVENT_VAR_CurrentTransportActions,
+    EVENT_VAR_r_CurrentValidPlayModes,
+    EVENT_VAR_r_MuseSessions,
+    EVENT_VAR_TransportStatus,
+    EVENT_VAR_r_SleepTimerGeneration,
+    EVENT_VAR_r_AlarmRunning,
+    EVENT_VAR_r_AlarmIDRunning,
+    EVENT_VAR_r_AlarmLoggedStartTime,
+    EVENT_VAR_r_AlarmState,
+    EVENT_VAR_r_SnoozeRunning,
+    EVENT_VAR_r_RestartPending,
+    EVENT_VAR_PossiblePlaybackStorageMedia,
+    // RCS
+    EVENT_VAR_Volume_Master,
+    EVENT_VAR_Volume_LF,
+    EVENT_VAR_Volume_RF,
+    EVENT_VAR_Mute_Master,
+    EVENT_VAR_Mute_LF,
+    EVENT_VAR_Mute_RF,
+    EVENT_VAR_NightMode,
+    EVENT_VAR_SubGain,
+    EVENT_VAR_Bass,
+    EVENT_VAR_Treble,
+    EVENT_VAR_OutputFixed,
+    EVENT_VAR_Loudness_Master,
+    EVENT_VAR_VolumeDB_Master,
+    EVENT_VAR_VolumeDB_LF,
+    EVENT_VAR_VolumeDB_RF,
+    // AlarmClock
+    EVENT_VAR_AlarmListVersion,
+    EVENT_VAR_DailyIndexRefreshTime,
+    EVENT_VAR_DateFormat,
+    EVENT_VAR_TimeFormat,
+    EVENT_VAR_TimeGeneration,
+    EVENT_VAR_TimeServer,
+    EVENT_VAR_TimeZone,
+    // ContentDirectory
+    EVENT_VAR_SystemUpdateID,
+    EVENT_VAR_ContainerUpdateIDs,
+    EVENT_VAR_UserRadioUpdateID,
+    EVENT_VAR_SavedQueuesUpdateID,
+    EVENT_VAR_ShareListUpdateID,
+    EVENT_VAR_RecentlyPlayedUpdateID,
+    EVENT_VAR_RadioFavoritesUpdateID,
+    EVENT_VAR_RadioLocationUpdateID,
+    EVENT_VAR_FavoritesUpdateID,
+    EVENT_VAR_FavoritePresetsUpdateID,
+    EVENT_VAR_ShareIndexInProgress,
+    // ZoneGroupTopology
+    EVENT_VAR_ZoneGroupState,
+    EVENT_VAR_COUNT,
+  } EVENT_VAR_t;
+
+  struct EventVariable
+  {
+    EVENT_VAR_t               key;
+    unsigned                  index;  // index of the name in the subject, the value follows
+  };
+
   struct EventMessage
   {
     EVENT_t                   event;
     std::vector<std::string>  subject;
+    // the typed view of an UPnP property change, built by Index()
+    PROPCHANGE_t              kind;
+    uint32_t                  seq;
+    std::vector<EventVariable> vars;
 
     EventMessage()
     : event(EVENT_UNKNOWN)
+    , kind(PROPCHANGE_UNKNOWN)
+    , seq(0)
     {}
+
+    /**
+     * @brief Build the typed view of an UPnP property change from its subject.
+     * The values are not copied: they are read from the subject.
+     */
+    void Index();
+
+    const std::string& SID() const { return subject[0]; }
+    const std::string& Name(const EventVariable& var) const { return subject[var.index]; }
+    const std::string& Value(const EventVariable& var) const { return subject[var.index + 1]; }
+
+    /**
+     * @brief Return the interned key of the variable name.
+     */
+    static EVENT_VAR_t InternName(const std::string& name);
+
+    /**
+     * @brief Merge two RCS or AVT updates of the same SID. The variables of
+     * the next update replace those of the previous one, in their order.
+     * @return the merged message to be freed by the caller, else null if
+     * they cannot be merged
+     */
+    static EventMessage * Coalesce(const EventMessage& prev, const EventMessage& next);
   };
 
   typedef SHARED_PTR<const EventMessage> EventMessagePtr;
@@ -71,6 +203,26 @@ namespace NSROOT
     virtual ~EventHandlerThread();
     std::string GetAddress() const { return m_listenerAddress; }
     unsigned GetPort() const { return m_port; }
+
+    /**
+     * @brief Enable the persistent connections (HTTP keep-alive).
+     * @param timeout the idle timeout in seconds, or 0 to disable
+     * @param maxRequests the max number of requests per connection, or 0 for no limit
+     */
+    void SetKeepAlive(unsigned timeout, unsigned maxRequests);
+    unsigned GetKeepAliveTimeout() const { return m_keepAliveTimeout.load(std::memory_order_relaxed); }
+    unsigned GetKeepAliveMax() const { return m_keepAliveMax.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Enable the coalescing of the RCS and AVT property updates. An
+     * update awaiting delivery to a subscriber absorbs the next updates for
+     * the same SID during the window; the last value of a variable wins.
+     * It is disabled by default.
+     * @param millisec the window in milliseconds, or 0 to disable
+     */
+    void SetCoalescingWindow(unsigned millisec) { m_coalescingWindow.store(millisec, std::memory_order_relaxed); }
+    unsigned GetCoalescingWindow() const { return m_coalescingWindow.load(std::memory_order_relaxed); }
+
     virtual bool Start() = 0;
     virtual void Stop() = 0;
     virtual bool HasStarted() = 0;
@@ -80,6 +232,16 @@ namespace NSROOT
     virtual void RevokeAllSubscriptions(EventSubscriber *sub) = 0;
     virtual void DispatchEvent(const EventMessagePtr& msg) = 0;
 
+    /**
+     * @brief Return the number of threads delivering the messages to the subscribers.
+     */
+    virtual unsigned GetDispatcherThreadCount() = 0;
+
+    /**
+     * @brief Return the number of messages awaiting delivery to the subscribers.
+     */
+    virtual unsigned GetDispatcherQueueDepth() = 0;
+
     /**
      * @brief Configure a callback to handle any other requests than supported by the event broker.
      * @param rb the pointer to the request broker instance or null
@@ -92,6 +254,9 @@ namespace NSROOT
   protected:
     std::string m_listenerAddress;
     unsigned m_port;
+    std::atomic<unsigned> m_keepAliveTimeout;
+    std::atomic<unsigned> m_keepAliveMax;
+    std::atomic<unsigned> m_coalescingWindow;
   };
 
   typedef SHARED_PTR<EventHandlerThread> EventHandlerThreadPtr;
@@ -107,6 +272,8 @@ namespace NSROOT
     std::string GetAddress() const { return m_imp ? m_imp->GetAddress() : ""; }
     unsigned GetPort() const { return m_imp ? m_imp->GetPort(): 0; }
     bool IsRunning() { return m_imp ? m_imp->HasStarted() : false; }
+    void SetKeepAlive(unsigned timeout, unsigned maxRequests = EVENTHANDLER_KEEPALIVE_MAX) { if (m_imp) m_imp->SetKeepAlive(timeout, maxRequests); }
+    void SetCoalescingWindow(unsigned millisec = EVENTHANDLER_COALESCING_WINDOW) { if (m_imp) m_imp->SetCoalescingWindow(millisec); }
 
     void RegisterRequestBroker(RequestBrokerPtr rb) { if (m_imp) m_imp->RegisterRequestBroker(rb); }
     void UnregisterRequestBroker(const std::string& name) { if (m_imp) m_imp->UnregisterRequestBroker(name); }
@@ -117,6 +284,8 @@ namespace NSROOT
     bool SubscribeForEvent(unsigned subid, EVENT_t event) { return m_imp ? m_imp->SubscribeForEvent(subid, event) : false; }
     void RevokeSubscription(unsigned subid) { if (m_imp) m_imp->RevokeSubscription(subid); }
     void RevokeAllSubscriptions(EventSubscriber *sub) { if (m_imp) m_imp->RevokeAllSubscriptions(sub); }
+    unsigned GetDispatcherThreadCount() { return m_imp ? m_imp->GetDispatcherThreadCount() : 0; }
+    unsigned GetDispatcherQueueDepth() { return m_imp ? m_imp->GetDispatcherQueueDepth() : 0; }
 
   private:
     EventHandlerThreadPtr m_imp;
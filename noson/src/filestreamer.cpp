@@ -36,6 +36,7 @@
 #define FILESTREAMER_TIMEOUT  10000
 #define FILESTREAMER_MAX_PB   5
 #define FILESTREAMER_CHUNK    16384
+#define FILESTREAMER_SLICE    1048576 // bytes sent between checks of abort
 
 using namespace NSROOT;
 
@@ -131,6 +132,14 @@ bool FileStreamer::HandleRequest(handle * handle)
   return false;
 }
 
+RequestBroker::RouteList FileStreamer::GetRoutes()
+{
+  RouteList routes;
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Get), FILESTREAMER_URI));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Head), FILESTREAMER_URI));
+  return routes;
+}
+
 RequestBroker::ResourcePtr FileStreamer::GetResource(const std::string& title)
 {
   for (ResourceList::iterator it = m_resources.begin(); it != m_resources.end(); ++it)
@@ -364,6 +373,20 @@ std::list<FileStreamer::range> FileStreamer::bytesRange(const std::string &range
   return ranges;
 }
 
+bool FileStreamer::transferRange(WSRequestReply& reply, FILE * file, size_t offset, size_t len, size_t * tb)
+{
+  while (len > 0 && !IsAborted())
+  {
+    size_t slice = (len > FILESTREAMER_SLICE ? FILESTREAMER_SLICE : len);
+    if (!reply.WriteFileRange(file, offset, slice))
+      return false;
+    *tb += slice;
+    offset += slice;
+    len -= slice;
+  }
+  return (len == 0);
+}
+
 void FileStreamer::streamFile(handle * handle, const std::string& filePath, const std::string& contentType)
 {
   size_t tb = 0; // count transfered bytes
@@ -387,7 +410,19 @@ void FileStreamer::streamFile(handle * handle, const std::string& filePath, cons
   m_playbackCount.Add(1);
   TraceResponseStatus(200);
   reply.AddHeader(WS_HEADER_Content_Type, contentType);
-  if (reply.BeginContent(WS_STATUS_200_OK, FILESTREAMER_CHUNK))
+  size_t fileSize = getFileLength(file);
+  if (fileSize > 0)
+  {
+    // the length is known: send the file as is
+    if (reply.BeginContentLength(WS_STATUS_200_OK, fileSize))
+    {
+      if (transferRange(reply, file, 0, fileSize, &tb))
+        reply.CloseContent();
+      else
+        reply.Abort();
+    }
+  }
+  else if (reply.BeginContent(WS_STATUS_200_OK, FILESTREAMER_CHUNK))
   {
     while (!IsAborted())
     {
@@ -478,28 +513,16 @@ void FileStreamer::streamFileRange(handle * handle, const std::string& filePath,
         reply.AddHeader(WS_HEADER_Content_Range, crg);
       }
 
-      if (reply.BeginContent(wss, FILESTREAMER_CHUNK))
+      if (reply.BeginContentLength(wss, len))
       {
         size_t tb = 0; // count transfered bytes
-        char * buf = new char [FILESTREAMER_CHUNK];
-        size_t r = 0;
-        size_t chunk = (len > FILESTREAMER_CHUNK ? FILESTREAMER_CHUNK : len);
-        while (!IsAborted() && chunk > 0 && (r = fread(buf, 1, chunk, file)) > 0)
-        {
-          if (!reply.WriteData(buf, r))
-            break;
-          tb += r;
-          len -= r;
-          if (len < FILESTREAMER_CHUNK)
-            chunk = len;
-        }
-        delete [] buf;
-
-        if (len == 0)
+        if (transferRange(reply, file, rg.start, len, &tb))
         {
           DBG(DBG_DEBUG, "%s: transfer range %p (%" PRIu64 ")\n", __FUNCTION__, this, tb);
           reply.CloseContent();
         }
+        else
+          reply.Abort();
       }
     }
   }
@@ -509,63 +532,56 @@ void FileStreamer::streamFileRange(handle * handle, const std::string& filePath,
     TraceResponseStatus(206);
     std::string boundary = makeETag(filePath.c_str(), time(nullptr));
     reply.AddHeader(WS_HEADER_Content_Type, std::string("multipart/byteranges; boundary=").append(boundary));
-    if (reply.BeginContent(WS_STATUS_206_Partial_Content, FILESTREAMER_CHUNK))
+    // build the part headers first, as the length of the whole content
+    // must be known to send the ranges without encoding
+    std::vector<std::string> parts;
+    parts.reserve(ranges.size());
+    uint64_t length = 0;
+    for (const range& rg : ranges)
+    {
+      std::string crg;
+      crg.reserve(127);
+      crg.append("--").append(boundary).append(WS_CRLF);
+      crg.append(ws_header_to_str(WS_HEADER_Content_Type))
+          .append(": ").append(contentType).append(WS_CRLF);
+      crg.append(ws_header_to_str(WS_HEADER_Content_Range))
+          .append(": ").append("bytes ");
+      BUILTIN_BUFFER str;
+      uint32_to_string(rg.start, &str);
+      crg.append(str.data).push_back('-');
+      uint32_to_string(rg.end, &str);
+      crg.append(str.data).push_back('/');
+      uint32_to_string(fileSize, &str);
+      crg.append(str.data);
+      crg.append(WS_CRLF WS_CRLF);
+      length += crg.size() + (rg.end - rg.start + 1) + WS_CRLF_LEN;
+      parts.push_back(std::move(crg));
+    }
+    std::string close;
+    close.reserve(boundary.size() + 4 + WS_CRLF_LEN);
+    close.append("--").append(boundary).append("--" WS_CRLF);
+    length += close.size();
+
+    if (reply.BeginContentLength(WS_STATUS_206_Partial_Content, length))
     {
       std::list<range>::const_iterator it = ranges.begin();
+      std::vector<std::string>::const_iterator ip = parts.begin();
       while (it != ranges.end())
       {
-        if (fseek(file, it->start, SEEK_SET) != 0)
+        if (!reply.WriteData(ip->c_str(), (int)ip->size()))
           break;
-        std::string crg;
-        crg.reserve(127);
-        crg.append("--").append(boundary).append(WS_CRLF);
-        crg.append(ws_header_to_str(WS_HEADER_Content_Type))
-            .append(": ").append(contentType).append(WS_CRLF);
-        crg.append(ws_header_to_str(WS_HEADER_Content_Range))
-            .append(": ").append("bytes ");
-        BUILTIN_BUFFER str;
-        uint32_to_string(it->start, &str);
-        crg.append(str.data).push_back('-');
-        uint32_to_string(it->end, &str);
-        crg.append(str.data).push_back('/');
-        uint32_to_string(fileSize, &str);
-        crg.append(str.data);
-        crg.append(WS_CRLF WS_CRLF);
-
-        if (!reply.WriteData(crg.c_str(), crg.size()))
-          break;
-
-        size_t len = it->end - it->start + 1;
         size_t tb = 0; // count transfered bytes
-        char * buf = new char [FILESTREAMER_CHUNK];
-        size_t r = 0;
-        size_t chunk = (len > FILESTREAMER_CHUNK ? FILESTREAMER_CHUNK : len);
-        while (!IsAborted() && chunk > 0 && (r = fread(buf, 1, chunk, file)) > 0)
-        {
-          if (!reply.WriteData(buf, r))
-            break;
-          tb += r;
-          len -= r;
-          if (len < FILESTREAMER_CHUNK)
-            chunk = len;
-        }
-        delete [] buf;
-
-        if (len > 0 || !reply.WriteData(WS_CRLF, WS_CRLF_LEN))
+        if (!transferRange(reply, file, it->start, it->end - it->start + 1, &tb) ||
+                !reply.WriteData(WS_CRLF, WS_CRLF_LEN))
           break;
         DBG(DBG_DEBUG, "%s: transfer range %p (%" PRIu64 ")\n", __FUNCTION__, this, tb);
         ++it;
+        ++ip;
       }
-      if (it != ranges.end())
+      if (it != ranges.end() || !reply.WriteData(close.c_str(), (int)close.size()))
         reply.Abort();
       else
-      {
-        std::string crg;
-        crg.reserve(boundary.size() + 2 + WS_CRLF_LEN);
-        crg.append("--").append(boundary).append(WS_CRLF);
-        (void)reply.WriteData(crg.c_str(), crg.size());
         reply.CloseContent();
-      }
     }
   }
 
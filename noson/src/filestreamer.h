@@ -43,6 +43,8 @@ public:
   virtual bool HandleRequest(handle * handle) override;
 
   const char * CommonName() override { return FILESTREAMER_CNAME; }
+  bool IsStreaming() override { return true; }
+  RequestBroker::RouteList GetRoutes() override;
   RequestBroker::ResourcePtr GetResource(const std::string& title) override;
   RequestBroker::ResourceList GetResourceList() override;
   RequestBroker::ResourcePtr RegisterResource(const std::string& title,
@@ -97,6 +99,7 @@ private:
   typedef struct { size_t start; size_t end; } range;
   static std::list<range> bytesRange(const std::string& rangeValue, size_t size);
 
+  bool transferRange(WSRequestReply& reply, FILE * file, size_t offset, size_t len, size_t * tb);
   void streamFile(handle * handle, const std::string& filePath, const std::string& contentType);
   void streamFileRange(handle * handle, const std::string& filePath, const std::string& contentType,
                        const std::string& rangeValue);
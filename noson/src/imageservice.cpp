@@ -77,6 +77,16 @@ bool ImageService::HandleRequest(handle * handle)
   return false;
 }
 
+RequestBroker::RouteList ImageService::GetRoutes()
+{
+  RouteList routes;
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Get), IMAGESERVICE_URI));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Head), IMAGESERVICE_URI));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Get), IMAGESERVICE_FAVICON));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Head), IMAGESERVICE_FAVICON));
+  return routes;
+}
+
 RequestBroker::ResourcePtr ImageService::GetResource(const std::string& title)
 {
   for (ResourceMap::iterator it = m_resources.begin(); it != m_resources.end(); ++it)
@@ -38,6 +38,7 @@ public:
   virtual bool HandleRequest(handle * handle) override;
 
   const char * CommonName() override { return IMAGESERVICE_CNAME; }
+  RequestBroker::RouteList GetRoutes() override;
   RequestBroker::ResourcePtr GetResource(const std::string& title) override;
   RequestBroker::ResourceList GetResourceList() override;
   RequestBroker::ResourcePtr RegisterResource(const std::string& title,
@@ -0,0 +1,302 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "librarycache.h"
+#include "contentdirectory.h"
+#include "sonostypes.h"
+#include "private/debug.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#define LIBRARYCACHE_MAGIC      "NLC2"
+#define LIBRARYCACHE_MAGIC_SIZE 4
+
+using namespace NSROOT;
+
+static void __putU32(std::string& out, uint32_t val)
+{
+  char buf[4];
+  buf[0] = (char)(val & 0xff);
+  buf[1] = (char)((val >> 8) & 0xff);
+  buf[2] = (char)((val >> 16) & 0xff);
+  buf[3] = (char)((val >> 24) & 0xff);
+  out.append(buf, 4);
+}
+
+static void __putString(std::string& out, const std::string& str)
+{
+  __putU32(out, (uint32_t)str.size());
+  out.append(str);
+}
+
+namespace NSROOT
+{
+  struct CacheReader
+  {
+    const char * pos;
+    const char * end;
+    bool GetU32(uint32_t& val)
+    {
+      if (end - pos < 4)
+        return false;
+      const unsigned char * p = reinterpret_cast<const unsigned char*>(pos);
+      val = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+      pos += 4;
+      return true;
+    }
+    bool GetString(std::string& str)
+    {
+      uint32_t len;
+      if (!GetU32(len) || (uint32_t)(end - pos) < len)
+        return false;
+      str.assign(pos, len);
+      pos += len;
+      return true;
+    }
+  };
+}
+
+static bool __readFile(const std::string& path, std::string& data)
+{
+  FILE * file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  char buf[16384];
+  size_t r;
+  while ((r = fread(buf, 1, sizeof(buf), file)) > 0)
+    data.append(buf, r);
+  bool ok = (ferror(file) == 0);
+  fclose(file);
+  return ok;
+}
+
+static bool __findContainer(const ContentProperty& prop, const char * name, std::string& token)
+{
+  for (const std::pair<std::string, unsigned>& c : prop.ContainerUpdateIDs)
+  {
+    if (c.first == name)
+    {
+      token.assign(c.first).append(",").append(std::to_string(c.second));
+      return true;
+    }
+  }
+  return false;
+}
+
+LibraryCache::LibraryCache(const std::string& path, const std::string& source)
+: m_path(path)
+, m_source(source)
+, m_hits(0)
+, m_misses(0)
+{
+}
+
+std::string LibraryCache::UpdateToken(const ContentProperty& prop, const std::string& objectID)
+{
+  std::string token;
+  // the music library: it is unstable while indexing the shares
+  if (objectID.compare(0, 2, "A:") == 0)
+  {
+    if (!prop.ShareIndexInProgress)
+      __findContainer(prop, "A:", token);
+  }
+  // the shares
+  else if (objectID.compare(0, 2, "S:") == 0)
+  {
+    if (!__findContainer(prop, "S:", token) && !prop.ShareListUpdateID.empty())
+      token.assign("S,").append(prop.ShareListUpdateID);
+  }
+  // the Sonos playlists
+  else if (objectID.compare(0, 3, "SQ:") == 0)
+  {
+    if (!prop.SavedQueuesUpdateID.empty())
+      token.assign("SQ,").append(prop.SavedQueuesUpdateID);
+  }
+  // the Sonos favorites
+  else if (objectID.compare(0, 3, "FV:") == 0)
+  {
+    if (!prop.FavoritesUpdateID.empty())
+      token.assign("FV,").append(prop.FavoritesUpdateID);
+  }
+  // the radio favorites
+  else if (objectID.compare(0, 2, "R:") == 0)
+  {
+    if (!prop.RadioFavoritesUpdateID.empty())
+      token.assign("R,").append(prop.RadioFavoritesUpdateID);
+  }
+  return token;
+}
+
+std::string LibraryCache::FilePath(const std::string& objectID) const
+{
+  // FNV-1a of the source and the container, separated by a nul
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const char * p = m_source.c_str(); ; ++p)
+  {
+    h ^= (unsigned char)*p;
+    h *= 0x100000001b3ULL;
+    if (*p == '\0')
+      break;
+  }
+  for (char c : objectID)
+  {
+    h ^= (unsigned char)c;
+    h *= 0x100000001b3ULL;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "library-%016llx.cache", (unsigned long long)h);
+  std::string path(m_path);
+  if (!path.empty() && path.back() != '/')
+    path.push_back('/');
+  return path.append(name);
+}
+
+bool LibraryCache::Load(const std::string& objectID, const std::string& token, DigitalItemList& items)
+{
+  items.clear();
+  std::string data;
+  std::string path = FilePath(objectID);
+  if (token.empty() || !__readFile(path, data))
+  {
+    ++m_misses;
+    return false;
+  }
+  CacheReader reader = { data.data(), data.data() + data.size() };
+  std::string str;
+  uint32_t count;
+  if (data.compare(0, LIBRARYCACHE_MAGIC_SIZE, LIBRARYCACHE_MAGIC) != 0 ||
+          (reader.pos += LIBRARYCACHE_MAGIC_SIZE, !reader.GetString(str)) || str != m_source ||
+          !reader.GetString(str) || str != objectID ||
+          !reader.GetString(str) || str != token || !reader.GetU32(count))
+  {
+    DBG(DBG_DEBUG, "%s: drop stale content (%s)\n", __FUNCTION__, objectID.c_str());
+    remove(path.c_str());
+    ++m_misses;
+    return false;
+  }
+  // the count isn't trusted yet: a record takes 16 bytes at least
+  items.reserve(std::min<size_t>(count, (size_t)(reader.end - reader.pos) / 16));
+  bool ok = true;
+  while (ok && count-- > 0)
+  {
+    std::string id, parentID;
+    uint32_t restricted, nvars;
+    ElementList vars;
+    ok = reader.GetString(id) && reader.GetString(parentID) && reader.GetU32(restricted) && reader.GetU32(nvars);
+    while (ok && nvars-- > 0)
+    {
+      std::string key, value;
+      uint32_t nattrs;
+      ok = reader.GetString(key) && reader.GetString(value) && reader.GetU32(nattrs);
+      ElementPtr var(new Element(key, value));
+      while (ok && nattrs-- > 0)
+      {
+        ok = reader.GetString(key) && reader.GetString(value);
+        var->SetAttribut(key, value);
+      }
+      vars.push_back(var);
+    }
+    if (ok)
+      items.push_back(DigitalItemPtr(new DigitalItem(id, parentID, restricted != 0, vars)));
+  }
+  if (!ok)
+  {
+    DBG(DBG_ERROR, "%s: invalid content (%s)\n", __FUNCTION__, objectID.c_str());
+    remove(path.c_str());
+    items.clear();
+    ++m_misses;
+    return false;
+  }
+  ++m_hits;
+  return true;
+}
+
+bool LibraryCache::Store(const std::string& objectID, const std::string& token, const DigitalItemList& items)
+{
+  if (token.empty())
+    return false;
+  std::string data(LIBRARYCACHE_MAGIC);
+  __putString(data, m_source);
+  __putString(data, objectID);
+  __putString(data, token);
+  __putU32(data, (uint32_t)items.size());
+  for (const DigitalItemPtr& item : items)
+  {
+    __putString(data, item->GetObjectID());
+    __putString(data, item->GetParentID());
+    __putU32(data, item->GetRestricted() ? 1 : 0);
+    std::vector<ElementPtr> vars = item->GetElements();
+    __putU32(data, (uint32_t)vars.size());
+    for (const ElementPtr& var : vars)
+    {
+      __putString(data, var->GetKey());
+      __putString(data, *var);
+      std::vector<Element>& attrs = var->Attributs();
+      __putU32(data, (uint32_t)attrs.size());
+      for (const Element& attr : attrs)
+      {
+        __putString(data, attr.GetKey());
+        __putString(data, attr);
+      }
+    }
+  }
+  // write the new file aside, then replace the old one
+  std::string path = FilePath(objectID);
+  std::string tmp(path);
+  tmp.append(".tmp");
+  FILE * file = fopen(tmp.c_str(), "wb");
+  if (!file)
+  {
+    DBG(DBG_ERROR, "%s: cannot write file (%s)\n", __FUNCTION__, tmp.c_str());
+    return false;
+  }
+  bool ok = (fwrite(data.data(), 1, data.size(), file) == data.size());
+  ok = (fclose(file) == 0) && ok;
+  if (ok && rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    // the target cannot be replaced on some platforms
+    remove(path.c_str());
+    ok = (rename(tmp.c_str(), path.c_str()) == 0);
+  }
+  if (!ok)
+  {
+    DBG(DBG_ERROR, "%s: cannot store content (%s)\n", __FUNCTION__, objectID.c_str());
+    remove(tmp.c_str());
+  }
+  return ok;
+}
+
+void LibraryCache::Erase(const std::string& objectID)
+{
+  remove(FilePath(objectID).c_str());
+}
+
+bool LibraryCache::Browse(ContentDirectory& service, const std::string& objectID, DigitalItemList& items)
+{
+  std::string token = UpdateToken(*(service.GetContentProperty().Get()), objectID);
+  if (Load(objectID, token, items))
+    return true;
+  if (!service.BrowseAll(objectID, items))
+    return false;
+  // the content could have changed while browsing
+  if (!token.empty() && token == UpdateToken(*(service.GetContentProperty().Get()), objectID))
+    Store(objectID, token, items);
+  return true;
+}
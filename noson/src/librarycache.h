@@ -0,0 +1,108 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LIBRARYCACHE_H
+#define LIBRARYCACHE_H
+
+#include "local_config.h"
+#include "digitalitem.h"
+
+#include <string>
+
+namespace NSROOT
+{
+  class ContentDirectory;
+  class ContentProperty;
+
+  /**
+   * The persistent cache of the browsed containers. A container is stored
+   * in its own file of the cache directory, keyed by the source of the
+   * content and the container, with the update token of its content at the
+   * time it was browsed. On load, the cached container is
+   * valid only when the token still matches the content property tracked by
+   * the ContentDirectory (ContainerUpdateIDs, SavedQueuesUpdateID, etc).
+   */
+  class LibraryCache
+  {
+  public:
+    /**
+     * @param path the directory of the cache files, it must exist
+     * @param source the household ID, or the UUID of the media server, that
+     * owns the cached containers, so the households sharing a directory
+     * don't see the content of each other
+     */
+    LibraryCache(const std::string& path, const std::string& source);
+    ~LibraryCache() { }
+
+    /**
+     * Compute the token identifying the state of the container content.
+     * @param prop the content property
+     * @param objectID the container
+     * @return the token, else empty when the container cannot be cached
+     */
+    static std::string UpdateToken(const ContentProperty& prop, const std::string& objectID);
+
+    /**
+     * Load the cached items of the container. A stale file is removed.
+     * @param objectID the container
+     * @param token the current update token of the container
+     * @param items the list filled with the items
+     * @return true on hit, else false
+     */
+    bool Load(const std::string& objectID, const std::string& token, DigitalItemList& items);
+
+    /**
+     * Store the items of the container.
+     * @param objectID the container
+     * @param token the update token of the content
+     * @param items the items
+     * @return true on success, else false
+     */
+    bool Store(const std::string& objectID, const std::string& token, const DigitalItemList& items);
+
+    /**
+     * Remove the cached items of the container.
+     */
+    void Erase(const std::string& objectID);
+
+    /**
+     * Load the container from the cache, else browse it from the service
+     * and store it, unless its content cannot be validated: no event was
+     * received yet, or the share index is in progress.
+     * @param service the content directory of the player
+     * @param objectID the container
+     * @param items the list filled with the items
+     * @return true on success, else false
+     */
+    bool Browse(ContentDirectory& service, const std::string& objectID, DigitalItemList& items);
+
+    unsigned GetHitCount() const { return m_hits; }
+
+    unsigned GetMissCount() const { return m_misses; }
+
+  private:
+    std::string m_path;
+    std::string m_source;
+    unsigned m_hits;
+    unsigned m_misses;
+
+    std::string FilePath(const std::string& objectID) const;
+  };
+}
+
+#endif /* LIBRARYCACHE_H */
@@ -0,0 +1,168 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "commandcoalescer.h"
+#include "../service.h"
+#include "debug.h"
+
+using namespace NSROOT;
+
+CommandCoalescer::CommandCoalescer()
+: m_shared(new Shared(this))
+, m_idle(true)
+, m_busy(0)
+, m_sent(0)
+, m_dropped(0)
+, m_failed(0)
+{
+}
+
+CommandCoalescer::~CommandCoalescer()
+{
+  {
+    // wait for a completion in progress, then detach the others
+    OS::LockGuard lock(m_shared->mutex);
+    m_shared->coalescer = nullptr;
+  }
+  OS::LockGuard lock(m_mutex);
+  for (std::map<std::string, Slot>::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+  {
+    if (it->second.held)
+    {
+      it->second.held = false;
+      ++m_dropped;
+    }
+    if (it->second.request)
+      it->second.request->Cancel();
+  }
+}
+
+void CommandCoalescer::Submit(const std::string& kind, Service * service, const std::string& action, const ElementList& args)
+{
+  Command command;
+  command.service = service;
+  command.action = action;
+  command.args = args;
+  {
+    OS::LockGuard lock(m_mutex);
+    Slot& slot = m_slots[kind];
+    if (slot.busy)
+    {
+      // replace the command held
+      if (slot.held)
+        ++m_dropped;
+      slot.held = true;
+      slot.command = command;
+      return;
+    }
+    slot.busy = true;
+    ++m_busy;
+    m_idle = false;
+  }
+  Send(kind, command);
+}
+
+bool CommandCoalescer::WaitIdle(unsigned timeout)
+{
+  OS::LockGuard lock(m_mutex);
+  return m_condition.wait_for(m_mutex, timeout, m_idle);
+}
+
+unsigned CommandCoalescer::GetSentCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_sent;
+}
+
+unsigned CommandCoalescer::GetDroppedCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_dropped;
+}
+
+unsigned CommandCoalescer::GetFailedCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_failed;
+}
+
+void CommandCoalescer::Send(const std::string& kind, const Command& command)
+{
+  unsigned serial;
+  {
+    OS::LockGuard lock(m_mutex);
+    serial = ++m_slots[kind].serial;
+  }
+  Completion * completion = new Completion();
+  completion->shared = m_shared;
+  completion->kind = kind;
+  completion->response.assign(command.action).append("Response");
+  // the completion could be called before returning
+  ServiceRequestPtr request = command.service->RequestAsync(command.action, command.args, CB_Completed, completion);
+  OS::LockGuard lock(m_mutex);
+  // keep the handle to cancel, unless the slot has moved on
+  Slot& slot = m_slots[kind];
+  if (slot.serial == serial && !request->IsCompleted())
+    slot.request = request;
+}
+
+void CommandCoalescer::Completed(const std::string& kind, bool succeeded)
+{
+  Command command;
+  {
+    OS::LockGuard lock(m_mutex);
+    if (succeeded)
+      ++m_sent;
+    else
+      ++m_failed;
+    Slot& slot = m_slots[kind];
+    slot.request.reset();
+    if (!slot.held)
+    {
+      slot.busy = false;
+      if (--m_busy == 0)
+      {
+        m_idle = true;
+        m_condition.notify_all();
+      }
+      return;
+    }
+    // the slot stays busy with the command held
+    slot.held = false;
+    command = slot.command;
+    slot.command = Command();
+  }
+  Send(kind, command);
+}
+
+void CommandCoalescer::CB_Completed(void * handle, const ElementList& vars)
+{
+  Completion * completion = static_cast<Completion*>(handle);
+  bool succeeded = (!vars.empty() && vars[0]->compare(completion->response) == 0);
+  if (!succeeded)
+    DBG(DBG_WARN, "%s: %s failed\n", __FUNCTION__, completion->response.c_str());
+  {
+    OS::LockGuard lock(completion->shared->mutex);
+    if (completion->shared->coalescer)
+      completion->shared->coalescer->Completed(completion->kind, succeeded);
+  }
+  delete completion;
+}
@@ -0,0 +1,135 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef COMMANDCOALESCER_H
+#define COMMANDCOALESCER_H
+
+#include "local_config.h"
+#include "os/threads/mutex.h"
+#include "os/threads/condition.h"
+#include "../element.h"
+#include "../service.h"
+
+#include <map>
+#include <string>
+
+namespace NSROOT
+{
+
+  /**
+   * The coalescer sends the commands of a same kind one at a time, without
+   * blocking the caller. While a command is in flight, a newer command of the
+   * same kind replaces the one held, so only the latest is sent once the
+   * slot is free. It fits the controls producing many values per second,
+   * like a slider, for which only the last value matters.
+   */
+  class CommandCoalescer
+  {
+  public:
+    CommandCoalescer();
+
+    /**
+     * The commands held are dropped, and the commands in flight are canceled.
+     * The destructor doesn't wait for their completion, which no longer
+     * refers to the coalescer.
+     */
+    ~CommandCoalescer();
+
+    CommandCoalescer(const CommandCoalescer&) = delete;
+    CommandCoalescer& operator=(const CommandCoalescer&) = delete;
+
+    /**
+     * Send the action, or hold it until the command of same kind in flight
+     * is completed.
+     * @param kind the key of the command, i.e the target and the property
+     * @param service the service to request, it must outlive the coalescer
+     * @param action the name of the action
+     * @param args the arguments of the action
+     */
+    void Submit(const std::string& kind, Service * service, const std::string& action, const ElementList& args);
+
+    /**
+     * Wait until no command is in flight or held.
+     * @param timeout in millisec
+     * @return true if idle, else false
+     */
+    bool WaitIdle(unsigned timeout);
+
+    unsigned GetSentCount();
+    unsigned GetDroppedCount();
+    unsigned GetFailedCount();
+
+  private:
+    struct Command
+    {
+      Service * service;
+      std::string action;
+      ElementList args;
+    };
+
+    struct Slot
+    {
+      bool busy;
+      bool held;
+      unsigned serial;
+      Command command;
+      ServiceRequestPtr request;
+      Slot() : busy(false), held(false), serial(0), command(), request() { }
+    };
+
+    /**
+     * The state shared with the completions: the coalescer is cleared on
+     * destruction, under the lock.
+     */
+    struct Shared
+    {
+      OS::Mutex mutex;
+      CommandCoalescer * coalescer;
+      Shared(CommandCoalescer * c) : coalescer(c) { }
+    };
+
+    typedef SHARED_PTR<Shared> SharedPtr;
+
+    struct Completion
+    {
+      SharedPtr shared;
+      std::string kind;
+      std::string response;
+    };
+
+    SharedPtr m_shared;
+    OS::Mutex m_mutex;
+    OS::Condition<volatile bool> m_condition;
+    volatile bool m_idle;
+    std::map<std::string, Slot> m_slots;
+    unsigned m_busy;
+    unsigned m_sent;
+    unsigned m_dropped;
+    unsigned m_failed;
+
+    void Send(const std::string& kind, const Command& command);
+    void Completed(const std::string& kind, bool succeeded);
+
+    static void CB_Completed(void * handle, const ElementList& vars);
+  };
+}
+
+#endif /* COMMANDCOALESCER_H */
@@ -26,63 +26,157 @@ using namespace NSROOT;
 
 #define CONNECTION_TIMEOUT  5 // default timeout in seconds
 
-EventBroker::EventBroker(EventHandlerThread* handler, SHARED_PTR<TcpSocket>& sockPtr)
+EventBroker::EventBroker(EventHandlerThread* handler, const RequestRouter* router, SHARED_PTR<TcpSocket>& sockPtr,
+                         OS::ThreadPool* streamPool, Poller* poller, unsigned count)
 : m_handler(handler)
+, m_router(router)
 , m_sockPtr(sockPtr)
+, m_streamPool(streamPool)
+, m_poller(poller)
+, m_count(count)
+, m_rb(nullptr)
+{
+}
+
+EventBroker::EventBroker(const EventBroker& origin, WSRequestBroker* rb)
+: m_handler(origin.m_handler)
+, m_router(origin.m_router)
+, m_sockPtr(origin.m_sockPtr)
+, m_streamPool(nullptr)
+, m_poller(origin.m_poller)
+, m_count(origin.m_count)
+, m_rb(rb)
 {
 }
 
 EventBroker::~EventBroker()
 {
+  if (m_rb)
+    delete m_rb;
 }
 
 void EventBroker::process()
 {
-  if (!m_handler || !m_sockPtr || !m_sockPtr->IsValid())
+  if (!m_handler || !m_router || !m_sockPtr || !m_sockPtr->IsValid())
     return;
 
-  WSRequestBroker rb(m_sockPtr.get(), false, CONNECTION_TIMEOUT);
-  std::string resp;
+  // the request could have been parsed by a short-lived worker, and it is now
+  // processed by a dedicated stream worker
+  WSRequestBroker* rb = m_rb;
+  m_rb = nullptr;
 
-  if (!rb.IsParsed())
+  for (;;)
   {
-    WS_STATUS status(WS_STATUS_400_Bad_Request);
-    resp.append(SERVER_PROTOCOL " ").append(ws_status_to_numstr(status)).append(" ").append(ws_status_to_msgstr(status)).append(WS_CRLF);
-    resp.append("Server: ").append(SERVER_SOFTWARE).append(WS_CRLF);
-    resp.append("Connection: " SERVER_CONNECTION WS_CRLF);
-    resp.append(WS_CRLF);
-    m_sockPtr->SendData(resp.c_str(), resp.size());
-    m_sockPtr->Disconnect();
-    return;
-  }
+    if (rb)
+    {
+      if (Dispatch(rb, true) != DISPATCH_DONE)
+      {
+        delete rb;
+        // bad request!!!
+        ReplyStatus(WS_STATUS_400_Bad_Request);
+        return;
+      }
+    }
+    else
+    {
+      rb = new WSRequestBroker(m_sockPtr.get(), false, CONNECTION_TIMEOUT);
 
-  RequestBroker::handle handle { m_handler, &rb };
-  std::vector<RequestBrokerPtr> vect = m_handler->AllRequestBroker();
-  for (std::vector<RequestBrokerPtr>::iterator itrb = vect.begin(); itrb != vect.end(); ++itrb)
-  {
-    // loop until the request is processed
-    if ((*itrb)->HandleRequest(&handle))
+      if (!rb->IsParsed())
+      {
+        // the client has closed the persistent connection
+        bool closed = (m_count > 0 && rb->GetRequestLine().empty());
+        delete rb;
+        if (closed)
+          m_sockPtr->Disconnect();
+        else
+          ReplyStatus(WS_STATUS_400_Bad_Request);
+        return;
+      }
+
+      // apply the policy of persistent connection before replying
+      unsigned max = m_handler->GetKeepAliveMax();
+      if (m_handler->GetKeepAliveTimeout() == 0 || (max > 0 && m_count + 1 >= max))
+        rb->SetKeepAlive(false);
+
+      switch (Dispatch(rb, false))
+      {
+      case DISPATCH_DONE:
+        break;
+
+      case DISPATCH_STREAMING:
+        // hand off the request to a stream worker
+        if (m_streamPool->enqueue(new EventBroker(*this, rb)))
+          return;
+        DBG(DBG_WARN, "%s: stream pool is stopped\n", __FUNCTION__);
+        delete rb;
+        ReplyStatus(WS_STATUS_503_Service_Unavailable);
+        return;
+
+      default:
+      {
+        // default response for "HEAD /"
+        bool headRoot = (rb->GetRequestMethod() == WS_METHOD_Head && rb->GetRequestPath().compare("/") == 0);
+        delete rb;
+        if (headRoot)
+          ReplyStatus(WS_STATUS_200_OK);
+        else
+          // bad request!!!
+          ReplyStatus(WS_STATUS_400_Bad_Request);
+        return;
+      }
+      }
+    }
+
+    // the request has been processed: check the connection could be reused
+    bool keepAlive = (rb->IsKeepAlive() && rb->GetStatus() != WS_STATUS_UNKNOWN && rb->IsContentConsumed());
+    delete rb;
+    rb = nullptr;
+    if (!keepAlive || !m_sockPtr->IsValid())
     {
       m_sockPtr->Disconnect();
       return;
     }
+    ++m_count;
+    // the next request could be already received
+    if (m_sockPtr->HasBufferedData())
+      continue;
+    if (m_poller && m_poller->AwaitRequest(m_sockPtr, m_count))
+      return;
+    struct timeval tv = { (time_t)m_handler->GetKeepAliveTimeout(), 0 };
+    if (m_sockPtr->Listen(&tv) > 0)
+      continue;
+    m_sockPtr->Disconnect();
+    return;
   }
+}
 
-  // default response for "HEAD /"
-  if (rb.GetRequestMethod() == WS_METHOD_Head && rb.GetRequestPath().compare("/") == 0)
+EventBroker::DISPATCH EventBroker::Dispatch(WSRequestBroker* rb, bool streaming)
+{
+  RequestBroker::handle handle { m_handler, rb };
+  DISPATCH ret = DISPATCH_NONE;
+  // the selection holds the routing table until the request is processed
+  RequestRouter::Selection selection = m_router->Route(rb->GetRequestMethod(), rb->GetRequestPath());
+  const RequestRouter::Candidates& vect = *selection;
+  for (RequestRouter::Candidates::const_iterator itrb = vect.begin(); itrb != vect.end(); ++itrb)
   {
-    WS_STATUS status(WS_STATUS_200_OK);
-    resp.append(SERVER_PROTOCOL " ").append(ws_status_to_numstr(status)).append(" ").append(ws_status_to_msgstr(status)).append(WS_CRLF);
-    resp.append("Server: ").append(SERVER_SOFTWARE).append(WS_CRLF);
-    resp.append("Connection: " SERVER_CONNECTION WS_CRLF);
-    resp.append(WS_CRLF);
-    m_sockPtr->SendData(resp.c_str(), resp.size());
-    m_sockPtr->Disconnect();
-    return;
+    if (!streaming && m_streamPool && (*itrb)->IsStreaming())
+    {
+      // streaming brokers are tried last by a dedicated worker
+      ret = DISPATCH_STREAMING;
+      continue;
+    }
+    if (streaming && !(*itrb)->IsStreaming())
+      continue;
+    // loop until the request is processed
+    if ((*itrb)->HandleRequest(&handle))
+      return DISPATCH_DONE;
   }
+  return ret;
+}
 
-  // bad request!!!
-  WS_STATUS status(WS_STATUS_400_Bad_Request);
+void EventBroker::ReplyStatus(WS_STATUS status)
+{
+  std::string resp;
   resp.append(SERVER_PROTOCOL " ").append(ws_status_to_numstr(status)).append(" ").append(ws_status_to_msgstr(status)).append(WS_CRLF);
   resp.append("Server: ").append(SERVER_SOFTWARE).append(WS_CRLF);
   resp.append("Connection: " SERVER_CONNECTION WS_CRLF);
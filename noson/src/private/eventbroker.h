@@ -24,6 +24,7 @@
 #include "local_config.h"
 #include "os/threads/threadpool.h"
 #include "wsrequestbroker.h"
+#include "requestrouter.h"
 #include "socket.h"
 #include "../eventhandler.h"
 #include "../sharedptr.h"
@@ -34,13 +35,56 @@ namespace NSROOT
   class EventBroker : public OS::Worker
   {
   public:
-    EventBroker(EventHandlerThread* handler, SHARED_PTR<TcpSocket>& sockPtr);
+    /**
+     * The poller awaits the next request on a persistent connection, without
+     * holding a worker.
+     */
+    class Poller
+    {
+    public:
+      virtual ~Poller() { }
+      /**
+       * @param sockPtr the idle connection
+       * @param count the number of requests already processed on the connection
+       * @return true if the connection is polled, else false
+       */
+      virtual bool AwaitRequest(SHARED_PTR<TcpSocket>& sockPtr, unsigned count) = 0;
+    };
+
+    /**
+     * @brief Process the request incoming on the given socket.
+     * @param handler the event handler owning the request brokers
+     * @param router the router selecting the brokers for a request
+     * @param sockPtr the connected socket
+     * @param streamPool the pool of dedicated workers for streaming brokers,
+     * else null to process any request in the calling worker
+     * @param poller the poller of persistent connections, else null to await
+     * the next request in the calling worker
+     * @param count the number of requests already processed on the connection
+     */
+    EventBroker(EventHandlerThread* handler, const RequestRouter* router, SHARED_PTR<TcpSocket>& sockPtr,
+                OS::ThreadPool* streamPool = nullptr, Poller* poller = nullptr, unsigned count = 0);
     virtual ~EventBroker();
     virtual void process();
 
   private:
     EventHandlerThread* m_handler;
+    const RequestRouter* m_router;
     SHARED_PTR<TcpSocket> m_sockPtr;
+    OS::ThreadPool* m_streamPool;
+    Poller* m_poller;
+    unsigned m_count;
+    WSRequestBroker* m_rb; // the parsed request handed off to a stream worker
+
+    EventBroker(const EventBroker& origin, WSRequestBroker* rb);
+    enum DISPATCH
+    {
+      DISPATCH_NONE       = 0,
+      DISPATCH_DONE       = 1,
+      DISPATCH_STREAMING  = 2,
+    };
+    DISPATCH Dispatch(WSRequestBroker* rb, bool streaming);
+    void ReplyStatus(WS_STATUS status);
   };
 }
 
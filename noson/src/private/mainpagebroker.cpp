@@ -56,6 +56,14 @@ bool MainPageBroker::HandleRequest(handle * handle)
   return false;
 }
 
+RequestBroker::RouteList MainPageBroker::GetRoutes()
+{
+  RouteList routes;
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Get), MAINPAGE_URI));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Head), MAINPAGE_URI));
+  return routes;
+}
+
 RequestBroker::ResourcePtr MainPageBroker::GetResource(const std::string& title)
 {
   (void)title;
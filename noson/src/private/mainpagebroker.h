@@ -35,6 +35,7 @@ public:
   virtual bool HandleRequest(handle * handle) override;
 
   const char * CommonName() override { return MAINPAGEBROKER_CNAME; }
+  RequestBroker::RouteList GetRoutes() override;
   RequestBroker::ResourcePtr GetResource(const std::string& title) override;
   RequestBroker::ResourceList GetResourceList() override;
   RequestBroker::ResourcePtr RegisterResource(const std::string& title,
@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "notifyparser.h"
+#include "debug.h"
+
+#include <cstring>
+
+#define NS_RCS "urn:schemas-upnp-org:metadata-1-0/RCS/"
+#define NS_AVT "urn:schemas-upnp-org:metadata-1-0/AVT/"
+#define NS_RIN "urn:schemas-rinconnetworks-com:metadata-1-0/"
+#define QN_RIN "r:"
+
+namespace NSROOT
+{
+  XMLDict __initRCSDict()
+  {
+    XMLDict dict;
+    dict.DefineNS("", NS_RCS);
+    dict.DefineNS(QN_RIN, NS_RIN);
+    return dict;
+  }
+  XMLDict RCSDict = __initRCSDict();
+
+  XMLDict __initAVTDict()
+  {
+    XMLDict dict;
+    dict.DefineNS("", NS_AVT);
+    dict.DefineNS(QN_RIN, NS_RIN);
+    return dict;
+  }
+  XMLDict AVTDict = __initAVTDict();
+}
+
+using namespace NSROOT;
+
+NotifyParser::NotifyParser(std::vector<std::string>& subject)
+: m_subject(subject)
+, m_outerHandler(*this)
+, m_innerHandler(*this)
+, m_outer(m_outerHandler)
+, m_inner(m_innerHandler)
+, m_mode(MODE_NONE)
+, m_supported(true)
+, m_depth(0)
+, m_stopped(false)
+, m_hasValue(false)
+, m_inValue(false)
+, m_inLastChange(false)
+, m_innerDepth(0)
+, m_dict(nullptr)
+, m_type(nullptr)
+, m_hasInstance(false)
+, m_inInstance(false)
+{
+}
+
+bool NotifyParser::Feed(const char* data, size_t len)
+{
+  return m_outer.Feed(data, len);
+}
+
+bool NotifyParser::Finish()
+{
+  return m_outer.Finish();
+}
+
+bool NotifyParser::OuterHandler::StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+{
+  (void)attrs;
+  (void)count;
+  NotifyParser& p = m_owner;
+  unsigned depth = p.m_depth++;
+  switch (depth)
+  {
+  case 0:
+    return XMLNS::NameEqual(qname.c_str(), "propertyset");
+  case 1:
+    if (!XMLNS::NameEqual(qname.c_str(), "property"))
+      p.m_stopped = true;
+    p.m_hasValue = false;
+    return true;
+  case 2:
+    if (p.m_stopped || p.m_hasValue)
+      return true;
+    p.m_hasValue = true;
+    // the kind of the content is given by the first element
+    if (p.m_mode == MODE_NONE)
+    {
+      if (qname.compare("LastChange") == 0)
+      {
+        p.m_mode = MODE_LASTCHANGE;
+        p.m_inLastChange = true;
+        return true;
+      }
+      p.m_mode = MODE_PROPERTY;
+      p.m_subject.push_back("PROPERTY");
+    }
+    if (p.m_mode == MODE_PROPERTY)
+    {
+      p.m_subject.push_back(XMLNS::LocalName(qname.c_str()));
+      p.m_subject.push_back(std::string());
+      p.m_inValue = true;
+    }
+    return true;
+  case 3:
+    // the value is the text preceding the first child
+    p.m_inValue = false;
+    return !p.m_inLastChange;
+  default:
+    return true;
+  }
+}
+
+bool NotifyParser::OuterHandler::EndElement(const std::string& qname)
+{
+  (void)qname;
+  NotifyParser& p = m_owner;
+  if (--p.m_depth != 2)
+    return true;
+  if (p.m_inLastChange)
+  {
+    p.m_inLastChange = false;
+    if (!p.m_inner.Finish())
+      return false;
+    if (!p.m_hasInstance)
+      p.m_supported = false;
+  }
+  else if (p.m_mode == MODE_PROPERTY && p.m_hasValue && !p.m_stopped)
+  {
+    std::string& val = p.m_subject.back();
+    if (val.find_first_not_of(" \t\r\n") == std::string::npos)
+      val.clear();
+    DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, p.m_subject[p.m_subject.size() - 2].c_str(), val.c_str());
+  }
+  p.m_inValue = false;
+  return true;
+}
+
+bool NotifyParser::OuterHandler::CharData(const char* data, size_t len)
+{
+  NotifyParser& p = m_owner;
+  if (p.m_inLastChange)
+    return p.m_inner.Feed(data, len);
+  if (p.m_inValue)
+    p.m_subject.back().append(data, len);
+  return true;
+}
+
+bool NotifyParser::InnerHandler::StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+{
+  NotifyParser& p = m_owner;
+  unsigned depth = p.m_innerDepth++;
+  if (depth == 0)
+  {
+    for (unsigned i = 0; i < count; ++i)
+    {
+      const char* name = attrs[i].name.c_str();
+      if (XMLNS::PrefixEqual(name, "xmlns"))
+        p.m_names.AddXMLNS(XMLNS::LocalName(name), attrs[i].value.c_str());
+      else if (XMLNS::NameEqual(name, "xmlns"))
+        p.m_names.AddXMLNS("", attrs[i].value.c_str());
+    }
+    if (p.m_names.FindName(NS_RCS))
+    {
+      p.m_dict = &RCSDict;
+      p.m_type = "RCS";
+    }
+    else if (p.m_names.FindName(NS_AVT))
+    {
+      p.m_dict = &AVTDict;
+      p.m_type = "AVT";
+    }
+  }
+  else if (depth == 1)
+  {
+    if (p.m_dict && !p.m_hasInstance && qname.compare("InstanceID") == 0)
+    {
+      p.m_hasInstance = p.m_inInstance = true;
+      p.m_subject.push_back(p.m_type);
+    }
+  }
+  else if (depth == 2 && p.m_inInstance)
+  {
+    p.m_subject.push_back(p.m_dict->TranslateQName(p.m_names, qname.c_str()));
+    std::string& name = p.m_subject.back();
+    const std::string* str;
+    if (p.m_dict == &RCSDict && (str = XMLPushParser::FindAttribute("channel", attrs, count)))
+      name.append("/").append(*str);
+    if ((str = XMLPushParser::FindAttribute("val", attrs, count)))
+      p.m_subject.push_back(*str);
+    else
+      p.m_subject.push_back(std::string());
+    DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, p.m_subject[p.m_subject.size() - 2].c_str(), p.m_subject.back().c_str());
+  }
+  return true;
+}
+
+bool NotifyParser::InnerHandler::EndElement(const std::string& qname)
+{
+  (void)qname;
+  NotifyParser& p = m_owner;
+  if (--p.m_innerDepth == 1)
+    p.m_inInstance = false;
+  return true;
+}
+
+bool NotifyParser::InnerHandler::CharData(const char* data, size_t len)
+{
+  (void)data;
+  (void)len;
+  return true;
+}
@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef NOTIFYPARSER_H
+#define NOTIFYPARSER_H
+
+#include "local_config.h"
+#include "xmlpushparser.h"
+#include "xmldict.h"
+
+#include <string>
+#include <vector>
+
+namespace NSROOT
+{
+
+  /**
+   * Decode the body of an UPnP event notification (propertyset) into the
+   * subject of an event message, while the body is received. The embedded
+   * document 'LastChange' of the RCS and AVT services is decoded in the same
+   * pass by a nested parser, so neither the body nor the embedded document
+   * is stored.
+   *
+   * The values are appended to the subject as follows:
+   * "PROPERTY", name1, val1, ... for a plain property set, or
+   * "RCS"|"AVT", name1, val1, ... for the variables of the first InstanceID.
+   */
+  class NotifyParser
+  {
+  public:
+    NotifyParser(std::vector<std::string>& subject);
+    ~NotifyParser() { }
+
+    /**
+     * Parse the next chunk of the body.
+     * @return false if the content is invalid, else true
+     */
+    bool Feed(const char* data, size_t len);
+
+    /**
+     * Terminate the parsing.
+     * @return false if the content is invalid, else true
+     */
+    bool Finish();
+
+    /**
+     * Return false if the content is valid but its kind is unknown. Then the
+     * subject contains no value.
+     */
+    bool IsSupported() const { return m_supported; }
+
+  private:
+    class OuterHandler : public XMLPushParser::Handler
+    {
+    public:
+      OuterHandler(NotifyParser& owner) : m_owner(owner) { }
+      bool StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count) override;
+      bool EndElement(const std::string& qname) override;
+      bool CharData(const char* data, size_t len) override;
+    private:
+      NotifyParser& m_owner;
+    };
+
+    class InnerHandler : public XMLPushParser::Handler
+    {
+    public:
+      InnerHandler(NotifyParser& owner) : m_owner(owner) { }
+      bool StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count) override;
+      bool EndElement(const std::string& qname) override;
+      bool CharData(const char* data, size_t len) override;
+    private:
+      NotifyParser& m_owner;
+    };
+
+    enum MODE
+    {
+      MODE_NONE,
+      MODE_PROPERTY,
+      MODE_LASTCHANGE,
+    };
+
+    std::vector<std::string>& m_subject;
+    OuterHandler m_outerHandler;
+    InnerHandler m_innerHandler;
+    XMLPushParser m_outer;
+    XMLPushParser m_inner;
+    MODE m_mode;
+    bool m_supported;
+    // state of the outer document
+    unsigned m_depth;
+    bool m_stopped;         // a sibling of the properties has been found
+    bool m_hasValue;        // the value of the current property is known
+    bool m_inValue;         // receiving the text of the current property
+    bool m_inLastChange;    // receiving the embedded document
+    // state of the embedded document
+    unsigned m_innerDepth;
+    XMLNames m_names;
+    XMLDict* m_dict;
+    const char* m_type;
+    bool m_hasInstance;
+    bool m_inInstance;
+
+    // prevent copy
+    NotifyParser(const NotifyParser&);
+    NotifyParser& operator=(const NotifyParser&);
+  };
+
+}
+
+#endif /* NOTIFYPARSER_H */
@@ -0,0 +1,249 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "renewalscheduler.h"
+#include "os/threads/timeout.h"
+#include "debug.h"
+
+#include <algorithm>
+
+#define RENEWAL_IDLE_WAIT         60000 // Wait of the timer thread without armed timer
+
+using namespace NSROOT;
+
+OS::Mutex RenewalScheduler::m_instanceLock;
+RenewalScheduler * RenewalScheduler::m_instance = nullptr;
+unsigned RenewalScheduler::m_users = 0;
+
+RenewalScheduler * RenewalScheduler::Acquire()
+{
+  OS::LockGuard lock(m_instanceLock);
+  if (!m_instance)
+  {
+    m_instance = new RenewalScheduler();
+    m_instance->start_thread();
+  }
+  ++m_users;
+  return m_instance;
+}
+
+void RenewalScheduler::Release()
+{
+  OS::LockGuard lock(m_instanceLock);
+  if (m_users > 0 && --m_users == 0)
+  {
+    delete m_instance;
+    m_instance = nullptr;
+  }
+}
+
+RenewalScheduler::RenewalScheduler()
+: OS::Thread()
+, m_epoch(OS::gettime_ms())
+, m_lastId(0)
+, m_random((unsigned)m_epoch)
+{
+  m_pool.set_max_size(RENEWAL_THREADS);
+  m_pool.set_keep_alive(RENEWAL_THREAD_KEEPALIVE);
+  m_pool.start();
+}
+
+RenewalScheduler::~RenewalScheduler()
+{
+  OS::Thread::stop_thread(false);
+  m_event.notify_one();
+  OS::Thread::stop_thread(true);
+}
+
+unsigned RenewalScheduler::Register(Task * task, const std::string& host)
+{
+  OS::LockGuard lock(m_mutex);
+  Job job;
+  job.task = task;
+  job.host = host;
+  job.queued = false;
+  job.again = false;
+  job.idle = true;
+  unsigned id = ++m_lastId;
+  m_jobs.insert(std::make_pair(id, job));
+  return id;
+}
+
+void RenewalScheduler::Unregister(unsigned id)
+{
+  Cancel(id);
+  OS::LockGuard lock(m_mutex);
+  m_jobs.erase(id);
+}
+
+void RenewalScheduler::Schedule(unsigned id, unsigned delay, unsigned jitter)
+{
+  OS::LockGuard lock(m_mutex);
+  if (m_jobs.find(id) == m_jobs.end())
+    return;
+  if (jitter > 0 && delay > 0)
+    delay -= m_random() % (std::min(jitter, delay) + 1);
+  if (delay == 0)
+  {
+    m_wheel.Cancel(id);
+    Fire(id);
+    return;
+  }
+  // the wheel could be late by one tick: count from the current time
+  uint64_t expiry = (uint64_t)(OS::gettime_ms() - m_epoch + delay + RENEWAL_TICK - 1) / RENEWAL_TICK;
+  m_wheel.Schedule(id, (unsigned)(expiry > m_wheel.Now() ? expiry - m_wheel.Now() : 1));
+  m_event.notify_one();
+}
+
+void RenewalScheduler::Cancel(unsigned id)
+{
+  OS::LockGuard lock(m_mutex);
+  std::map<unsigned, Job>::iterator it = m_jobs.find(id);
+  if (it == m_jobs.end())
+    return;
+  Job& job = it->second;
+  m_wheel.Cancel(id);
+  job.again = false;
+  if (job.queued)
+  {
+    job.queued = false;
+    std::map<std::string, Host>::iterator ith = m_hosts.find(job.host);
+    if (ith != m_hosts.end())
+    {
+      std::deque<unsigned>& waiting = ith->second.waiting;
+      waiting.erase(std::remove(waiting.begin(), waiting.end(), id), waiting.end());
+    }
+  }
+  // wait for the running task, unless the task cancels itself
+  if (!job.idle && !OS::thread_equal(job.runner, OS::thread_self()))
+    m_condition.wait(m_mutex, job.idle);
+}
+
+unsigned RenewalScheduler::GetTimerCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return (unsigned)m_wheel.Size();
+}
+
+void* RenewalScheduler::process()
+{
+  while (!OS::Thread::is_stopped())
+  {
+    unsigned wait = RENEWAL_IDLE_WAIT;
+    {
+      OS::LockGuard lock(m_mutex);
+      int64_t elapsed = OS::gettime_ms() - m_epoch;
+      std::vector<unsigned> expired;
+      while (m_wheel.Now() < (uint64_t)(elapsed / RENEWAL_TICK))
+        m_wheel.Tick(expired);
+      for (unsigned id : expired)
+        Fire(id);
+      unsigned ticks = m_wheel.NextTick();
+      if (ticks > 0)
+        wait = (unsigned)((m_wheel.Now() + ticks) * RENEWAL_TICK - elapsed);
+    }
+    m_event.wait_for(wait);
+  }
+  return nullptr;
+}
+
+void RenewalScheduler::Fire(unsigned id)
+{
+  std::map<unsigned, Job>::iterator it = m_jobs.find(id);
+  if (it == m_jobs.end())
+    return;
+  Job& job = it->second;
+  if (!job.idle)
+  {
+    // run it again once done
+    job.again = true;
+    return;
+  }
+  if (job.queued)
+    return;
+  job.queued = true;
+  m_hosts[job.host].waiting.push_back(id);
+  Dispatch(job.host);
+}
+
+void RenewalScheduler::Dispatch(const std::string& name)
+{
+  std::map<std::string, Host>::iterator ith = m_hosts.find(name);
+  if (ith == m_hosts.end())
+    return;
+  Host& host = ith->second;
+  while (host.active < RENEWAL_HOST_CONCURRENCY && !host.waiting.empty())
+  {
+    unsigned id = host.waiting.front();
+    host.waiting.pop_front();
+    RunJob * worker = new RunJob(*this, id, name);
+    ++host.active;
+    if (!m_pool.enqueue(worker))
+    {
+      DBG(DBG_WARN, "%s: scheduler is stopped (%u)\n", __FUNCTION__, id);
+      --host.active;
+      std::map<unsigned, Job>::iterator it = m_jobs.find(id);
+      if (it != m_jobs.end())
+        it->second.queued = false;
+      delete worker;
+    }
+  }
+  if (host.active == 0 && host.waiting.empty())
+    m_hosts.erase(ith);
+}
+
+void RenewalScheduler::RunTask(unsigned id, const std::string& host)
+{
+  Task * task = nullptr;
+  {
+    OS::LockGuard lock(m_mutex);
+    std::map<unsigned, Job>::iterator it = m_jobs.find(id);
+    // the job could have been cancelled meanwhile
+    if (it != m_jobs.end() && it->second.queued && it->second.idle)
+    {
+      Job& job = it->second;
+      job.queued = false;
+      job.idle = false;
+      job.runner = OS::thread_self();
+      task = job.task;
+    }
+  }
+  // Do work
+  if (task)
+    task->Run();
+  OS::LockGuard lock(m_mutex);
+  if (task)
+  {
+    std::map<unsigned, Job>::iterator it = m_jobs.find(id);
+    if (it != m_jobs.end())
+    {
+      it->second.idle = true;
+      m_condition.notify_all();
+      if (it->second.again)
+      {
+        it->second.again = false;
+        Fire(id);
+      }
+    }
+  }
+  --m_hosts[host].active;
+  Dispatch(host);
+}
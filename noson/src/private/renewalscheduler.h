@@ -0,0 +1,152 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef RENEWALSCHEDULER_H
+#define RENEWALSCHEDULER_H
+
+#include "local_config.h"
+#include "timerwheel.h"
+#include "os/threads/thread.h"
+#include "os/threads/threadpool.h"
+
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+
+#define RENEWAL_TICK              100   // Resolution of the timers in millisec
+#define RENEWAL_THREADS           4     // Max workers running the tasks
+#define RENEWAL_THREAD_KEEPALIVE  10000 // Keep alive of idle worker in millisec
+#define RENEWAL_HOST_CONCURRENCY  2     // Max tasks running at once for a host
+
+namespace NSROOT
+{
+
+  /**
+   * The timers of the registered tasks are handled by one thread and a timer
+   * wheel. An expired task is run by a worker of a small pool, but no more
+   * than RENEWAL_HOST_CONCURRENCY tasks run at once for a same host: others
+   * are queued and run in turn. A task is never run twice at once.
+   * The scheduler is shared by all users, and it is created on first demand.
+   */
+  class RenewalScheduler : private OS::Thread
+  {
+  public:
+    class Task
+    {
+    public:
+      virtual ~Task() { }
+      virtual void Run() = 0;
+    };
+
+    /**
+     * Get the shared scheduler. The call must be paired with Release().
+     */
+    static RenewalScheduler * Acquire();
+    static void Release();
+
+    /**
+     * Register a task issuing requests to the given host.
+     * @return the id of the task
+     */
+    unsigned Register(Task * task, const std::string& host);
+
+    /**
+     * Cancel and remove the task.
+     */
+    void Unregister(unsigned id);
+
+    /**
+     * Arm the timer of the task, replacing the previous one. The delay is
+     * shortened by a random value in range [0, jitter], so that tasks armed
+     * at once will be spread.
+     * @param id
+     * @param delay in millisec, 0 to run it now
+     * @param jitter in millisec
+     */
+    void Schedule(unsigned id, unsigned delay, unsigned jitter = 0);
+
+    /**
+     * Disarm the timer and drop the pending run of the task. It returns once
+     * the running task is done, unless called by the task itself.
+     */
+    void Cancel(unsigned id);
+
+    /**
+     * @return the count of armed timers
+     */
+    unsigned GetTimerCount();
+
+  private:
+    RenewalScheduler();
+    ~RenewalScheduler();
+
+    struct Job
+    {
+      Task * task;
+      std::string host;
+      bool queued;            // a run is pending
+      bool again;             // expired while running
+      volatile bool idle;     // no run is in progress
+      OS::thread_t runner;    // the thread of the running task
+    };
+
+    struct Host
+    {
+      unsigned active;
+      std::deque<unsigned> waiting;
+    };
+
+    class RunJob : public OS::Worker
+    {
+    public:
+      RunJob(RenewalScheduler& scheduler, unsigned id, const std::string& host)
+      : m_scheduler(scheduler), m_id(id), m_host(host) { }
+      virtual void process() { m_scheduler.RunTask(m_id, m_host); }
+    private:
+      RenewalScheduler& m_scheduler;
+      unsigned m_id;
+      std::string m_host;
+    };
+
+    OS::Mutex m_mutex;
+    OS::Condition<volatile bool> m_condition;
+    OS::Event m_event;
+    OS::ThreadPool m_pool;
+    TimerWheel m_wheel;
+    int64_t m_epoch;
+    unsigned m_lastId;
+    std::map<unsigned, Job> m_jobs;
+    std::map<std::string, Host> m_hosts;
+    std::minstd_rand m_random;
+
+    virtual void* process();
+    void Fire(unsigned id);
+    void Dispatch(const std::string& host);
+    void RunTask(unsigned id, const std::string& host);
+
+    static OS::Mutex m_instanceLock;
+    static RenewalScheduler * m_instance;
+    static unsigned m_users;
+  };
+}
+
+#endif /* RENEWALSCHEDULER_H */
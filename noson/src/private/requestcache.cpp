@@ -0,0 +1,108 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "requestcache.h"
+
+using namespace NSROOT;
+
+RequestCache& RequestCache::Instance()
+{
+  static RequestCache _instance;
+  return _instance;
+}
+
+bool RequestCache::Acquire(const std::string& scope, const std::string& key, ElementList& vars)
+{
+  OS::LockGuard lock(m_mutex);
+  Scope& s = m_scopes[scope];
+  std::map<std::string, Entry>::iterator ie = s.entries.find(key);
+  if (ie != s.entries.end())
+  {
+    if (ie->second.expiry.time_left() > 0)
+    {
+      vars = ie->second.vars;
+      ++m_hits;
+      return true;
+    }
+    s.entries.erase(ie);
+  }
+  std::map<std::string, FlightPtr>::iterator it = s.flights.find(key);
+  if (it != s.flights.end())
+  {
+    // join the request in flight
+    FlightPtr flight = it->second;
+    m_condition.wait(m_mutex, flight->done);
+    vars = flight->vars;
+    ++m_hits;
+    return true;
+  }
+  FlightPtr flight(new Flight());
+  flight->generation = s.generation;
+  s.flights.insert(std::make_pair(key, flight));
+  return false;
+}
+
+void RequestCache::Finish(const std::string& scope, const std::string& key, const ElementList& vars, unsigned ttl)
+{
+  OS::LockGuard lock(m_mutex);
+  Scope& s = m_scopes[scope];
+  std::map<std::string, FlightPtr>::iterator it = s.flights.find(key);
+  if (it == s.flights.end())
+    return;
+  FlightPtr flight = it->second;
+  s.flights.erase(it);
+  // the response could be outdated by a change of state
+  if (ttl > 0 && flight->generation == s.generation)
+  {
+    // purge the expired responses
+    std::map<std::string, Entry>::iterator ie = s.entries.begin();
+    while (ie != s.entries.end())
+    {
+      if (ie->second.expiry.time_left() == 0)
+        s.entries.erase(ie++);
+      else
+        ++ie;
+    }
+    Entry& entry = s.entries[key];
+    entry.expiry.set(ttl);
+    entry.vars = vars;
+  }
+  flight->vars = vars;
+  flight->done = true;
+  m_condition.notify_all();
+}
+
+void RequestCache::Invalidate(const std::string& scope)
+{
+  OS::LockGuard lock(m_mutex);
+  std::map<std::string, Scope>::iterator it = m_scopes.find(scope);
+  if (it != m_scopes.end())
+  {
+    ++it->second.generation;
+    it->second.entries.clear();
+  }
+}
+
+unsigned RequestCache::GetHitCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_hits;
+}
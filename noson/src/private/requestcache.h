@@ -0,0 +1,119 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef REQUESTCACHE_H
+#define REQUESTCACHE_H
+
+#include "local_config.h"
+#include "os/threads/mutex.h"
+#include "os/threads/condition.h"
+#include "os/threads/timeout.h"
+#include "../element.h"
+#include "../sharedptr.h"
+
+#include <map>
+#include <string>
+
+#define REQUEST_CACHE_TTL   1000  // Lifetime of a cached response in millisec
+
+namespace NSROOT
+{
+
+  /**
+   * The cache shares the responses of the read-only actions. The identical
+   * requests issued at once by several callers share one request in flight,
+   * and the response is kept for a short time. The responses are grouped
+   * by scope, i.e the service of a device, so that a change of state can
+   * invalidate all of them.
+   * The cache is shared by all the services, and it is created on first
+   * demand.
+   */
+  class RequestCache
+  {
+  public:
+    static RequestCache& Instance();
+
+    /**
+     * Look up the response for the key. Whenever a request is in flight for
+     * the key, it waits for the response of this request.
+     * @param scope the scope of the key
+     * @param key the key of the request
+     * @param vars the response, if found
+     * @return true if the response is found, else false and the caller must
+     * send the request, then call Finish() with the response
+     */
+    bool Acquire(const std::string& scope, const std::string& key, ElementList& vars);
+
+    /**
+     * Share the response with the waiters, and keep it for the ttl unless the
+     * scope has been invalidated since the call to Acquire().
+     * @param ttl the lifetime in millisec, zero to not keep the response
+     */
+    void Finish(const std::string& scope, const std::string& key, const ElementList& vars, unsigned ttl);
+
+    /**
+     * Drop the responses of the scope.
+     */
+    void Invalidate(const std::string& scope);
+
+    /**
+     * @return the count of responses found since start
+     */
+    unsigned GetHitCount();
+
+  private:
+    RequestCache() : m_hits(0) { }
+    ~RequestCache() { }
+    RequestCache(const RequestCache&);
+    RequestCache& operator=(const RequestCache&);
+
+    struct Flight
+    {
+      unsigned generation;
+      volatile bool done;
+      ElementList vars;
+      Flight() : generation(0), done(false), vars() { }
+    };
+
+    typedef SHARED_PTR<Flight> FlightPtr;
+
+    struct Entry
+    {
+      OS::Timeout expiry;
+      ElementList vars;
+    };
+
+    struct Scope
+    {
+      unsigned generation;
+      std::map<std::string, FlightPtr> flights;
+      std::map<std::string, Entry> entries;
+      Scope() : generation(0) { }
+    };
+
+    OS::Mutex m_mutex;
+    OS::Condition<volatile bool> m_condition;
+    std::map<std::string, Scope> m_scopes;
+    unsigned m_hits;
+  };
+}
+
+#endif /* REQUESTCACHE_H */
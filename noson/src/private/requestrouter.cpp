@@ -0,0 +1,140 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "requestrouter.h"
+
+using namespace NSROOT;
+
+namespace
+{
+void push_unique(RequestRouter::Candidates& list, const RequestBrokerPtr& rb)
+{
+  for (const RequestBrokerPtr& e : list)
+  {
+    if (e.get() == rb.get())
+      return;
+  }
+  list.push_back(rb);
+}
+}
+
+RequestRouter::RequestRouter()
+: m_table(TablePtr(Build(std::vector<RequestBrokerPtr>())))
+{
+}
+
+RequestRouter::~RequestRouter()
+{
+}
+
+void RequestRouter::Update(const std::vector<RequestBrokerPtr>& brokers)
+{
+  TablePtr table(Build(brokers));
+  // the replaced table is released with the last selection made from it
+  m_table.Store(table);
+}
+
+RequestRouter::Selection RequestRouter::Route(WS_METHOD method, const std::string& path) const
+{
+  // the shared pointer cannot be loaded atomically, so the lock guards
+  // the copy of the reference only
+  TablePtr table = m_table.Load();
+  const std::vector<Table::Node>& trie = table->tries[
+          (method < WS_METHOD_UNKNOWN ? method : WS_METHOD_UNKNOWN)];
+  unsigned n = 0;
+  for (char c : path)
+  {
+    unsigned child = 0;
+    for (const std::pair<char, unsigned>& e : trie[n].next)
+    {
+      if (e.first == c)
+      {
+        child = e.second;
+        break;
+      }
+    }
+    if (child == 0)
+      break;
+    n = child;
+  }
+  return Selection(table, &trie[n].candidates);
+}
+
+RequestRouter::Table* RequestRouter::Build(const std::vector<RequestBrokerPtr>& brokers)
+{
+  Table* table = new Table();
+  std::vector<RequestBroker::RouteList> routes;
+  routes.reserve(brokers.size());
+  Candidates fallback;
+  for (const RequestBrokerPtr& rb : brokers)
+  {
+    routes.push_back(rb->GetRoutes());
+    if (routes.back().empty())
+      fallback.push_back(rb);
+  }
+
+  for (int m = 0; m <= WS_METHOD_UNKNOWN; ++m)
+  {
+    std::vector<Table::Node>& trie = table->tries[m];
+    std::vector<unsigned> parents;
+    trie.push_back(Table::Node());
+    parents.push_back(0);
+    for (size_t i = 0; i < brokers.size(); ++i)
+    {
+      for (const RequestBroker::Route& route : routes[i])
+      {
+        if (!route.method.empty() && ws_method_from_str(route.method.c_str()) != m)
+          continue;
+        unsigned n = 0;
+        for (char c : route.prefix)
+        {
+          unsigned child = 0;
+          for (const std::pair<char, unsigned>& e : trie[n].next)
+          {
+            if (e.first == c)
+            {
+              child = e.second;
+              break;
+            }
+          }
+          if (child == 0)
+          {
+            child = (unsigned)trie.size();
+            trie[n].next.push_back(std::make_pair(c, child));
+            trie.push_back(Table::Node());
+            parents.push_back(n);
+          }
+          n = child;
+        }
+        push_unique(trie[n].candidates, brokers[i]);
+      }
+    }
+    // a node inherits the candidates of the shorter prefixes, then the
+    // fallback. The parent of a node is always built before it.
+    for (unsigned n = 0; n < trie.size(); ++n)
+    {
+      const Candidates& base = (n == 0 ? fallback : trie[parents[n]].candidates);
+      for (const RequestBrokerPtr& rb : base)
+        push_unique(trie[n].candidates, rb);
+    }
+  }
+  return table;
+}
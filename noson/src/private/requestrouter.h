@@ -0,0 +1,112 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef REQUESTROUTER_H
+#define REQUESTROUTER_H
+
+#include "local_config.h"
+#include "wsstatic.h"
+#include "../requestbroker.h"
+#include "../locked.h"
+
+#include <string>
+#include <vector>
+
+namespace NSROOT
+{
+
+  /**
+   * The router selects the request brokers matching the method and path of a
+   * request. The brokers declare their routes, which are compiled into a
+   * prefix tree for each method. The routing table is immutable: it is
+   * replaced on update, so the lookup allocates nothing and holds the lock
+   * only to copy the reference to the current table, never while matching.
+   */
+  class RequestRouter
+  {
+  public:
+    typedef std::vector<RequestBrokerPtr> Candidates;
+
+  private:
+    struct Table
+    {
+      struct Node
+      {
+        std::vector<std::pair<char, unsigned> > next;
+        Candidates candidates;
+      };
+      // one prefix tree by method, the root is the first node
+      std::vector<Node> tries[WS_METHOD_UNKNOWN + 1];
+    };
+    typedef SHARED_PTR<const Table> TablePtr;
+
+  public:
+    /**
+     * The brokers selected for a request. The selection holds the table it
+     * was taken from, so a replaced table and its brokers are released with
+     * the last selection made from it.
+     */
+    class Selection
+    {
+    public:
+      const Candidates& operator*() const { return *m_candidates; }
+      const Candidates* operator->() const { return m_candidates; }
+    private:
+      friend class RequestRouter;
+      Selection(const TablePtr& table, const Candidates* candidates)
+      : m_table(table), m_candidates(candidates) { }
+      TablePtr m_table;
+      const Candidates* m_candidates;
+    };
+
+    RequestRouter();
+    ~RequestRouter();
+
+    /**
+     * Build and publish a new routing table for the given brokers. The brokers
+     * without declared route are candidates for every request, after the
+     * routed ones.
+     * @param brokers the registered brokers
+     */
+    void Update(const std::vector<RequestBrokerPtr>& brokers);
+
+    /**
+     * Return the brokers to try for the request, the longest matching prefix
+     * first. The list remains valid as long as the selection is held.
+     * @param method the request method
+     * @param path the request path
+     * @return the selection of candidates
+     */
+    Selection Route(WS_METHOD method, const std::string& path) const;
+
+  private:
+    mutable Locked<TablePtr> m_table;
+
+    static Table* Build(const std::vector<RequestBrokerPtr>& brokers);
+
+    // prevent copy
+    RequestRouter(const RequestRouter&);
+    RequestRouter& operator=(const RequestRouter&);
+  };
+
+}
+
+#endif /* REQUESTROUTER_H */
@@ -20,9 +20,12 @@
  */
 
 #include "securesocket.h"
+#include "wsconnectionpool.h"
 #include "debug.h"
+#include "os/threads/mutex.h"
 
 #include <errno.h>
+#include <map>
 
 #ifdef __WINDOWS__
 #include <WinSock2.h>
@@ -46,6 +49,8 @@ SSLSessionFactory& SSLSessionFactory::Instance()
 
 void SSLSessionFactory::Destroy()
 {
+  // the pooled connections could be secure
+  WSConnectionPool::Instance().Clear();
   if (m_instance)
     delete m_instance;
   m_instance = nullptr;
@@ -62,9 +67,18 @@ void SSLSessionFactory::Destroy()
 /* Cipher suites, https://www.openssl.org/docs/apps/ciphers.html */
 const char* const PREFERRED_CIPHERS = "HIGH:!aNULL:!PSK:!SRP:!MD5:!RC4:!CAMELLIA:!DSS";
 
+struct SSLSessionFactory::SessionStore
+{
+  OS::Mutex mutex;
+  std::map<std::string, SSL_SESSION*> sessions;
+  unsigned handshakes = 0;
+  unsigned resumed = 0;
+};
+
 SSLSessionFactory::SSLSessionFactory()
 : m_client_ctx(nullptr)
 , m_enabled(false)
+, m_sessions(new SessionStore())
 {
   if (SSL_library_init() < 0)
     DBG(DBG_ERROR, "%s: Could not initialize the SSL library\n", __FUNCTION__);
@@ -106,6 +120,15 @@ SSLSessionFactory::SSLSessionFactory()
       /* The SSL trace callback is only used for verbose logging */
       /* SSL_CTX_set_msg_callback(ctx, ssl_trace); */
 
+      /* The client sessions are kept by peer (host:port), so the next
+       * connection to the same peer can resume the session with an
+       * abbreviated handshake (session ticket or session id).
+       */
+      SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(ctx, [](SSL* ssl, SSL_SESSION* session) -> int {
+        return NewSessionCallback(ssl, session);
+      });
+
       m_client_ctx = ctx;
       m_enabled = true;
       DBG(DBG_DEBUG, "%s: SSL has been initialized\n", __FUNCTION__);
@@ -115,6 +138,8 @@ SSLSessionFactory::SSLSessionFactory()
 
 SSLSessionFactory::~SSLSessionFactory()
 {
+  ClearSessions();
+  delete m_sessions;
   if (m_client_ctx)
     SSL_CTX_free(static_cast<SSL_CTX*>(m_client_ctx));
   ERR_free_strings();
@@ -137,6 +162,97 @@ SecureSocket* SSLSessionFactory::NewClientSocket()
   return new SecureSocket(ssl);
 }
 
+unsigned SSLSessionFactory::GetHandshakeCount() const
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  return m_sessions->handshakes;
+}
+
+unsigned SSLSessionFactory::GetResumedCount() const
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  return m_sessions->resumed;
+}
+
+void SSLSessionFactory::ClearSessions()
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  for (std::map<std::string, SSL_SESSION*>::iterator it = m_sessions->sessions.begin(); it != m_sessions->sessions.end(); ++it)
+    SSL_SESSION_free(it->second);
+  m_sessions->sessions.clear();
+}
+
+int SSLSessionFactory::NewSessionCallback(void* ssl, void* session)
+{
+  /* With TLS 1.3 the tickets are received after the handshake, while
+   * reading the first response. The socket is retrieved from the app data.
+   */
+  SecureSocket* socket = static_cast<SecureSocket*>(SSL_get_app_data(static_cast<SSL*>(ssl)));
+  if (!socket || socket->m_sessionKey.empty())
+    return 0;
+  Instance().StoreSession(socket->m_sessionKey, session);
+  /* the callback retains the reference */
+  return 1;
+}
+
+void* SSLSessionFactory::GetSession(const std::string& key)
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions->sessions.find(key);
+  if (it == m_sessions->sessions.end())
+    return nullptr;
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+  if (!SSL_SESSION_is_resumable(it->second))
+  {
+    SSL_SESSION_free(it->second);
+    m_sessions->sessions.erase(it);
+    return nullptr;
+  }
+#endif
+  /* the caller must release the returned reference */
+  SSL_SESSION_up_ref(it->second);
+  return it->second;
+}
+
+void SSLSessionFactory::StoreSession(const std::string& key, void* session)
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions->sessions.find(key);
+  if (it != m_sessions->sessions.end())
+  {
+    SSL_SESSION_free(it->second);
+    it->second = static_cast<SSL_SESSION*>(session);
+    return;
+  }
+  /* the peers are few: flush all when full rather than tracking usage */
+  if (m_sessions->sessions.size() >= SSL_SESSION_CACHE_MAXSIZE)
+  {
+    for (it = m_sessions->sessions.begin(); it != m_sessions->sessions.end(); ++it)
+      SSL_SESSION_free(it->second);
+    m_sessions->sessions.clear();
+  }
+  m_sessions->sessions.insert(std::make_pair(key, static_cast<SSL_SESSION*>(session)));
+}
+
+void SSLSessionFactory::RemoveSession(const std::string& key)
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions->sessions.find(key);
+  if (it != m_sessions->sessions.end())
+  {
+    SSL_SESSION_free(it->second);
+    m_sessions->sessions.erase(it);
+  }
+}
+
+void SSLSessionFactory::CountHandshake(bool resumed)
+{
+  OS::LockGuard lock(m_sessions->mutex);
+  ++m_sessions->handshakes;
+  if (resumed)
+    ++m_sessions->resumed;
+}
+
 SSLServerContext::~SSLServerContext()
 {
   if (m_server_ctx)
@@ -263,10 +379,22 @@ bool SecureSocket::Connect(const char* server, unsigned port, int rcvbuf)
   if (!TcpSocket::Connect(server, port, rcvbuf))
     return false;
 
-  /* setup SSL */
+  /* setup SSL: the handle could have been used by a previous connection */
+  SSL_clear(static_cast<SSL*>(m_ssl));
   SSL_set_fd(static_cast<SSL*>(m_ssl), m_socket);
   SSL_set_tlsext_host_name(static_cast<SSL*>(m_ssl), server); /* fix SNI */
 
+  /* try to resume the last session with this peer */
+  SSLSessionFactory& factory = SSLSessionFactory::Instance();
+  m_sessionKey.assign(server).append(":").append(std::to_string(port));
+  SSL_set_app_data(static_cast<SSL*>(m_ssl), this);
+  SSL_SESSION* session = static_cast<SSL_SESSION*>(factory.GetSession(m_sessionKey));
+  if (session)
+  {
+    SSL_set_session(static_cast<SSL*>(m_ssl), session);
+    SSL_SESSION_free(session);
+  }
+
   /* do SSL handshake */
   for (;;)
   {
@@ -284,10 +412,13 @@ bool SecureSocket::Connect(const char* server, unsigned port, int rcvbuf)
     }
     m_ssl_error = ERR_get_error();
     DBG(DBG_ERROR, "%s: SSL connect failed: %s\n", __FUNCTION__, GetSSLError());
+    factory.RemoveSession(m_sessionKey);
     TcpSocket::Disconnect();
     return false;
   }
-  DBG(DBG_PROTO, "%s: SSL handshake initialized\n", __FUNCTION__);
+  bool resumed = (SSL_session_reused(static_cast<SSL*>(m_ssl)) == 1);
+  factory.CountHandshake(resumed);
+  DBG(DBG_PROTO, "%s: SSL handshake initialized (%s)\n", __FUNCTION__, resumed ? "resumed" : "full");
   m_connected = true;
   /* check for a valid certificate */
   std::string str("");
@@ -305,6 +436,7 @@ size_t SecureSocket::ReceiveData(void* buf, size_t n)
   if (m_connected && n > 0)
   {
     m_ssl_error = SSL_ERROR_NONE;
+    m_errno = 0;
     for (;;)
     {
       if (SSL_pending(static_cast<SSL*>(m_ssl)) == 0)
@@ -328,8 +460,14 @@ size_t SecureSocket::ReceiveData(void* buf, size_t n)
       }
 
       int r = SSL_read(static_cast<SSL*>(m_ssl), buf, (int) n);
-      if (r >= 0)
+      if (r > 0)
         return (size_t) r;
+      if (r == 0)
+      {
+        // the peer has closed the connection
+        m_errno = ECONNRESET;
+        return 0;
+      }
       int err = SSL_get_error(static_cast<SSL*>(m_ssl), r);
       if (err == SSL_ERROR_WANT_READ)
       {
@@ -410,6 +548,12 @@ bool SecureSocket::SendData(const char* buf, size_t size)
   return false;
 }
 
+bool SecureSocket::SendFile(FILE* file, uint64_t offset, size_t size)
+{
+  // the data must be encrypted before sending, so zero-copy is not possible
+  return SendFileBuffered(file, offset, size);
+}
+
 void SecureSocket::Disconnect()
 {
   if (m_connected)
@@ -457,6 +601,7 @@ const char* SecureSocket::GetSSLError()
 SSLSessionFactory::SSLSessionFactory()
 : m_client_ctx(nullptr)
 , m_enabled(false)
+, m_sessions(nullptr)
 {
   DBG(DBG_INFO, "%s: SSL feature is disabled\n", __FUNCTION__);
 }
@@ -470,6 +615,20 @@ SecureSocket* SSLSessionFactory::NewClientSocket()
   return nullptr;
 }
 
+unsigned SSLSessionFactory::GetHandshakeCount() const
+{
+  return 0;
+}
+
+unsigned SSLSessionFactory::GetResumedCount() const
+{
+  return 0;
+}
+
+void SSLSessionFactory::ClearSessions()
+{
+}
+
 SSLServerContext::~SSLServerContext()
 {
 }
@@ -531,6 +690,14 @@ bool SecureSocket::SendData(const char* buf, size_t size)
   return false;
 }
 
+bool SecureSocket::SendFile(FILE* file, uint64_t offset, size_t size)
+{
+  (void)file;
+  (void)offset;
+  (void)size;
+  return false;
+}
+
 void SecureSocket::Disconnect()
 {
 }
@@ -26,12 +26,15 @@
 
 #include <string>
 
+#define SSL_SESSION_CACHE_MAXSIZE     32
+
 namespace NSROOT
 {
   class SecureSocket;
 
   class SSLSessionFactory
   {
+    friend class SecureSocket;
   public:
     static SSLSessionFactory& Instance();
     static void Destroy();
@@ -44,6 +47,23 @@ namespace NSROOT
      */
     SecureSocket* NewClientSocket();
 
+    /**
+     * Count the client handshakes completed since the start.
+     * @return the number of handshakes
+     */
+    unsigned GetHandshakeCount() const;
+
+    /**
+     * Count the client handshakes that resumed a cached session.
+     * @return the number of abbreviated handshakes
+     */
+    unsigned GetResumedCount() const;
+
+    /**
+     * Drop the client sessions cached so far.
+     */
+    void ClearSessions();
+
   private:
     SSLSessionFactory();
     ~SSLSessionFactory();
@@ -53,6 +73,15 @@ namespace NSROOT
     static SSLSessionFactory* m_instance;
     void* m_client_ctx;       ///< SSL default client context
     bool m_enabled;           ///< SSL feature status
+
+    struct SessionStore;
+    SessionStore* m_sessions; ///< client sessions keyed by host:port
+
+    static int NewSessionCallback(void* ssl, void* session);
+    void* GetSession(const std::string& key);
+    void StoreSession(const std::string& key, void* session);
+    void RemoveSession(const std::string& key);
+    void CountHandshake(bool resumed);
   };
 
   class SSLServerContext
@@ -109,6 +138,7 @@ namespace NSROOT
     // Overrides TcpSocket
     bool Connect(const char *server, unsigned port, int rcvbuf);
     bool SendData(const char* buf, size_t size);
+    bool SendFile(FILE* file, uint64_t offset, size_t size);
     size_t ReceiveData(void* buf, size_t n);
     size_t BlockingRead(void* buf, size_t n);
     void Disconnect();
@@ -121,6 +151,7 @@ namespace NSROOT
     SecureSocket(void* ssl);
 
     void* m_ssl;      ///< SSL handle
+    std::string m_sessionKey; ///< key of the client session (host:port)
     void* m_cert;     ///< X509 certificate
     bool m_connected; ///< SSL session state
     int m_ssl_error;  ///< SSL error code
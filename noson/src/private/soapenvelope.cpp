@@ -0,0 +1,77 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "soapenvelope.h"
+#include "os/threads/mutex.h"
+
+#include <map>
+
+#define NS_PREFIX               "urn:schemas-upnp-org:service:"
+#define NS_SUFFIX               ":1"
+#define SOAP_ENVELOPE_NAMESPACE "http://schemas.xmlsoap.org/soap/envelope/"
+#define SOAP_ENCODING_NAMESPACE "http://schemas.xmlsoap.org/soap/encoding/"
+#define SOAP_ARG_OVERHEAD       5   // Length of the tags of an argument, the key apart
+
+using namespace NSROOT;
+
+const SOAPEnvelope& SOAPEnvelope::Get(const std::string& serviceName, const std::string& action)
+{
+  static OS::Mutex _lock;
+  static std::map<std::string, SOAPEnvelope> _envelopes;
+  std::string key(serviceName);
+  key.append("#").append(action);
+  OS::LockGuard lock(_lock);
+  std::map<std::string, SOAPEnvelope>::iterator it = _envelopes.find(key);
+  if (it == _envelopes.end())
+    it = _envelopes.insert(std::make_pair(key, SOAPEnvelope(serviceName, action))).first;
+  return it->second;
+}
+
+SOAPEnvelope::SOAPEnvelope(const std::string& serviceName, const std::string& action)
+{
+  m_soapAction.append("\"" NS_PREFIX).append(serviceName).append(NS_SUFFIX "#").append(action).append("\"");
+
+  m_head.append("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
+  // start envelope
+  m_head.append("<s:Envelope xmlns:s=\"" SOAP_ENVELOPE_NAMESPACE "\" s:encodingStyle=\"" SOAP_ENCODING_NAMESPACE "\">");
+  // start body
+  m_head.append("<s:Body>");
+  m_head.append("<u:").append(action).append(" xmlns:u=\"" NS_PREFIX).append(serviceName).append(NS_SUFFIX "\">");
+
+  m_tail.append("</u:").append(action).append(">");
+  // end body
+  m_tail.append("</s:Body>");
+  // end envelope
+  m_tail.append("</s:Envelope>");
+}
+
+void SOAPEnvelope::Build(const ElementList& args, std::string& out) const
+{
+  // the size without escape, so the buffer is allocated once
+  size_t size = m_head.size() + m_tail.size();
+  for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
+    size += SOAP_ARG_OVERHEAD + 2 * (*it)->GetKey().size() + (*it)->size();
+  out.reserve(out.size() + size);
+  out.append(m_head);
+  for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
+    (*it)->AppendXML(out);
+  out.append(m_tail);
+}
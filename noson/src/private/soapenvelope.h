@@ -0,0 +1,64 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef SOAPENVELOPE_H
+#define SOAPENVELOPE_H
+
+#include "local_config.h"
+#include "../element.h"
+
+#include <string>
+
+namespace NSROOT
+{
+
+  /**
+   * The precompiled envelope of a SOAP action. The fixed parts of the
+   * envelope and the value of the header SOAPAction are made once per action,
+   * then the arguments are escaped in place into the output.
+   */
+  class SOAPEnvelope
+  {
+  public:
+    /**
+     * Get the envelope of the action. It is made on first demand and kept.
+     * @param serviceName the name of the service, i.e "AVTransport"
+     * @param action the name of the action
+     */
+    static const SOAPEnvelope& Get(const std::string& serviceName, const std::string& action);
+
+    const std::string& GetSOAPAction() const { return m_soapAction; }
+
+    /**
+     * Build the envelope with the arguments into the output.
+     */
+    void Build(const ElementList& args, std::string& out) const;
+
+  private:
+    SOAPEnvelope(const std::string& serviceName, const std::string& action);
+
+    std::string m_soapAction;
+    std::string m_head;
+    std::string m_tail;
+  };
+}
+
+#endif /* SOAPENVELOPE_H */
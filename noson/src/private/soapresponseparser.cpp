@@ -0,0 +1,225 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "soapresponseparser.h"
+#include "xmldict.h"
+#include "debug.h"
+
+using namespace NSROOT;
+
+SOAPResponseParser::SOAPResponseParser(ElementList& vars, bool dumpTrees)
+: m_vars(vars)
+, m_dumpTrees(dumpTrees)
+, m_handler(*this)
+, m_parser(m_handler)
+, m_depth(0)
+, m_bodySeen(false)
+, m_inBody(false)
+, m_tagSeen(false)
+, m_inResponse(false)
+, m_fault(false)
+, m_inDetail(false)
+, m_detailSeen(false)
+, m_inDetailValue(false)
+, m_value()
+, m_valueDepth(0)
+, m_dumping(false)
+, m_skipping(false)
+, m_startTag()
+{
+}
+
+bool SOAPResponseParser::Feed(const char* data, size_t len)
+{
+  return m_parser.Feed(data, len);
+}
+
+bool SOAPResponseParser::Finish()
+{
+  return m_parser.Finish();
+}
+
+bool SOAPResponseParser::ParserHandler::StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+{
+  SOAPResponseParser& p = m_owner;
+  unsigned depth = p.m_depth++;
+  if (p.m_value)
+  {
+    // a child of the value
+    if (p.m_skipping)
+      return true;
+    if (!p.m_dumpTrees)
+    {
+      p.m_skipping = true;
+      return true;
+    }
+    if (!p.m_dumping)
+    {
+      // restart the value with the dump of its start tag
+      std::string text;
+      text.swap(*p.m_value);
+      p.m_value->assign(p.m_startTag);
+      AppendEscaped(*p.m_value, text.data(), text.size());
+      p.m_dumping = true;
+    }
+    AppendStartTag(*p.m_value, qname, attrs, count);
+    return true;
+  }
+  switch (depth)
+  {
+  case 0:
+    return XMLNS::NameEqual(qname.c_str(), "Envelope");
+  case 1:
+    p.m_inBody = (!p.m_bodySeen && XMLNS::NameEqual(qname.c_str(), "Body"));
+    if (p.m_inBody)
+      p.m_bodySeen = true;
+    return true;
+  case 2:
+    if (p.m_inBody && !p.m_tagSeen)
+    {
+      p.m_tagSeen = true;
+      p.m_inResponse = true;
+      p.m_vars.push_back(ElementPtr(new Element("TAG", XMLNS::LocalName(qname.c_str()))));
+      p.m_fault = (p.m_vars.back()->compare("Fault") == 0);
+    }
+    return true;
+  case 3:
+    if (!p.m_inResponse)
+      return true;
+    if (!p.m_fault)
+      p.StartValue(qname, attrs, count);
+    else if (XMLNS::NameEqual(qname.c_str(), "faultcode") || XMLNS::NameEqual(qname.c_str(), "faultstring"))
+      p.StartValue(qname, attrs, count);
+    else if (XMLNS::NameEqual(qname.c_str(), "detail"))
+      p.m_inDetail = true;
+    return true;
+  case 4:
+    // only the first element of the detail
+    if (p.m_inDetail && !p.m_detailSeen)
+    {
+      p.m_detailSeen = true;
+      p.m_inDetailValue = true;
+    }
+    return true;
+  case 5:
+    if (p.m_inDetailValue)
+      p.StartValue(qname, attrs, count);
+    return true;
+  default:
+    return true;
+  }
+}
+
+bool SOAPResponseParser::ParserHandler::EndElement(const std::string& qname)
+{
+  SOAPResponseParser& p = m_owner;
+  unsigned depth = --p.m_depth;
+  if (p.m_value)
+  {
+    if (p.m_dumping)
+      p.m_value->append("</").append(qname).append(">");
+    if (depth == p.m_valueDepth)
+      p.EndValue();
+    return true;
+  }
+  switch (depth)
+  {
+  case 1:
+    p.m_inBody = false;
+    break;
+  case 2:
+    p.m_inResponse = false;
+    break;
+  case 3:
+    p.m_inDetail = false;
+    break;
+  case 4:
+    p.m_inDetailValue = false;
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+bool SOAPResponseParser::ParserHandler::CharData(const char* data, size_t len)
+{
+  SOAPResponseParser& p = m_owner;
+  if (!p.m_value || p.m_skipping)
+    return true;
+  if (p.m_dumping)
+    AppendEscaped(*p.m_value, data, len);
+  else
+    p.m_value->append(data, len);
+  return true;
+}
+
+void SOAPResponseParser::StartValue(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+{
+  // remove the namespace qualifier to handle local name as key
+  m_value.reset(new Element(XMLNS::LocalName(qname.c_str())));
+  m_valueDepth = m_depth - 1;
+  m_dumping = false;
+  m_skipping = false;
+  if (m_dumpTrees)
+  {
+    m_startTag.clear();
+    AppendStartTag(m_startTag, qname, attrs, count);
+  }
+}
+
+void SOAPResponseParser::EndValue()
+{
+  if (!m_skipping && !m_value->empty())
+  {
+    m_vars.push_back(m_value);
+    DBG(DBG_PROTO, "%s: %s%s = %s\n", __FUNCTION__, (m_fault ? "[fault] " : ""), m_value->GetKey().c_str(), m_value->c_str());
+  }
+  m_value.reset();
+}
+
+void SOAPResponseParser::AppendStartTag(std::string& out, const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count)
+{
+  out.append("<").append(qname);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    out.append(" ").append(attrs[i].name).append("=\"");
+    AppendEscaped(out, attrs[i].value.data(), attrs[i].value.size());
+    out.append("\"");
+  }
+  out.append(">");
+}
+
+void SOAPResponseParser::AppendEscaped(std::string& out, const char* data, size_t len)
+{
+  const char* end = data + len;
+  for (const char* p = data; p < end; ++p)
+  {
+    switch (*p)
+    {
+    case '&': out.append("&amp;"); break;
+    case '<': out.append("&lt;"); break;
+    case '>': out.append("&gt;"); break;
+    case '"': out.append("&quot;"); break;
+    default: out.push_back(*p); break;
+    }
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef SOAPRESPONSEPARSER_H
+#define SOAPRESPONSEPARSER_H
+
+#include "local_config.h"
+#include "xmlpushparser.h"
+#include "../element.h"
+
+#include <string>
+
+namespace NSROOT
+{
+
+  /**
+   * Decode the response of a SOAP action while it is received. Only the
+   * children of the element Envelope/Body/{respTag} are kept, so neither the
+   * body nor a tree is stored. The list of values is filled as follows:
+   * ("TAG", respTag), (name1, text1), ...
+   * The elements without text are omitted. For a fault, the values are the
+   * faultcode, the faultstring, and the children of the first element of the
+   * detail.
+   * The text of a value is decoded once into its element.
+   */
+  class SOAPResponseParser
+  {
+  public:
+    /**
+     * @param vars the list to fill
+     * @param dumpTrees true to keep a value having child elements as its XML
+     * dump, else such value is omitted
+     */
+    SOAPResponseParser(ElementList& vars, bool dumpTrees = false);
+    ~SOAPResponseParser() { }
+
+    /**
+     * Parse the next chunk of the response.
+     * @return false if the content is invalid, else true
+     */
+    bool Feed(const char* data, size_t len);
+
+    /**
+     * Terminate the parsing.
+     * @return false if the content is invalid, else true
+     */
+    bool Finish();
+
+    /**
+     * @return true if the element Envelope/Body/{respTag} has been found
+     */
+    bool IsSOAP() const { return m_tagSeen; }
+
+    /**
+     * @return true if the response is a fault
+     */
+    bool IsFault() const { return m_fault; }
+
+  private:
+    class ParserHandler : public XMLPushParser::Handler
+    {
+    public:
+      ParserHandler(SOAPResponseParser& owner) : m_owner(owner) { }
+      bool StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count) override;
+      bool EndElement(const std::string& qname) override;
+      bool CharData(const char* data, size_t len) override;
+    private:
+      SOAPResponseParser& m_owner;
+    };
+
+    ElementList& m_vars;
+    bool m_dumpTrees;
+    ParserHandler m_handler;
+    XMLPushParser m_parser;
+    unsigned m_depth;
+    bool m_bodySeen;
+    bool m_inBody;
+    bool m_tagSeen;
+    bool m_inResponse;
+    bool m_fault;
+    bool m_inDetail;
+    bool m_detailSeen;
+    bool m_inDetailValue;
+    // the value in progress
+    ElementPtr m_value;
+    unsigned m_valueDepth;
+    bool m_dumping;
+    bool m_skipping;
+    std::string m_startTag;
+
+    void StartValue(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count);
+    void EndValue();
+    static void AppendStartTag(std::string& out, const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count);
+    static void AppendEscaped(std::string& out, const char* data, size_t len);
+  };
+
+}
+
+#endif /* SOAPRESPONSEPARSER_H */
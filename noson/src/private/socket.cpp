@@ -21,10 +21,14 @@
 
 #include "socket.h"
 #include "debug.h"
+#include "os/threads/mutex.h"
+#include "os/threads/timeout.h"
 
 #include <errno.h>
 #include <cstdio>
 #include <cstring>
+#include <map>
+#include <vector>
 
 #ifdef __WINDOWS__
 #include <WS2tcpip.h>
@@ -34,6 +38,7 @@
 #define ERRNO_INTR WSAEINTR
 typedef int socklen_t;
 typedef IN_ADDR in_addr_t;
+#define fseek64 _fseeki64
 
 #else
 #include <unistd.h>
@@ -47,8 +52,13 @@ typedef IN_ADDR in_addr_t;
 #define closesocket(a) close(a)
 #define LASTERROR errno
 #define ERRNO_INTR EINTR
+#define fseek64 fseeko
 #endif /* __WINDOWS__ */
 
+#if HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
 #include <signal.h>
 
 using namespace NSROOT;
@@ -86,6 +96,149 @@ namespace NSROOT
     }
   };
 
+  struct ResolvedAddress
+  {
+    int family;
+    int socktype;
+    int protocol;
+    SocketAddress addr;
+  };
+
+  struct ResolverEntry
+  {
+    OS::Timeout expiry;
+    int error;
+    std::vector<ResolvedAddress> addrs;
+  };
+
+  struct ResolverState
+  {
+    OS::Mutex mutex;
+    std::map<std::string, ResolverEntry> entries;
+    unsigned hits;
+    unsigned misses;
+    ResolverState() : hits(0), misses(0) { }
+  };
+
+  static ResolverState& __resolverState()
+  {
+    static ResolverState _state;
+    return _state;
+  }
+}
+
+static void __copyAddresses(struct addrinfo *result, std::vector<ResolvedAddress>& addrs)
+{
+  for (struct addrinfo *addr = result; addr; addr = addr->ai_next)
+  {
+    if (addr->ai_addrlen > sizeof(sockaddr_storage))
+      continue;
+    ResolvedAddress ra;
+    ra.family = addr->ai_family;
+    ra.socktype = addr->ai_socktype;
+    ra.protocol = addr->ai_protocol;
+    memcpy(&ra.addr.data, addr->ai_addr, addr->ai_addrlen);
+    ra.addr.sa_len = (socklen_t)addr->ai_addrlen;
+    addrs.push_back(ra);
+  }
+}
+
+static int __resolveAddr(const char *server, const char *service, std::vector<ResolvedAddress>& addrs)
+{
+  struct addrinfo hints;
+  struct addrinfo *result;
+  int err;
+
+  memset(&hints, 0, sizeof (hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+
+  // a literal address is not cached
+  hints.ai_flags = AI_NUMERICHOST;
+  if (getaddrinfo(server, service, &hints, &result) == 0)
+  {
+    __copyAddresses(result, addrs);
+    freeaddrinfo(result);
+    return 0;
+  }
+  hints.ai_flags = 0;
+
+  ResolverState& state = __resolverState();
+  std::string key(server);
+  key.append(":").append(service);
+  {
+    OS::LockGuard lock(state.mutex);
+    std::map<std::string, ResolverEntry>::iterator it = state.entries.find(key);
+    if (it != state.entries.end() && it->second.expiry.time_left() > 0)
+    {
+      ++state.hits;
+      addrs = it->second.addrs;
+      return it->second.error;
+    }
+    ++state.misses;
+  }
+
+  err = getaddrinfo(server, service, &hints, &result);
+  if (!err)
+  {
+    __copyAddresses(result, addrs);
+    freeaddrinfo(result);
+  }
+  // remember the failures of the name service only
+  else if (err != EAI_NONAME && err != EAI_FAIL && err != EAI_AGAIN)
+    return err;
+
+  OS::LockGuard lock(state.mutex);
+  if (state.entries.size() >= SOCKET_RESOLVER_MAXSIZE)
+  {
+    // purge the expired entries, else all
+    std::map<std::string, ResolverEntry>::iterator it = state.entries.begin();
+    while (it != state.entries.end())
+    {
+      if (it->second.expiry.time_left() == 0)
+        state.entries.erase(it++);
+      else
+        ++it;
+    }
+    if (state.entries.size() >= SOCKET_RESOLVER_MAXSIZE)
+      state.entries.clear();
+  }
+  ResolverEntry& entry = state.entries[key];
+  entry.expiry.set(err ? SOCKET_RESOLVER_NEGATIVE_TTL : SOCKET_RESOLVER_TTL);
+  entry.error = err;
+  entry.addrs = addrs;
+  return err;
+}
+
+static void __forgetAddr(const char *server, const char *service)
+{
+  ResolverState& state = __resolverState();
+  std::string key(server);
+  key.append(":").append(service);
+  OS::LockGuard lock(state.mutex);
+  state.entries.erase(key);
+}
+
+unsigned ResolverCache::GetHitCount()
+{
+  ResolverState& state = __resolverState();
+  OS::LockGuard lock(state.mutex);
+  return state.hits;
+}
+
+unsigned ResolverCache::GetMissCount()
+{
+  ResolverState& state = __resolverState();
+  OS::LockGuard lock(state.mutex);
+  return state.misses;
+}
+
+void ResolverCache::Clear()
+{
+  ResolverState& state = __resolverState();
+  OS::LockGuard lock(state.mutex);
+  state.entries.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -258,8 +411,7 @@ static int __connectAddr(struct addrinfo *addr, net_socket_t *s, int rcvbuf)
 
 bool TcpSocket::Connect(const char *server, unsigned port, int rcvbuf)
 {
-  struct addrinfo hints;
-  struct addrinfo *result, *addr;
+  std::vector<ResolvedAddress> addrs;
   char service[33];
   int err;
 
@@ -269,13 +421,9 @@ bool TcpSocket::Connect(const char *server, unsigned port, int rcvbuf)
   if (rcvbuf > SOCKET_RCVBUF_MINSIZE)
     m_rcvbuf = rcvbuf;
 
-  memset(&hints, 0, sizeof (hints));
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_protocol = IPPROTO_TCP;
   snprintf(service, sizeof(service), "%u", port);
 
-  err = getaddrinfo(server, service, &hints, &result);
+  err = __resolveAddr(server, service, addrs);
   if (err)
   {
     switch (err)
@@ -300,13 +448,23 @@ bool TcpSocket::Connect(const char *server, unsigned port, int rcvbuf)
     return false;
   }
 
-  for (addr = result; addr; addr = addr->ai_next)
+  err = EAI_NONAME;
+  for (std::vector<ResolvedAddress>::iterator it = addrs.begin(); it != addrs.end(); ++it)
   {
-    err = __connectAddr(addr, &m_socket, m_rcvbuf);
+    struct addrinfo addr;
+    memset(&addr, 0, sizeof (addr));
+    addr.ai_family = it->family;
+    addr.ai_socktype = it->socktype;
+    addr.ai_protocol = it->protocol;
+    addr.ai_addr = it->addr.sa();
+    addr.ai_addrlen = it->addr.sa_len;
+    err = __connectAddr(&addr, &m_socket, m_rcvbuf);
     if (!err)
       break;
   }
-  freeaddrinfo(result);
+  // the host could have moved
+  if (err)
+    __forgetAddr(server, service);
   m_errno = err;
   return (err ? false : true);
 }
@@ -385,6 +543,81 @@ bool TcpSocket::SendData(const char* msg, size_t size)
   return false;
 }
 
+bool TcpSocket::SendFile(FILE* file, uint64_t offset, size_t size)
+{
+#if HAVE_SENDFILE
+  if (!IsValid())
+  {
+    m_errno = ENOTCONN;
+    return false;
+  }
+  int fd = fileno(file);
+  off_t off = (off_t)offset;
+  /*
+   * sendfile() cannot be flagged with MSG_NOSIGNAL, so SIGPIPE is blocked for
+   * this thread as done by SendData() for systems lacking that flag.
+   */
+  sigset_t sig_block, sig_restore, sig_pending;
+  sigemptyset(&sig_block);
+  sigaddset(&sig_block, SIGPIPE);
+  if (pthread_sigmask(SIG_BLOCK, &sig_block, &sig_restore) != 0)
+    return false;
+  int sigpipe_pending = -1;
+  if (sigpending(&sig_pending) != -1)
+    sigpipe_pending = sigismember(&sig_pending, SIGPIPE);
+
+  m_errno = 0;
+  while (size > 0)
+  {
+    ssize_t s = sendfile(m_socket, fd, &off, size);
+    if (s > 0)
+    {
+      size -= (size_t)s;
+      continue;
+    }
+    if (s < 0 && LASTERROR == ERRNO_INTR)
+      continue;
+    // zero means the end of file has been reached unexpectedly
+    m_errno = (s < 0 ? LASTERROR : EIO);
+    break;
+  }
+
+  if (m_errno == EPIPE && sigpipe_pending == 0)
+  {
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = 0;
+    int sig;
+    while ((sig = sigtimedwait(&sig_block, 0, &ts)) == -1 && LASTERROR == EINTR);
+  }
+  pthread_sigmask(SIG_SETMASK, &sig_restore, nullptr);
+  return (m_errno == 0);
+#else
+  return SendFileBuffered(file, offset, size);
+#endif
+}
+
+bool TcpSocket::SendFileBuffered(FILE* file, uint64_t offset, size_t size)
+{
+  if (fseek64(file, (int64_t)offset, SEEK_SET) != 0)
+  {
+    m_errno = EIO;
+    return false;
+  }
+  char * buf = new char [SOCKET_SENDFILE_CHUNK];
+  while (size > 0)
+  {
+    size_t r = fread(buf, 1, (size > SOCKET_SENDFILE_CHUNK ? SOCKET_SENDFILE_CHUNK : size), file);
+    if (r == 0 || !SendData(buf, r))
+      break;
+    size -= r;
+  }
+  delete [] buf;
+  if (size > 0 && m_errno == 0)
+    m_errno = EIO;
+  return (size == 0);
+}
+
 size_t TcpSocket::ReceiveData(void *buf, size_t n)
 {
   if (IsValid())
@@ -457,6 +690,12 @@ size_t TcpSocket::ReceiveData(void *buf, size_t n)
             rcvlen += r;
           }
         }
+        if (r == 0)
+        {
+          // the peer has closed the connection
+          m_errno = ECONNRESET;
+          break;
+        }
       }
       if (r == 0)
       {
@@ -26,6 +26,8 @@
 #include "os/os.h"
 
 #include <cstddef>  // for size_t
+#include <cstdint>
+#include <cstdio>
 #include <string>
 
 #define SOCKET_HOSTNAME_MAXSIZE       256
@@ -35,6 +37,10 @@
 #define SOCKET_READ_ATTEMPT           3
 #define SOCKET_BUFFER_SIZE            1472
 #define SOCKET_LISTEN_QUEUE_SIZE      50
+#define SOCKET_SENDFILE_CHUNK         16384
+#define SOCKET_RESOLVER_TTL           300000  // Lifetime of a resolved address in millisec
+#define SOCKET_RESOLVER_NEGATIVE_TTL  10000   // Lifetime of a failed resolution in millisec
+#define SOCKET_RESOLVER_MAXSIZE       64
 
 namespace NSROOT
 {
@@ -46,6 +52,20 @@ namespace NSROOT
 
   struct SocketAddress;
 
+  /**
+   * The process-wide cache of the host names resolved to connect the TCP
+   * sockets. A name is resolved once for SOCKET_RESOLVER_TTL, and an unknown
+   * name is remembered for SOCKET_RESOLVER_NEGATIVE_TTL. The literal addresses
+   * are never cached. The entry is dropped when no address can be connected.
+   */
+  class ResolverCache
+  {
+  public:
+    static unsigned GetHitCount();
+    static unsigned GetMissCount();
+    static void Clear();
+  };
+
   class NetSocket
   {
   public:
@@ -101,6 +121,19 @@ namespace NSROOT
      */
     virtual bool SendData(const char* buf, size_t size);
 
+    /**
+     * Send a region of file into the socket. When supported, the data are
+     * transmitted by the kernel without copy to user space; otherwise they
+     * are read by chunk and sent with SendData().
+     * It fails in case of an error or if the intrinsic timeout expires.
+     * @param file the file stream to read
+     * @param offset the position of the first byte in the file
+     * @param size the number of byte to send
+     * @return true when succeeded, else false
+     * @see SOCKET_TIMEOUT_SEC
+     */
+    virtual bool SendFile(FILE* file, uint64_t offset, size_t size);
+
     /**
      * Read n bytes from the socket or until the soft timeout expires.
      * @param buf the pointer to write received data
@@ -124,6 +157,11 @@ namespace NSROOT
      */
     virtual void Disconnect();
 
+    /**
+     * @return true when received data remain in the read buffer
+     */
+    bool HasBufferedData() const { return (m_buffer && m_bufptr < m_buffer + m_rcvlen); }
+
     /**
      * @return true when socket is connected, else false
      */
@@ -163,6 +201,12 @@ namespace NSROOT
     int m_errno;
     int m_attempt;
 
+    /**
+     * Send a region of file by copying data through a buffer.
+     * @see SendFile()
+     */
+    bool SendFileBuffered(FILE* file, uint64_t offset, size_t size);
+
   private:
     char* m_buffer;
     char* m_bufptr;
@@ -0,0 +1,121 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "timerwheel.h"
+
+using namespace NSROOT;
+
+#define SLOT_MASK     (TIMERWHEEL_SLOTS - 1)
+
+TimerWheel::TimerWheel()
+: m_now(0)
+{
+}
+
+void TimerWheel::Schedule(unsigned id, unsigned ticks)
+{
+  Timer timer;
+  timer.id = id;
+  timer.expiry = m_now + (ticks > 0 ? ticks : 1);
+  m_timers[id] = timer.expiry;
+  Insert(timer);
+}
+
+bool TimerWheel::Cancel(unsigned id)
+{
+  // the entry in slot becomes stale
+  return m_timers.erase(id) > 0;
+}
+
+void TimerWheel::Tick(std::vector<unsigned>& expired)
+{
+  ++m_now;
+  if ((m_now & SLOT_MASK) == 0)
+  {
+    // the upper levels must be cascaded first, as they feed the lower ones
+    for (unsigned level = TIMERWHEEL_LEVELS - 1; level > 0; --level)
+    {
+      bool wrapped = true;
+      for (unsigned l = 1; l < level; ++l)
+        wrapped &= ((m_now >> (l * TIMERWHEEL_SLOT_BITS)) & SLOT_MASK) == 0;
+      if (wrapped)
+        Cascade(level);
+    }
+  }
+  Slot& slot = m_slots[0][m_now & SLOT_MASK];
+  for (const Timer& timer : slot)
+  {
+    if (IsArmed(timer))
+    {
+      m_timers.erase(timer.id);
+      expired.push_back(timer.id);
+    }
+  }
+  slot.clear();
+}
+
+unsigned TimerWheel::NextTick() const
+{
+  if (m_timers.empty())
+    return 0;
+  // the next non-empty slot of the first level, or the next cascade
+  unsigned ticks = 1;
+  while (ticks < TIMERWHEEL_SLOTS)
+  {
+    uint64_t t = m_now + ticks;
+    if ((t & SLOT_MASK) == 0 || !m_slots[0][t & SLOT_MASK].empty())
+      break;
+    ++ticks;
+  }
+  return ticks;
+}
+
+void TimerWheel::Insert(const Timer& timer)
+{
+  uint64_t delta = timer.expiry - m_now;
+  unsigned level = 0;
+  while (level < TIMERWHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << ((level + 1) * TIMERWHEEL_SLOT_BITS)))
+    ++level;
+  uint64_t expiry = timer.expiry;
+  // beyond the span of the wheel: park it in the farthest slot, it will be
+  // inserted again on cascade
+  uint64_t span = (uint64_t)1 << (TIMERWHEEL_LEVELS * TIMERWHEEL_SLOT_BITS);
+  if (delta >= span)
+    expiry = m_now + span - 1;
+  m_slots[level][(expiry >> (level * TIMERWHEEL_SLOT_BITS)) & SLOT_MASK].push_back(timer);
+}
+
+void TimerWheel::Cascade(unsigned level)
+{
+  Slot slot;
+  slot.swap(m_slots[level][(m_now >> (level * TIMERWHEEL_SLOT_BITS)) & SLOT_MASK]);
+  for (const Timer& timer : slot)
+  {
+    if (IsArmed(timer))
+      Insert(timer);
+  }
+}
+
+bool TimerWheel::IsArmed(const Timer& timer) const
+{
+  std::map<unsigned, uint64_t>::const_iterator it = m_timers.find(timer.id);
+  return (it != m_timers.end() && it->second == timer.expiry);
+}
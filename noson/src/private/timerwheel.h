@@ -0,0 +1,103 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "local_config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#define TIMERWHEEL_LEVELS     3
+#define TIMERWHEEL_SLOT_BITS  6
+#define TIMERWHEEL_SLOTS      (1 << TIMERWHEEL_SLOT_BITS)
+
+namespace NSROOT
+{
+
+  /**
+   * A hierarchical timer wheel counting in ticks. The first level holds the
+   * timers expiring within TIMERWHEEL_SLOTS ticks, each next level covers
+   * TIMERWHEEL_SLOTS times the span of the previous one, and its slots are
+   * cascaded down when the lower level wraps. Scheduling and cancelling are
+   * done in constant time; a cancelled or rescheduled timer is dropped when
+   * its slot is reached. The wheel isn't thread safe.
+   */
+  class TimerWheel
+  {
+  public:
+    TimerWheel();
+    ~TimerWheel() { }
+
+    /**
+     * Arm the timer for the given id, replacing the previous one if any.
+     * @param id
+     * @param ticks the count of ticks before expiry, at least 1
+     */
+    void Schedule(unsigned id, unsigned ticks);
+
+    /**
+     * Disarm the timer for the given id.
+     * @return true if it was armed
+     */
+    bool Cancel(unsigned id);
+
+    bool IsScheduled(unsigned id) const { return m_timers.find(id) != m_timers.end(); }
+
+    /**
+     * Move forward one tick.
+     * @param expired appended with the ids of the timers expired on this tick
+     */
+    void Tick(std::vector<unsigned>& expired);
+
+    /**
+     * @return the count of ticks until the next slot to process, else 0 when
+     * no timer is armed
+     */
+    unsigned NextTick() const;
+
+    uint64_t Now() const { return m_now; }
+
+    size_t Size() const { return m_timers.size(); }
+
+  private:
+    struct Timer
+    {
+      unsigned id;
+      uint64_t expiry;
+    };
+
+    typedef std::vector<Timer> Slot;
+
+    uint64_t m_now;
+    std::map<unsigned, uint64_t> m_timers;  // the armed timers by id
+    Slot m_slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+
+    void Insert(const Timer& timer);
+    void Cascade(unsigned level);
+    bool IsArmed(const Timer& timer) const;
+  };
+}
+
+#endif /* TIMERWHEEL_H */
@@ -22,8 +22,7 @@
 #include "wsstatic.h"
 #include "wsrequestbroker.h"
 #include "wsrequestreply.h"
-#include "tinyxml2.h"
-#include "xmldict.h"
+#include "notifyparser.h"
 
 using namespace NSROOT;
 
@@ -48,6 +47,13 @@ bool UPNPNotificationBroker::HandleRequest(handle * handle)
   return false;
 }
 
+RequestBroker::RouteList UPNPNotificationBroker::GetRoutes()
+{
+  RouteList routes;
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Notify), UPNPNOTIFICATIONBROKER_URI));
+  return routes;
+}
+
 RequestBroker::ResourcePtr UPNPNotificationBroker::GetResource(const std::string& title)
 {
   (void)title;
@@ -77,165 +83,37 @@ void UPNPNotificationBroker::UnregisterResource(const std::string& uri)
   (void)uri;
 }
 
-#define NS_RCS "urn:schemas-upnp-org:metadata-1-0/RCS/"
-#define NS_AVT "urn:schemas-upnp-org:metadata-1-0/AVT/"
-#define NS_RIN "urn:schemas-rinconnetworks-com:metadata-1-0/"
-#define QN_RIN "r:"
-
-namespace NSROOT
-{
-  XMLDict __initRCSDict()
-  {
-    XMLDict dict;
-    dict.DefineNS("", NS_RCS);
-    dict.DefineNS(QN_RIN, NS_RIN);
-    return dict;
-  }
-  XMLDict RCSDict = __initRCSDict();
-
-  XMLDict __initAVTDict()
-  {
-    XMLDict dict;
-    dict.DefineNS("", NS_AVT);
-    dict.DefineNS(QN_RIN, NS_RIN);
-    return dict;
-  }
-  XMLDict AVTDict = __initAVTDict();
-}
-
 void UPNPNotificationBroker::Process(handle * handle)
 {
   WSRequestReply reply(*handle->broker);
 
-  // Receive content data
-  std::string data;
-  size_t len = 0, r = 0;
-  char buffer[4096];
-  while ((r = handle->broker->ReadContent(buffer, sizeof(buffer))))
-  {
-    data.append(buffer, r);
-    len += r;
-  }
-
-  // Parse xml content
-  tinyxml2::XMLDocument rootdoc;
-  if (rootdoc.Parse(data.c_str(), len) != tinyxml2::XML_SUCCESS)
-  {
-    DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
-    TraceResponseStatus(500);
-    reply.PostReply(WS_STATUS_500_Internal_Server_Error);
-    return;
-  }
-
   // Setup new event message
   EventMessage* msg = new EventMessage();
   msg->event = EVENT_UPNP_PROPCHANGE;
   msg->subject.push_back(handle->broker->GetRequestHeader("SID"));
   msg->subject.push_back(handle->broker->GetRequestHeader("SEQ"));
 
-  // Parse document
-  const tinyxml2::XMLElement* root; // root element
-  const tinyxml2::XMLElement* elem; // an element
-  const tinyxml2::XMLNode* node;    // a node
-  tinyxml2::XMLDocument doc;  // a document
-  const char* str;
-  if ((root = rootdoc.RootElement()) && XMLNS::NameEqual(root->Name(), "propertyset"))
+  // Parse the content while receiving data
+  NotifyParser parser(msg->subject);
+  bool valid = true;
+  size_t r = 0;
+  char buffer[4096];
+  while ((r = handle->broker->ReadContent(buffer, sizeof(buffer))))
   {
-    if ((node = root->FirstChild()) && XMLNS::NameEqual(node->Value(), "property"))
-    {
-      // Check prior for embedded doc 'Event': propertyset/property/LastChange
-      if ((elem = node->FirstChildElement("LastChange")))
-      {
-        if (doc.Parse(elem->GetText()) != tinyxml2::XML_SUCCESS ||
-              !(elem = doc.RootElement()))
-        {
-          DBG(DBG_ERROR, "%s: invalid or not supported content\n", __FUNCTION__);
-          DBG(DBG_ERROR, "%s: dump => %s\n", __FUNCTION__, data.c_str());
-          TraceResponseStatus(500);
-          reply.PostReply(WS_STATUS_500_Internal_Server_Error);
-          delete msg;
-          return;
-        }
-
-        XMLNames docns;
-        docns.AddXMLNS(elem);
-
-        /*
-         * Processing RCS notification
-         */
-        if (docns.FindName(NS_RCS) && (node = elem->FirstChildElement("InstanceID")))
-        {
-          msg->subject.push_back("RCS");
-          elem = node->FirstChildElement(NULL);
-          while (elem)
-          {
-            std::string name(RCSDict.TranslateQName(docns, elem->Name()));
-            if ((str = elem->Attribute("channel")))
-              name.append("/").append(str);
-            msg->subject.push_back(name);
-            if ((str = elem->Attribute("val")))
-              msg->subject.push_back(str);
-            else
-              msg->subject.push_back("");
-            DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, name.c_str(), str);
-            elem = elem->NextSiblingElement(NULL);
-          }
-        }
-        /*
-         * Processing AVT notification
-         */
-        else if (docns.FindName(NS_AVT) && (node = elem->FirstChildElement("InstanceID")))
-        {
-          msg->subject.push_back("AVT");
-          elem = node->FirstChildElement(NULL);
-          while (elem)
-          {
-            std::string name(AVTDict.TranslateQName(docns, elem->Name()));
-            msg->subject.push_back(name);
-            if ((str = elem->Attribute("val")))
-              msg->subject.push_back(str);
-            else
-              msg->subject.push_back("");
-            DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, name.c_str(), str);
-            elem = elem->NextSiblingElement(NULL);
-          }
-        }
-        else
-        {
-          DBG(DBG_WARN, "%s: not supported content\n", __FUNCTION__);
-          DBG(DBG_WARN, "%s: dump => %s\n", __FUNCTION__, data.c_str());
-        }
-      }
-      // Else treat propertyset/property/
-      else
-      {
-        msg->subject.push_back("PROPERTY");
-        do
-        {
-          if ((elem = node->FirstChildElement(NULL)))
-          {
-            std::string name(XMLNS::LocalName(elem->Name()));
-            msg->subject.push_back(name);
-            if ((str = elem->GetText()))
-              msg->subject.push_back(str);
-            else
-              msg->subject.push_back("");
-            DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, name.c_str(), str);
-          }
-          node = node->NextSibling();
-        } while (node && XMLNS::NameEqual(node->Value(), "property"));
-      }
-    }
+    if (valid)
+      valid = parser.Feed(buffer, r);
   }
-  else
+  if (!valid || !parser.Finish())
   {
     DBG(DBG_ERROR, "%s: invalid or not supported content\n", __FUNCTION__);
-    DBG(DBG_ERROR, "%s: dump => %s\n", __FUNCTION__, data.c_str());
     delete msg;
     TraceResponseStatus(500);
     reply.PostReply(WS_STATUS_500_Internal_Server_Error);
     return;
   }
+  if (!parser.IsSupported())
+    DBG(DBG_WARN, "%s: not supported content\n", __FUNCTION__);
+  msg->Index();
 
   handle->handler->DispatchEvent(EventMessagePtr(msg));
   TraceResponseStatus(200);
@@ -0,0 +1,316 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "wsasyncclient.h"
+#include "wsresponse.h"
+#include "wsconnectionpool.h"
+#include "debug.h"
+
+#if HAVE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace NSROOT;
+
+WSAsyncClient& WSAsyncClient::Instance()
+{
+  static WSAsyncClient _instance;
+  return _instance;
+}
+
+WSAsyncClient::WSAsyncClient()
+: OS::Thread()
+, m_pool(new OS::ThreadPool())
+, m_pollfd(-1)
+, m_pending(0)
+, m_hostConcurrency(WSASYNC_HOST_CONCURRENCY)
+{
+  m_pool->set_max_size(WSASYNC_THREADS);
+  m_pool->set_keep_alive(WSASYNC_THREAD_KEEPALIVE);
+  m_pool->start();
+#if HAVE_EPOLL
+  m_pollfd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_pollfd < 0)
+    DBG(DBG_WARN, "%s: epoll is not available (%d)\n", __FUNCTION__, errno);
+  else
+    OS::Thread::start_thread();
+#endif
+}
+
+WSAsyncClient::~WSAsyncClient()
+{
+  OS::Thread::stop_thread(true);
+  // join the workers while the hosts remain: the queued calls are failed,
+  // and the running ones complete
+  delete m_pool;
+  m_pool = nullptr;
+  // fail the responses still awaited
+  for (std::map<net_socket_t, CallPtr>::value_type& e : m_polled)
+    Fail(e.second);
+  m_polled.clear();
+#if HAVE_EPOLL
+  if (m_pollfd >= 0)
+    close(m_pollfd);
+#endif
+}
+
+bool WSAsyncClient::Submit(const WSRequest& request, const ExchangePtr& exchange)
+{
+  std::string host(request.GetServer());
+  host.append(":").append(std::to_string(request.GetPort()));
+  std::vector<CallPtr> failed;
+  {
+    OS::LockGuard lock(m_mutex);
+    if (m_pool->is_stopped())
+      return false;
+    m_hosts[host].waiting.push_back(CallPtr(new Call(request, exchange, host)));
+    ++m_pending;
+    Dispatch(host, failed);
+  }
+  for (const CallPtr& call : failed)
+    Fail(call);
+  return true;
+}
+
+unsigned WSAsyncClient::GetPendingCount()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_pending;
+}
+
+void WSAsyncClient::SetHostConcurrency(unsigned max)
+{
+  unsigned limit = WSConnectionPool::Instance().GetMaxConnections();
+  std::vector<CallPtr> failed;
+  {
+    OS::LockGuard lock(m_mutex);
+    m_hostConcurrency = (max == 0 ? 1 : (max > limit ? limit : max));
+    // the waiting calls could take the new slots
+    std::vector<std::string> names;
+    for (std::map<std::string, Host>::const_iterator it = m_hosts.begin(); it != m_hosts.end(); ++it)
+      names.push_back(it->first);
+    for (const std::string& name : names)
+      Dispatch(name, failed);
+  }
+  for (const CallPtr& c : failed)
+    Fail(c);
+}
+
+unsigned WSAsyncClient::GetHostConcurrency()
+{
+  OS::LockGuard lock(m_mutex);
+  return m_hostConcurrency;
+}
+
+WSAsyncClient::CallWorker::~CallWorker()
+{
+  if (m_call)
+  {
+    // the call has been dropped unprocessed
+    Fail(m_call);
+    m_client.Done(m_call);
+  }
+}
+
+void WSAsyncClient::CallWorker::process()
+{
+  CallPtr call;
+  call.swap(m_call);
+  if (m_receive)
+    m_client.Receive(call);
+  else
+    m_client.Send(call);
+}
+
+void WSAsyncClient::Send(const CallPtr& call)
+{
+  if (call->exchange->IsCanceled())
+  {
+    call->exchange->Completed(nullptr);
+    Done(call);
+    return;
+  }
+  call->response = new WSResponse(call->request, true);
+  if (call->response->IsPending() && Poll(call))
+    return;
+  // no poller: wait for the response
+  Receive(call);
+}
+
+void WSAsyncClient::Receive(const CallPtr& call)
+{
+  WSResponse * response = call->response;
+  // the response isn't pending on send failure
+  bool ok = (!call->expired && !call->exchange->IsCanceled() && response->IsPending() && response->Receive());
+  call->exchange->Completed(ok ? response : nullptr);
+  call->response = nullptr;
+  delete response;
+  Done(call);
+}
+
+void WSAsyncClient::Done(const CallPtr& call)
+{
+  std::vector<CallPtr> failed;
+  {
+    OS::LockGuard lock(m_mutex);
+    --m_pending;
+    std::map<std::string, Host>::iterator it = m_hosts.find(call->host);
+    if (it != m_hosts.end())
+    {
+      --it->second.active;
+      Dispatch(call->host, failed);
+    }
+  }
+  for (const CallPtr& c : failed)
+    Fail(c);
+}
+
+void WSAsyncClient::Dispatch(const std::string& name, std::vector<CallPtr>& failed)
+{
+  std::map<std::string, Host>::iterator it = m_hosts.find(name);
+  if (it == m_hosts.end())
+    return;
+  Host& host = it->second;
+  while (host.active < m_hostConcurrency && !host.waiting.empty())
+  {
+    CallPtr call = host.waiting.front();
+    host.waiting.pop_front();
+    CallWorker * worker = new CallWorker(*this, call, false);
+    if (m_pool->enqueue(worker))
+    {
+      ++host.active;
+      continue;
+    }
+    // the client is stopped: the call is failed out of the lock
+    DBG(DBG_WARN, "%s: client is stopped (%s)\n", __FUNCTION__, name.c_str());
+    worker->Discard();
+    delete worker;
+    --m_pending;
+    failed.push_back(call);
+  }
+  if (host.active == 0 && host.waiting.empty())
+    m_hosts.erase(it);
+}
+
+void WSAsyncClient::Fail(const CallPtr& call)
+{
+  call->exchange->Completed(nullptr);
+  if (call->response)
+    delete call->response;
+  call->response = nullptr;
+}
+
+#if HAVE_EPOLL
+bool WSAsyncClient::Poll(const CallPtr& call)
+{
+  if (m_pollfd < 0)
+    return false;
+  net_socket_t fd = call->response->GetSocketHandle();
+  OS::LockGuard lock(m_mutex);
+  call->deadline = time(NULL) + WSASYNC_RESPONSE_TIMEOUT;
+  m_polled[fd] = call;
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.fd = fd;
+  if (epoll_ctl(m_pollfd, EPOLL_CTL_ADD, fd, &ev) == 0)
+    return true;
+  m_polled.erase(fd);
+  return false;
+}
+
+void* WSAsyncClient::process()
+{
+  struct epoll_event events[WSASYNC_POLL_EVENTS];
+  while (!OS::Thread::is_stopped())
+  {
+    int n = epoll_wait(m_pollfd, events, WSASYNC_POLL_EVENTS, 1000);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      DBG(DBG_ERROR, "%s: epoll wait failed (%d)\n", __FUNCTION__, errno);
+      break;
+    }
+    std::vector<CallPtr> failed;
+    {
+      OS::LockGuard lock(m_mutex);
+      for (int i = 0; i < n; ++i)
+      {
+        // the response is incoming, so read it
+        std::map<net_socket_t, CallPtr>::iterator it = m_polled.find(events[i].data.fd);
+        if (it != m_polled.end())
+        {
+          epoll_ctl(m_pollfd, EPOLL_CTL_DEL, it->first, NULL);
+          Read(it->second, failed);
+          m_polled.erase(it);
+        }
+      }
+      // fail the responses awaited for too long
+      time_t now = time(NULL);
+      std::map<net_socket_t, CallPtr>::iterator it = m_polled.begin();
+      while (it != m_polled.end())
+      {
+        if (it->second->deadline <= now)
+        {
+          DBG(DBG_WARN, "%s: response timed out (%s)\n", __FUNCTION__, it->second->host.c_str());
+          epoll_ctl(m_pollfd, EPOLL_CTL_DEL, it->first, NULL);
+          it->second->expired = true;
+          Read(it->second, failed);
+          m_polled.erase(it++);
+        }
+        else
+          ++it;
+      }
+    }
+    for (const CallPtr& call : failed)
+    {
+      Fail(call);
+      Done(call);
+    }
+  }
+  return nullptr;
+}
+
+void WSAsyncClient::Read(const CallPtr& call, std::vector<CallPtr>& failed)
+{
+  CallWorker * worker = new CallWorker(*this, call, true);
+  if (m_pool->enqueue(worker))
+    return;
+  worker->Discard();
+  delete worker;
+  failed.push_back(call);
+}
+#else
+bool WSAsyncClient::Poll(const CallPtr& call)
+{
+  (void)call;
+  return false;
+}
+
+void* WSAsyncClient::process()
+{
+  return nullptr;
+}
+#endif
@@ -0,0 +1,167 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef WSASYNCCLIENT_H
+#define WSASYNCCLIENT_H
+
+#include "local_config.h"
+#include "wsrequest.h"
+#include "os/os.h"
+#include "os/threads/thread.h"
+#include "os/threads/threadpool.h"
+#include "../sharedptr.h"
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#define WSASYNC_THREADS           4     // Max workers sending the requests and reading the responses
+#define WSASYNC_THREAD_KEEPALIVE  10000 // Keep alive of idle worker in millisec
+#define WSASYNC_HOST_CONCURRENCY  2     // Default max requests in flight to a same host
+#define WSASYNC_RESPONSE_TIMEOUT  60    // Max wait for a response in seconds
+#define WSASYNC_POLL_EVENTS       32
+
+namespace NSROOT
+{
+
+  class WSResponse;
+
+  /**
+   * The client sends the requests without blocking the caller. A worker of
+   * a small pool sends the request, then the connection is polled by one
+   * thread until the response is incoming, and a worker reads it. So the
+   * round trips awaiting a response hold no thread. Without a readiness
+   * poller on the platform, the worker waits for the response.
+   * The requests to a same host are queued, and no more than the host
+   * concurrency (WSASYNC_HOST_CONCURRENCY by default) are in flight at once.
+   */
+  class WSAsyncClient : private OS::Thread
+  {
+  public:
+    class Exchange
+    {
+    public:
+      virtual ~Exchange() { }
+      /**
+       * Called by a worker once the status and headers of the response are
+       * received: the content can be read from the response.
+       * @param response the response, else null on failure
+       */
+      virtual void Completed(WSResponse * response) = 0;
+      /**
+       * A canceled exchange is completed without response, and the request
+       * isn't sent when it is still queued.
+       * @return true if the caller no longer waits for the response
+       */
+      virtual bool IsCanceled() const { return false; }
+    };
+
+    typedef SHARED_PTR<Exchange> ExchangePtr;
+
+    static WSAsyncClient& Instance();
+
+    /**
+     * Queue the request.
+     * @return false if the request cannot be queued
+     */
+    bool Submit(const WSRequest& request, const ExchangePtr& exchange);
+
+    /**
+     * @return the count of requests queued or in flight
+     */
+    unsigned GetPendingCount();
+
+    /**
+     * Set the max count of requests in flight to a same host. It is bounded
+     * by the connections the pool allows to a same host.
+     * @param max the count, at least 1
+     */
+    void SetHostConcurrency(unsigned max);
+    unsigned GetHostConcurrency();
+
+  private:
+    WSAsyncClient();
+    ~WSAsyncClient();
+    WSAsyncClient(const WSAsyncClient&);
+    WSAsyncClient& operator=(const WSAsyncClient&);
+
+    struct Call
+    {
+      WSRequest request;
+      ExchangePtr exchange;
+      std::string host;
+      WSResponse * response;
+      time_t deadline;
+      bool expired;
+      Call(const WSRequest& _request, const ExchangePtr& _exchange, const std::string& _host)
+      : request(_request), exchange(_exchange), host(_host), response(nullptr), deadline(0), expired(false) { }
+    };
+
+    typedef SHARED_PTR<Call> CallPtr;
+
+    struct Host
+    {
+      unsigned active;
+      std::deque<CallPtr> waiting;
+    };
+
+    class CallWorker : public OS::Worker
+    {
+    public:
+      CallWorker(WSAsyncClient& client, const CallPtr& call, bool receive)
+      : m_client(client), m_call(call), m_receive(receive) { }
+      /**
+       * A worker dropped by the stopped pool fails its call.
+       */
+      virtual ~CallWorker();
+      virtual void process();
+      /**
+       * Detach the call from a worker which hasn't been queued.
+       */
+      void Discard() { m_call.reset(); }
+    private:
+      WSAsyncClient& m_client;
+      CallPtr m_call;
+      bool m_receive;
+    };
+
+    OS::Mutex m_mutex;
+    OS::ThreadPool * m_pool;
+    std::map<std::string, Host> m_hosts;
+    std::map<net_socket_t, CallPtr> m_polled;
+    int m_pollfd;
+    unsigned m_pending;
+    unsigned m_hostConcurrency;
+
+    virtual void* process();
+    void Send(const CallPtr& call);
+    void Receive(const CallPtr& call);
+    void Done(const CallPtr& call);
+    void Dispatch(const std::string& host, std::vector<CallPtr>& failed);
+    bool Poll(const CallPtr& call);
+    void Read(const CallPtr& call, std::vector<CallPtr>& failed);
+    static void Fail(const CallPtr& call);
+  };
+}
+
+#endif /* WSASYNCCLIENT_H */
@@ -0,0 +1,217 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "wsconnectionpool.h"
+#include "securesocket.h"
+#include "os/threads/timeout.h"
+#include "debug.h"
+
+using namespace NSROOT;
+
+namespace
+{
+  /**
+   * The sockets to close once the lock is released
+   */
+  struct Garbage : public std::vector<TcpSocket*>
+  {
+    ~Garbage()
+    {
+      for (TcpSocket * socket : *this)
+        delete socket;
+    }
+  };
+}
+
+WSConnectionPool& WSConnectionPool::Instance()
+{
+  // the pool is never destroyed: it could hold secure sockets, which cannot
+  // be freed once the SSL library has been released at exit. The pool is
+  // cleared by SSLSessionFactory::Destroy().
+  static WSConnectionPool * _instance = new WSConnectionPool();
+  return *_instance;
+}
+
+WSConnectionPool::WSConnectionPool()
+: m_maxConnections(WSPOOL_MAX_CONNECTIONS)
+{
+}
+
+WSConnectionPool::~WSConnectionPool()
+{
+  Clear();
+}
+
+TcpSocket * WSConnectionPool::Acquire(const std::string& server, unsigned port, bool secure, bool * reused, bool fresh)
+{
+  std::string key = MakeKey(server, port, secure);
+  *reused = false;
+  {
+    Garbage garbage;
+    OS::LockGuard lock(m_mutex);
+    OS::Timeout timeout(WSPOOL_WAIT_TIMEOUT);
+    for (;;)
+    {
+      int64_t now = OS::gettime_ms();
+      Evict(now, garbage);
+      Host& host = m_hosts[key];
+      // take the most recent idle connection still alive
+      while (!fresh && !host.idle.empty())
+      {
+        TcpSocket * socket = host.idle.front().socket;
+        host.idle.pop_front();
+        if (IsAlive(socket))
+        {
+          ++host.busy;
+          *reused = true;
+          return socket;
+        }
+        garbage.push_back(socket);
+      }
+      if (host.busy + host.idle.size() < m_maxConnections)
+      {
+        // reserve the slot, then connect out of the lock
+        ++host.busy;
+        break;
+      }
+      if (fresh && !host.idle.empty())
+      {
+        garbage.push_back(host.idle.back().socket);
+        host.idle.pop_back();
+        continue;
+      }
+      if (timeout.time_left() == 0)
+      {
+        DBG(DBG_WARN, "%s: too many connections to %s\n", __FUNCTION__, key.c_str());
+        return nullptr;
+      }
+      m_condition.wait_for(m_mutex, timeout);
+    }
+  }
+  TcpSocket * socket = Connect(server, port, secure);
+  if (!socket)
+  {
+    OS::LockGuard lock(m_mutex);
+    --m_hosts[key].busy;
+    m_condition.notify_all();
+  }
+  return socket;
+}
+
+void WSConnectionPool::Release(const std::string& server, unsigned port, bool secure, TcpSocket * socket, bool reusable)
+{
+  std::string key = MakeKey(server, port, secure);
+  Garbage garbage;
+  OS::LockGuard lock(m_mutex);
+  Host& host = m_hosts[key];
+  if (host.busy > 0)
+    --host.busy;
+  if (reusable && socket->IsValid())
+  {
+    Idle idle;
+    idle.socket = socket;
+    idle.since = OS::gettime_ms();
+    host.idle.push_front(idle);
+  }
+  else
+    garbage.push_back(socket);
+  Evict(OS::gettime_ms(), garbage);
+  m_condition.notify_all();
+}
+
+void WSConnectionPool::Clear()
+{
+  Garbage garbage;
+  OS::LockGuard lock(m_mutex);
+  for (HostMap::iterator it = m_hosts.begin(); it != m_hosts.end(); ++it)
+  {
+    for (const Idle& idle : it->second.idle)
+      garbage.push_back(idle.socket);
+    it->second.idle.clear();
+  }
+  Evict(OS::gettime_ms(), garbage);
+}
+
+unsigned WSConnectionPool::GetIdleCount()
+{
+  OS::LockGuard lock(m_mutex);
+  unsigned count = 0;
+  for (HostMap::const_iterator it = m_hosts.begin(); it != m_hosts.end(); ++it)
+    count += (unsigned)it->second.idle.size();
+  return count;
+}
+
+void WSConnectionPool::Evict(int64_t now, std::vector<TcpSocket*>& closed)
+{
+  HostMap::iterator it = m_hosts.begin();
+  while (it != m_hosts.end())
+  {
+    std::list<Idle>& idle = it->second.idle;
+    // the oldest are at the back
+    while (!idle.empty() && now - idle.back().since >= WSPOOL_IDLE_TIMEOUT)
+    {
+      closed.push_back(idle.back().socket);
+      idle.pop_back();
+    }
+    if (idle.empty() && it->second.busy == 0)
+      it = m_hosts.erase(it);
+    else
+      ++it;
+  }
+}
+
+std::string WSConnectionPool::MakeKey(const std::string& server, unsigned port, bool secure)
+{
+  std::string key(secure ? "https://" : "http://");
+  return key.append(server).append(":").append(std::to_string(port));
+}
+
+bool WSConnectionPool::IsAlive(TcpSocket * socket)
+{
+  // an idle connection must have nothing to read: else the peer has closed
+  // it, or it sent unexpected data
+  if (!socket->IsValid() || socket->HasBufferedData())
+    return false;
+  struct timeval tv;
+  tv.tv_sec = 0;
+  tv.tv_usec = 0;
+  return socket->Listen(&tv) == 0;
+}
+
+TcpSocket * WSConnectionPool::Connect(const std::string& server, unsigned port, bool secure)
+{
+  TcpSocket * socket;
+  if (secure)
+    socket = SSLSessionFactory::Instance().NewClientSocket();
+  else
+    socket = new TcpSocket();
+  if (!socket)
+  {
+    DBG(DBG_ERROR, "%s: create socket failed\n", __FUNCTION__);
+    return nullptr;
+  }
+  if (!socket->Connect(server.c_str(), port, SOCKET_RCVBUF_MINSIZE))
+  {
+    delete socket;
+    return nullptr;
+  }
+  return socket;
+}
@@ -0,0 +1,118 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef WSCONNECTIONPOOL_H
+#define WSCONNECTIONPOOL_H
+
+#include "local_config.h"
+#include "os/threads/mutex.h"
+#include "os/threads/condition.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#define WSPOOL_MAX_CONNECTIONS  4     // Max connections to a same host
+#define WSPOOL_IDLE_TIMEOUT     8000  // Idle connection is closed after millisec
+#define WSPOOL_WAIT_TIMEOUT     10000 // Max wait for a free connection in millisec
+
+namespace NSROOT
+{
+
+  class TcpSocket;
+
+  /**
+   * The pool keeps the persistent connections to the web servers, so that
+   * consecutive requests to a same host don't pay a new connection. A socket
+   * is borrowed for one request/response exchange, then it is given back
+   * when the response has been fully read and the server agreed to keep it
+   * alive. The idle connections are closed after WSPOOL_IDLE_TIMEOUT, and no
+   * more than WSPOOL_MAX_CONNECTIONS are open at once to a same host.
+   */
+  class WSConnectionPool
+  {
+  public:
+    static WSConnectionPool& Instance();
+
+    /**
+     * Borrow a connected socket. It waits for a free connection when the
+     * limit is reached for the host.
+     * Ownership of the returned pointer is transferred until Release().
+     * @param server
+     * @param port
+     * @param secure
+     * @param reused set to true when the connection was idle in the pool
+     * @param fresh true to skip the idle connections
+     * @return the connected socket or nullptr on failure
+     */
+    TcpSocket * Acquire(const std::string& server, unsigned port, bool secure, bool * reused, bool fresh = false);
+
+    /**
+     * Give back a borrowed socket. It is kept when reusable, else closed.
+     */
+    void Release(const std::string& server, unsigned port, bool secure, TcpSocket * socket, bool reusable);
+
+    /**
+     * Close all idle connections. It must be called before the SSL library
+     * is released, as done by SSLSessionFactory::Destroy().
+     */
+    void Clear();
+
+    unsigned GetIdleCount();
+
+    unsigned GetMaxConnections() const { return m_maxConnections; }
+    void SetMaxConnections(unsigned max) { m_maxConnections = (max > 0 ? max : 1); }
+
+  private:
+    WSConnectionPool();
+    ~WSConnectionPool();
+    WSConnectionPool(const WSConnectionPool&);
+    WSConnectionPool& operator=(const WSConnectionPool&);
+
+    struct Idle
+    {
+      TcpSocket * socket;
+      int64_t since;
+    };
+
+    struct Host
+    {
+      unsigned busy;
+      std::list<Idle> idle;   // the most recent first
+    };
+
+    typedef std::map<std::string, Host> HostMap;
+
+    OS::Mutex m_mutex;
+    OS::Condition<bool> m_condition;   // shared by the waiters of all hosts
+    HostMap m_hosts;
+    unsigned m_maxConnections;
+
+    void Evict(int64_t now, std::vector<TcpSocket*>& closed);
+    static std::string MakeKey(const std::string& server, unsigned port, bool secure);
+    static bool IsAlive(TcpSocket * socket);
+    static TcpSocket * Connect(const std::string& server, unsigned port, bool secure);
+  };
+}
+
+#endif /* WSCONNECTIONPOOL_H */
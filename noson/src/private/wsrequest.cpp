@@ -41,6 +41,7 @@ WSRequest::WSRequest(const std::string& server, unsigned port)
 , m_contentType(WS_CTYPE_Form)
 , m_contentTypeStr()
 , m_contentData()
+, m_keepAlive(true)
 {
   if (port == 443)
     m_secure_uri = true;
@@ -59,6 +60,7 @@ WSRequest::WSRequest(const std::string& server, unsigned port, bool secureURI)
 , m_contentType(WS_CTYPE_Form)
 , m_contentTypeStr()
 , m_contentData()
+, m_keepAlive(true)
 {
   // by default allow content encoding if possible
   RequestAcceptEncoding(true);
@@ -73,6 +75,7 @@ WSRequest::WSRequest(const URIParser& uri, WS_METHOD method)
 , m_contentType(WS_CTYPE_Form)
 , m_contentTypeStr()
 , m_contentData()
+, m_keepAlive(true)
 {
   if (uri.Host())
     m_server.assign(uri.Host());
@@ -114,6 +117,7 @@ WSRequest::WSRequest(const WSRequest& o, const URIParser& redirection)
 , m_contentData(o.m_contentData)
 , m_headers(o.m_headers)
 , m_userAgent(o.m_userAgent)
+, m_keepAlive(o.m_keepAlive)
 {
   /* The "Location" header field is used in some responses to refer to a
    * specific resource in relation to the response. The type of relationship
@@ -218,6 +222,13 @@ void WSRequest::SetContentCustom(const std::string& contentType, const char *con
   m_contentData = content;
 }
 
+void WSRequest::SetContentCustom(const std::string& contentType, std::string&& content)
+{
+  m_contentType = WS_CTYPE_UNKNOWN;
+  m_contentTypeStr = contentType;
+  m_contentData = std::move(content);
+}
+
 void WSRequest::ClearContent()
 {
   m_contentData.clear();
@@ -274,7 +285,7 @@ bool WSRequest::WriteCommonHeading(WSRequestStreamSink& sink) const
     msg.append(ws_header_to_str(WS_HEADER_User_Agent)).append(": ").append(m_userAgent).append(WS_CRLF);
 
   // Connection
-  msg.append(ws_header_to_str(WS_HEADER_Connection)).append(": " REQUEST_CONNECTION WS_CRLF);
+  msg.append(ws_header_to_str(WS_HEADER_Connection)).append(m_keepAlive ? ": " REQUEST_KEEPALIVE WS_CRLF : ": " REQUEST_CONNECTION WS_CRLF);
 
   // Accept
   if (!m_accept.empty())
@@ -32,6 +32,7 @@
 #define REQUEST_PROTOCOL      "HTTP/1.1"
 #define REQUEST_USER_AGENT    LIBTAG "/" LIBVERSION
 #define REQUEST_CONNECTION    "close"
+#define REQUEST_KEEPALIVE     "keep-alive"
 #define REQUEST_STD_CHARSET   "utf-8"
 
 namespace NSROOT
@@ -60,11 +61,20 @@ namespace NSROOT
     void RequestAcceptEncoding(bool yesno);
     void SetUserAgent(const std::string& value);
 
+    /**
+     * By default the connection is borrowed from the pool of persistent
+     * connections, and given back once the response has been read.
+     * @param yesno false to close the connection after the response
+     */
+    void SetKeepAlive(bool yesno) { m_keepAlive = yesno; }
+    bool IsKeepAlive() const { return m_keepAlive; }
+
     void SetHeader(const std::string& field, const std::string& value);
     void ClearHeader(const std::string& field);
 
     void SetContentParam(const std::string& param, const std::string& value);
     void SetContentCustom(const std::string& contentType, const char *content);
+    void SetContentCustom(const std::string& contentType, std::string&& content);
     const std::string& GetContent() const { return m_contentData; }
     void ClearContent();
 
@@ -90,6 +100,7 @@ namespace NSROOT
     typedef std::pair<std::string, std::string> header_t;
     std::map<std::string, header_t> m_headers;
     std::string m_userAgent;
+    bool m_keepAlive;
 
     bool WriteCommonHeading(WSRequestStreamSink& sink) const;
     bool WriteMessageGET(WSRequestStreamSink& sink, const char* method) const;
@@ -27,6 +27,8 @@
 #include "builtin.h"
 #include "tokenizer.h"
 
+#include <algorithm>
+
 #define HTTP_TOKEN_MAXLEN     79
 #define HTTP_HEADER_MAXLEN    0x4000    // maximum header length (16k)
 #define QUERY_BUFFER_SIZE     0x400     // size of read buffer for headers
@@ -204,6 +206,7 @@ WSRequestBroker::WSRequestBroker(TcpSocket* socket, bool secure, int timeout)
 , m_hasContent(false)
 , m_contentChunked(false)
 , m_chunkNext(false)
+, m_keepAlive(false)
 , m_contentLength(0)
 , m_consumed(0)
 , m_chunkBuffer(nullptr)
@@ -295,6 +298,8 @@ bool WSRequestBroker::ParseQuery()
         m_requestUri = query[1];
         // set the requested protocol
         m_protocol = query[2];
+        // HTTP/1.1 defaults to persistent connection
+        m_keepAlive = (m_protocol.compare("HTTP/1.1") == 0);
         // Clear entries for next step
         m_requestHeaders.clear();
         ret = true;
@@ -372,6 +377,16 @@ bool WSRequestBroker::ParseQuery()
           m_chunkNext = true;
         }
         break;
+      case WS_HEADER_Connection:
+      {
+        std::string opt(newval);
+        std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+        if (opt.find("close") != std::string::npos)
+          m_keepAlive = false;
+        else if (opt.find("keep-alive") != std::string::npos)
+          m_keepAlive = true;
+        break;
+      }
       case WS_HEADER_Host:
         if (!ExplodeHost(newval, m_serverName, m_serverPort))
           ret = false;
@@ -472,12 +487,27 @@ int WSRequestBroker::ReadContent(char* buf, size_t buflen)
   return 0;
 }
 
+bool WSRequestBroker::IsContentConsumed() const
+{
+  if (!m_hasContent)
+    return true;
+  if (m_contentChunked)
+    return !m_chunkNext;
+  return (m_consumed >= m_contentLength);
+}
+
 bool WSRequestBroker::ReplyData(const char* data, size_t size)
 {
   m_bytesOut += size;
   return m_socket->SendData(data, size);
 }
 
+bool WSRequestBroker::ReplyFile(FILE * file, uint64_t offset, size_t size)
+{
+  m_bytesOut += size;
+  return m_socket->SendFile(file, offset, size);
+}
+
 bool WSRequestBroker::RewritePath(const std::string& newpath)
 {
   std::string path;
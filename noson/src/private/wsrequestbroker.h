@@ -26,12 +26,15 @@
 #include "wsstatic.h"
 #include "wsheader.h"
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <map>
 
 #define SERVER_PROTOCOL       "HTTP/1.1"
 #define SERVER_SOFTWARE       LIBTAG "/" LIBVERSION
 #define SERVER_CONNECTION     "close"
+#define SERVER_KEEPALIVE      "keep-alive"
 #define SERVER_STD_CHARSET    "utf-8"
 
 namespace NSROOT
@@ -70,6 +73,15 @@ namespace NSROOT
     size_t GetContentLength() const { return m_contentLength; }
     int ReadContent(char *buf, size_t buflen);
     size_t GetConsumed() const { return m_consumed; }
+    bool IsContentConsumed() const;
+
+    /**
+     * The connection persists when the client asked for it, and until the
+     * server or the reply has disabled it.
+     * @return true if the connection could be reused for the next request
+     */
+    bool IsKeepAlive() const { return m_keepAlive; }
+    void SetKeepAlive(bool yesno) { m_keepAlive = (yesno && m_keepAlive); }
 
     const VARS& GetRequestHeaders() const { return m_requestHeaders; }
 
@@ -78,6 +90,7 @@ namespace NSROOT
     static bool ExplodeHost(const std::string& host, std::string& nameStr, std::string& portStr);
 
     bool ReplyData(const char * data, size_t size);
+    bool ReplyFile(FILE * file, uint64_t offset, size_t size);
     bool RewritePath(const std::string& newpath);
 
     void SetAuthUser(const std::string& authUser) { m_authUser = authUser; }
@@ -107,6 +120,7 @@ namespace NSROOT
     bool m_hasContent;
     bool m_contentChunked;
     bool m_chunkNext;
+    bool m_keepAlive;
     size_t m_contentLength;
     size_t m_consumed;
     char* m_chunkBuffer;
@@ -25,6 +25,14 @@
 #include "debug.h"
 
 #include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#ifdef __WINDOWS__
+#define fseek64 _fseeki64
+#else
+#define fseek64 fseeko
+#endif
 
 using namespace NSROOT;
 
@@ -50,12 +58,16 @@ WSRequestReply::WSRequestReply(WSRequestBroker& rb)
 : m_broker(rb)
 , m_stage(STAGE_HEADER)
 , m_chunked(nullptr)
+, m_remaining(0)
 {
   (void)ResetReply();
 }
 
 WSRequestReply::~WSRequestReply()
 {
+  // the content has not been closed, so the connection cannot be reused
+  if (m_stage == STAGE_CONTENT)
+    m_broker.SetKeepAlive(false);
   if (m_chunked)
     delete m_chunked;
 }
@@ -119,7 +131,7 @@ bool WSRequestReply::ResetReply()
   }
   m_headers.clear();
   SetHeader(WS_HEADER_Server, SERVER_SOFTWARE);
-  SetHeader(WS_HEADER_Connection, SERVER_CONNECTION);
+  SetHeader(WS_HEADER_Connection, m_broker.IsKeepAlive() ? SERVER_KEEPALIVE : SERVER_CONNECTION);
   return true;
 }
 
@@ -137,26 +149,27 @@ bool WSRequestReply::PostReply(WS_STATUS status)
   }
   m_stage = STAGE_CLOSE;
   m_broker.SetStatus(status);
+  // a persistent connection requires the content to be delimited
+  if (m_broker.IsKeepAlive() && m_broker.GetRequestMethod() != WS_METHOD_Head &&
+          m_headers.find(ws_header_to_upperstr(WS_HEADER_Content_Length)) == m_headers.end() &&
+          m_headers.find(ws_header_to_upperstr(WS_HEADER_Transfer_Encoding)) == m_headers.end())
+    SetHeader(WS_HEADER_Content_Length, "0");
+  // the header is sent in one write: small segments would be delayed by the
+  // Nagle algorithm on a persistent connection
   std::string data;
-  data.reserve(127);
+  data.reserve(255);
   data.append(SERVER_PROTOCOL " ")
       .append(ws_status_to_numstr(status))
       .append(" ")
       .append(ws_status_to_msgstr(status))
       .append(WS_CRLF);
-  if (!m_broker.ReplyData(data.c_str(), data.size()))
-    return false;
   for (auto& e : m_headers)
   {
     for (auto it = e.second.cbegin(); it != e.second.cend(); ++it)
-    {
-      data.assign(e.second.Name()).append(": ").append(*it);
-      data.append(WS_CRLF);
-      if (!m_broker.ReplyData(data.c_str(), data.size()))
-        return false;
-    }
+      data.append(e.second.Name()).append(": ").append(*it).append(WS_CRLF);
   }
-  return m_broker.ReplyData(WS_CRLF, WS_CRLF_LEN);
+  data.append(WS_CRLF);
+  return m_broker.ReplyData(data.c_str(), data.size());
 }
 
 bool WSRequestReply::BeginContent(WS_STATUS status, int chunkSize)
@@ -170,6 +183,17 @@ bool WSRequestReply::BeginContent(WS_STATUS status, int chunkSize)
   return true;
 }
 
+bool WSRequestReply::BeginContentLength(WS_STATUS status, uint64_t length)
+{
+  SetHeader(WS_HEADER_Transfer_Encoding, "");
+  SetHeader(WS_HEADER_Content_Length, std::to_string(length));
+  if (!PostReply(status))
+    return false;
+  m_remaining = length;
+  m_stage = STAGE_CONTENT;
+  return true;
+}
+
 bool WSRequestReply::WriteData(const char* data, int len)
 {
   if (m_stage != STAGE_CONTENT)
@@ -177,6 +201,16 @@ bool WSRequestReply::WriteData(const char* data, int len)
     DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
     return false;
   }
+  if (!m_chunked)
+  {
+    if ((uint64_t)len > m_remaining)
+    {
+      DBG(DBG_ERROR, "%s: content length exceeded\n", __FUNCTION__);
+      return false;
+    }
+    m_remaining -= len;
+    return m_broker.ReplyData(data, len);
+  }
   if (m_chunked->Write(data, len) == len)
     return true;
   return false;
@@ -189,6 +223,11 @@ int WSRequestReply::WriteFileStream(FILE* file)
     DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
     return false;
   }
+  if (!m_chunked)
+  {
+    DBG(DBG_ERROR, "%s: content is not encoded\n", __FUNCTION__);
+    return -1;
+  }
   return m_chunked->WriteFileStream(file);
 }
 
@@ -199,6 +238,11 @@ int WSRequestReply::WriteFileStream(FILE* file, unsigned maxlen)
     DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
     return false;
   }
+  if (!m_chunked)
+  {
+    DBG(DBG_ERROR, "%s: content is not encoded\n", __FUNCTION__);
+    return -1;
+  }
   return m_chunked->WriteFileStream(file, maxlen);
 }
 
@@ -209,6 +253,11 @@ int WSRequestReply::WriteInputStream(InputStream& in)
     DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
     return false;
   }
+  if (!m_chunked)
+  {
+    DBG(DBG_ERROR, "%s: content is not encoded\n", __FUNCTION__);
+    return -1;
+  }
   return m_chunked->WriteInputStream(in);
 }
 
@@ -219,7 +268,36 @@ bool WSRequestReply::WriteString(const char* str)
     DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
     return false;
   }
-  return m_chunked->Write(str, strlen(str));
+  return WriteData(str, (int)strlen(str));
+}
+
+bool WSRequestReply::WriteFileRange(FILE* file, uint64_t offset, size_t size)
+{
+  if (m_stage != STAGE_CONTENT)
+  {
+    DBG(DBG_ERROR, "%s: bad stage (%d)\n", __FUNCTION__, m_stage);
+    return false;
+  }
+  if (!m_chunked)
+  {
+    if ((uint64_t)size > m_remaining)
+    {
+      DBG(DBG_ERROR, "%s: content length exceeded\n", __FUNCTION__);
+      return false;
+    }
+    m_remaining -= size;
+    return m_broker.ReplyFile(file, offset, size);
+  }
+  if (fseek64(file, (int64_t)offset, SEEK_SET) != 0)
+    return false;
+  while (size > 0)
+  {
+    int r = m_chunked->WriteFileStream(file, (unsigned)size);
+    if (r <= 0)
+      return false;
+    size -= (size_t)r;
+  }
+  return true;
 }
 
 bool WSRequestReply::CloseContent()
@@ -229,8 +307,21 @@ bool WSRequestReply::CloseContent()
   if (m_stage != STAGE_CONTENT)
     return false;
   m_stage = STAGE_CLOSE;
+  if (!m_chunked)
+  {
+    // the content is delimited by its length
+    if (m_remaining > 0)
+    {
+      DBG(DBG_ERROR, "%s: content is incomplete (%" PRIu64 ")\n", __FUNCTION__, m_remaining);
+      m_broker.SetKeepAlive(false);
+    }
+    return true;
+  }
   if (!m_chunked->Flush())
+  {
     DBG(DBG_ERROR, "%s: chunk flush failed\n", __FUNCTION__);
+    m_broker.SetKeepAlive(false);
+  }
   delete m_chunked;
   m_chunked = nullptr;
   return true;
@@ -240,6 +331,7 @@ WSRequestReply::STAGE WSRequestReply::Abort()
 {
    STAGE s = m_stage;
    m_stage = STAGE_CLOSE;
+   m_broker.SetKeepAlive(false);
    return s;
 }
 
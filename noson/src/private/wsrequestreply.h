@@ -66,7 +66,9 @@ namespace NSROOT
     bool ResetReply();
 
     /**
-     * Post the header with the given status, and close reply.
+     * Post the header with the given status, and close reply. On persistent
+     * connection the content must be delimited, therefore an empty content
+     * is assumed when neither length nor transfer encoding is set.
      * Note: Only valid at stage HEADER.
      * @param status The reply status
      * @return true on success, else false
@@ -82,6 +84,18 @@ namespace NSROOT
      */
     bool BeginContent(WS_STATUS status, int chunkSize);
 
+    /**
+     * Post the header with the given status and content length, and
+     * initialize the content stream without transfer encoding. Regions
+     * of file written by WriteFileRange() are then transmitted with
+     * zero-copy when the socket supports it. The stage move to CONTENT.
+     * Note: Only valid at stage HEADER.
+     * @param status The reply status
+     * @param length The exact byte count of the content
+     * @return true on success, else false
+     */
+    bool BeginContentLength(WS_STATUS status, uint64_t length);
+
     /**
      * Write data in content stream.
      * Note: Only valid at stage CONTENT.
@@ -110,6 +124,16 @@ namespace NSROOT
      */
     int WriteFileStream(FILE* file, unsigned maxlen);
 
+    /**
+     * Write a region of FILE stream into the content stream.
+     * Note: Only valid at stage CONTENT.
+     * @param file
+     * @param offset The position of the first byte in the file
+     * @param size The byte count to send
+     * @return true on success, else false
+     */
+    bool WriteFileRange(FILE* file, uint64_t offset, size_t size);
+
 
     /**
      * Write imput stream into the content stream.
@@ -140,7 +164,7 @@ namespace NSROOT
     /**
      * Abort the reply, without flushing content or posting header.
      * Note that already posted data cannot be cancelled; and the reply
-     * won't be reusable.
+     * won't be reusable, nor the connection.
      * @return the stage before aborting
      */
     STAGE Abort();
@@ -160,6 +184,7 @@ namespace NSROOT
 
     STAGE m_stage;
     WSReplyChunked* m_chunked;
+    uint64_t m_remaining;     ///< content left to send without encoding
 
     // prevent copy
     WSRequestReply(const WSRequestReply&);
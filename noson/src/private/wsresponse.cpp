@@ -21,9 +21,11 @@
 
 #include "wsresponse.h"
 #include "securesocket.h"
+#include "wsconnectionpool.h"
 #include "compressor.h"
 #include "debug.h"
 
+#include <algorithm>
 #include <cstdlib>  // for atol
 #include <cstdio>
 #include <cstring>
@@ -39,7 +41,7 @@ using namespace NSROOT;
 
 void WSResponse::init(const WSRequest &request, int maxRedirs, bool trustedLocation, bool followAny)
 {
-  p = new _response(request);
+  p = new _response(request, false);
   while (0 < maxRedirs--)
   {
     int status = p->GetStatusCode();
@@ -68,7 +70,7 @@ void WSResponse::init(const WSRequest &request, int maxRedirs, bool trustedLocat
           redir.ClearHeader("COOKIE");
         }
         delete p;
-        p = new _response(redir);
+        p = new _response(redir, false);
         continue;
       }
     }
@@ -125,8 +127,8 @@ bool WSResponse::ReadHeaderLine(NetSocket *socket, const char *eol, std::string&
     }
     else
     {
-      /* No EOL found until end of data */
-      *len = l;
+      /* No EOL found until end of data: return the count of received bytes */
+      *len = l + p;
       return false;
     }
   }
@@ -136,8 +138,12 @@ bool WSResponse::ReadHeaderLine(NetSocket *socket, const char *eol, std::string&
   return true;
 }
 
-WSResponse::_response::_response(const WSRequest &request)
+WSResponse::_response::_response(const WSRequest &request, bool deferred)
 : m_socket(nullptr)
+, m_pooled(request.IsKeepAlive())
+, m_server(request.GetServer())
+, m_port(request.GetPort())
+, m_secure(request.IsSecureURI())
 , m_successful(false)
 , m_statusCode(0)
 , m_serverInfo()
@@ -148,6 +154,10 @@ WSResponse::_response::_response(const WSRequest &request)
 , m_contentEmpty(false)
 , m_contentChunked(false)
 , m_chunkNext(false)
+, m_chunkEnded(false)
+, m_noBody(request.GetMethod() == WS_METHOD_Head)
+, m_persistent(false)
+, m_broken(false)
 , m_contentLength(0)
 , m_consumed(0)
 , m_chunkBuffer(nullptr)
@@ -155,33 +165,16 @@ WSResponse::_response::_response(const WSRequest &request)
 , m_chunkEOR(nullptr)
 , m_chunkEnd(nullptr)
 , m_decoder(nullptr)
+, m_request(nullptr)
+, m_reused(false)
+, m_closed(false)
 {
-  if (request.IsSecureURI())
-    m_socket = SSLSessionFactory::Instance().NewClientSocket();
-  else
-    m_socket = new TcpSocket();
-  if (!m_socket)
-    DBG(DBG_ERROR, "%s: create socket failed\n", __FUNCTION__);
-  else if (m_socket->Connect(request.GetServer().c_str(), request.GetPort(), SOCKET_RCVBUF_MINSIZE))
+  if (Send(request, false))
   {
-    m_socket->SetReadAttempt(6); // 60 sec to hang up
-    if (!request.WriteMessage(*this))
-      DBG(DBG_WARN, "%s: broken request\n", __FUNCTION__);
-    if (ReadResponse())
-    {
-      if (m_statusCode < 200)
-        DBG(DBG_WARN, "%s: status %d\n", __FUNCTION__, m_statusCode);
-      else if (m_statusCode < 300)
-        m_successful = true;
-      else if (m_statusCode < 400)
-        m_successful = false;
-      else if (m_statusCode < 500)
-        DBG(DBG_ERROR, "%s: bad request (%d)\n", __FUNCTION__, m_statusCode);
-      else
-        DBG(DBG_ERROR, "%s: server error (%d)\n", __FUNCTION__, m_statusCode);
-    }
+    if (deferred)
+      m_request = new WSRequest(request);
     else
-      DBG(DBG_ERROR, "%s: invalid response\n", __FUNCTION__);
+      Receive(request);
   }
 }
 
@@ -193,11 +186,112 @@ WSResponse::_response::~_response()
   if (m_chunkBuffer)
     delete [] m_chunkBuffer;
   m_chunkBuffer = m_chunkPtr = m_chunkEOR = m_chunkEnd = nullptr;
-  if (m_socket)
+  if (m_request)
+    delete m_request;
+  m_request = nullptr;
+  Disconnect(IsReusable());
+}
+
+bool WSResponse::_response::Send(const WSRequest& request, bool fresh)
+{
+  if (!Connect(fresh, &m_reused))
+    return false;
+  m_socket->SetReadAttempt(6); // 60 sec to hang up
+  if (!request.WriteMessage(*this))
+    DBG(DBG_WARN, "%s: broken request\n", __FUNCTION__);
+  return true;
+}
+
+bool WSResponse::_response::Receive(const WSRequest& request)
+{
+  bool ok = ReadResponse();
+  if (!ok && m_reused && m_closed)
+  {
+    // the server closed the persistent connection meanwhile, so it hasn't
+    // processed the request: retry once on a new connection. A timeout or a
+    // partial response isn't retried, as the action could run twice.
+    DBG(DBG_DEBUG, "%s: connection was closed, retry\n", __FUNCTION__);
+    Disconnect(false);
+    ok = Send(request, true) && ReadResponse();
+  }
+  if (!ok)
+  {
+    DBG(DBG_ERROR, "%s: invalid response\n", __FUNCTION__);
+    return false;
+  }
+  if (m_statusCode < 200)
+    DBG(DBG_WARN, "%s: status %d\n", __FUNCTION__, m_statusCode);
+  else if (m_statusCode < 300)
+    m_successful = true;
+  else if (m_statusCode < 400)
+    m_successful = false;
+  else if (m_statusCode < 500)
+    DBG(DBG_ERROR, "%s: bad request (%d)\n", __FUNCTION__, m_statusCode);
+  else
+    DBG(DBG_ERROR, "%s: server error (%d)\n", __FUNCTION__, m_statusCode);
+  return true;
+}
+
+bool WSResponse::_response::ReceiveDeferred()
+{
+  if (!m_request)
+    return false;
+  bool ok = Receive(*m_request);
+  delete m_request;
+  m_request = nullptr;
+  return ok;
+}
+
+bool WSResponse::_response::Connect(bool fresh, bool *reused)
+{
+  *reused = false;
+  if (m_pooled)
+  {
+    m_socket = WSConnectionPool::Instance().Acquire(m_server, m_port, m_secure, reused, fresh);
+    return (m_socket != nullptr);
+  }
+  if (m_secure)
+    m_socket = SSLSessionFactory::Instance().NewClientSocket();
+  else
+    m_socket = new TcpSocket();
+  if (!m_socket)
+  {
+    DBG(DBG_ERROR, "%s: create socket failed\n", __FUNCTION__);
+    return false;
+  }
+  return m_socket->Connect(m_server.c_str(), m_port, SOCKET_RCVBUF_MINSIZE);
+}
+
+void WSResponse::_response::Disconnect(bool reusable)
+{
+  if (!m_socket)
+    return;
+  if (m_pooled)
+    WSConnectionPool::Instance().Release(m_server, m_port, m_secure, m_socket, reusable);
+  else
     delete m_socket;
   m_socket = nullptr;
 }
 
+net_socket_t WSResponse::_response::GetSocketHandle() const
+{
+  return (m_socket ? m_socket->GetHandle() : INVALID_SOCKET_VALUE);
+}
+
+bool WSResponse::_response::IsReusable() const
+{
+  if (!m_pooled || !m_socket || !m_persistent || m_broken || m_statusCode < 200)
+    return false;
+  // the connection is reusable once the message body has been fully read
+  if (m_noBody || m_statusCode == 204 || m_statusCode == 304)
+    return true;
+  if (m_contentChunked)
+    return m_chunkEnded;
+  if (m_contentEmpty)
+    return true;
+  return (m_contentLength > 0 && m_consumed >= m_contentLength);
+}
+
 bool WSResponse::_response::WriteRequestStream(const char * data, unsigned len)
 {
   if (!m_chunkBuffer)
@@ -260,6 +354,7 @@ bool WSResponse::_response::ReadResponse()
   bool ret = false;
 
   token[0] = 0;
+  m_closed = false;
   while (WSResponse::ReadHeaderLine(m_socket, WS_CRLF, strread, &len))
   {
     /* The response length shouldn't exceed the limit */
@@ -283,6 +378,8 @@ bool WSResponse::_response::ReadResponse()
       {
         /* We have received a valid feedback */
         m_statusCode = status;
+        /* HTTP/1.1 connections are persistent by default */
+        m_persistent = (0 == memcmp(line, "HTTP/1.1", 8));
         ret = true;
       }
       else
@@ -347,6 +444,16 @@ bool WSResponse::_response::ReadResponse()
         case WS_HEADER_Location:
           m_location.assign(newval);
           break;
+        case WS_HEADER_Connection:
+        {
+          std::string opt(newval);
+          std::transform(opt.begin(), opt.end(), opt.begin(), ::tolower);
+          if (opt.find("close") != std::string::npos)
+            m_persistent = false;
+          else if (opt.find("keep-alive") != std::string::npos)
+            m_persistent = true;
+          break;
+        }
         case WS_HEADER_Content_Type:
           m_hasContent = true;
           break;
@@ -378,6 +485,9 @@ bool WSResponse::_response::ReadResponse()
     }
   }
 
+  /* Nothing received: the connection was closed unless the read timed out */
+  if (n == 0 && len == 0 && m_socket->GetErrNo() != ETIMEDOUT)
+    m_closed = true;
   return ret;
 }
 
@@ -418,6 +528,7 @@ int WSResponse::_response::ReadChunk(void *buf, size_t buflen)
       {
         // read chunk trailers
         while (WSResponse::ReadHeaderLine(m_socket, WS_CRLF, strread, &len) && len != 0);
+        m_chunkEnded = true;
         return 0; // that's the end of chunks
       }
     }
@@ -454,7 +565,10 @@ int WSResponse::_response::SocketStreamReader(void *hdl, void *buf, int sz)
     s = (int)resp->m_socket->ReceiveData(buf, len > (size_t)sz ? (size_t)sz : len);
   }
   if (s <= 0)
+  {
+    resp->m_broken = (resp->m_contentLength > resp->m_consumed);
     resp->m_consumed = resp->m_contentLength;
+  }
   else
     resp->m_consumed += s;
   return s;
@@ -484,7 +598,10 @@ int WSResponse::_response::ReadContent(char* buf, size_t buflen)
         size_t len = m_contentLength - m_consumed;
         int s = (int)m_socket->ReceiveData(buf, len > buflen ? buflen : len);
         if (s <= 0)
+        {
+          m_broken = true;
           m_consumed = m_contentLength;
+        }
         else
           m_consumed += s;
         return s;
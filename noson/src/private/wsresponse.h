@@ -26,6 +26,7 @@
 #include "wsstatic.h"
 #include "wsheader.h"
 #include "wsrequest.h"
+#include "os/os.h"
 
 #include <cstddef>  // for size_t
 #include <string>
@@ -47,8 +48,29 @@ namespace NSROOT
     { init(request, 1, true, false); }
     WSResponse(const WSRequest &request, int maxRedirs, bool trustedLocation, bool followAny)
     { init(request, maxRedirs, trustedLocation, followAny); }
+    /**
+     * Send the request. When deferred, it returns without waiting for the
+     * response: Receive() has to be called to read it. Redirection isn't
+     * followed in this case.
+     */
+    WSResponse(const WSRequest &request, bool deferred)
+    { p = new _response(request, deferred); }
     ~WSResponse();
 
+    /**
+     * Read the status and headers of a deferred response.
+     * @return true if a response is received, else false
+     */
+    bool Receive() { return p->ReceiveDeferred(); }
+    /**
+     * @return true when the request is sent and the response is awaiting
+     */
+    bool IsPending() const { return p->IsPending(); }
+    /**
+     * @return the handle of the connection to poll for the response
+     */
+    net_socket_t GetSocketHandle() const { return p->GetSocketHandle(); }
+
     bool IsSuccessful() const { return p->IsSuccessful(); }
     bool IsChunkedTransfer() const { return p->IsChunkedTransfer(); }
     size_t GetContentLength() const { return p->GetContentLength(); }
@@ -83,9 +105,13 @@ namespace NSROOT
     class _response : private WSRequestStreamSink
     {
     public:
-      _response(const WSRequest& request);
+      _response(const WSRequest& request, bool deferred);
       virtual ~_response();
 
+      bool ReceiveDeferred();
+      bool IsPending() const { return m_request != nullptr; }
+      net_socket_t GetSocketHandle() const;
+
       bool IsSuccessful() const { return m_successful; }
       bool IsChunkedTransfer() const { return m_contentChunked; }
       size_t GetContentLength() const { return m_contentLength; }
@@ -100,6 +126,10 @@ namespace NSROOT
 
     private:
       TcpSocket *m_socket;
+      bool m_pooled;            ///< The socket is borrowed from the connection pool
+      std::string m_server;
+      unsigned m_port;
+      bool m_secure;
       bool m_successful;
       int m_statusCode;
       std::string m_serverInfo;
@@ -110,6 +140,10 @@ namespace NSROOT
       bool m_contentEmpty;
       bool m_contentChunked;
       bool m_chunkNext;
+      bool m_chunkEnded;        ///< The last chunk has been read
+      bool m_noBody;            ///< The response has no message body
+      bool m_persistent;        ///< The server keeps the connection alive
+      bool m_broken;            ///< Reading the message body failed
       size_t m_contentLength;
       size_t m_consumed;
       char* m_chunkBuffer;      ///< The chunk data buffer
@@ -117,6 +151,9 @@ namespace NSROOT
       char* m_chunkEOR;         ///< The end of received data in the chunk
       char* m_chunkEnd;         ///< The end of the chunk buffer
       Decompressor *m_decoder;
+      WSRequest *m_request;     ///< The sent request awaiting response
+      bool m_reused;            ///< The connection was idle in the pool
+      bool m_closed;            ///< The connection was closed before any byte of the response
 
       VARS m_headers;
 
@@ -124,6 +161,12 @@ namespace NSROOT
       _response(const _response&);
       _response& operator=(const _response&);
 
+      bool Send(const WSRequest& request, bool fresh);
+      bool Receive(const WSRequest& request);
+      bool Connect(bool fresh, bool *reused);
+      void Disconnect(bool reusable);
+      bool IsReusable() const;
+
       bool WriteRequestStream(const char * data, unsigned len) override;
       bool FlushRequestStream() override;
 
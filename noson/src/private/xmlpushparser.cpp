@@ -0,0 +1,619 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "xmlpushparser.h"
+
+#include <cstring>
+
+#define XMLPUSHPARSER_ENTITY_MAXLEN   10
+#define XMLPUSHPARSER_TEXT_FLUSH      1024
+
+using namespace NSROOT;
+
+namespace
+{
+inline bool is_space(char c)
+{
+  return (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+}
+
+inline bool is_name(char c)
+{
+  return !(is_space(c) || c == '>' || c == '/' || c == '=' || c == '<' || c == '"' || c == '\'');
+}
+
+void append_utf8(std::string& out, unsigned long cp)
+{
+  if (cp < 0x80)
+    out.push_back((char)cp);
+  else if (cp < 0x800)
+  {
+    out.push_back((char)(0xC0 | (cp >> 6)));
+    out.push_back((char)(0x80 | (cp & 0x3F)));
+  }
+  else if (cp < 0x10000)
+  {
+    out.push_back((char)(0xE0 | (cp >> 12)));
+    out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (cp & 0x3F)));
+  }
+  else
+  {
+    out.push_back((char)(0xF0 | (cp >> 18)));
+    out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (cp & 0x3F)));
+  }
+}
+
+bool decode_entity(const char* s, size_t n, std::string& out)
+{
+  switch (n)
+  {
+  case 2:
+    if (s[1] == 't' && (s[0] == 'l' || s[0] == 'g'))
+    {
+      out.push_back(s[0] == 'l' ? '<' : '>');
+      return true;
+    }
+    break;
+  case 3:
+    if (memcmp(s, "amp", 3) == 0)
+    {
+      out.push_back('&');
+      return true;
+    }
+    break;
+  case 4:
+    if (memcmp(s, "quot", 4) == 0 || memcmp(s, "apos", 4) == 0)
+    {
+      out.push_back(s[0] == 'q' ? '"' : '\'');
+      return true;
+    }
+    break;
+  default:
+    break;
+  }
+  if (n > 1 && s[0] == '#')
+  {
+    unsigned long cp = 0;
+    size_t i = 1;
+    int base = 10;
+    if (s[1] == 'x' || s[1] == 'X')
+    {
+      base = 16;
+      ++i;
+    }
+    if (i == n)
+      return false;
+    for (; i < n; ++i)
+    {
+      char c = s[i];
+      int d;
+      if (c >= '0' && c <= '9')
+        d = c - '0';
+      else if (base == 16 && c >= 'a' && c <= 'f')
+        d = c - 'a' + 10;
+      else if (base == 16 && c >= 'A' && c <= 'F')
+        d = c - 'A' + 10;
+      else
+        return false;
+      cp = cp * base + d;
+      if (cp > 0x10FFFF)
+        return false;
+    }
+    if (cp == 0)
+      return false;
+    append_utf8(out, cp);
+    return true;
+  }
+  // keep the unknown entity as is
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (is_space(s[i]) || s[i] == '<' || s[i] == '&')
+      return false;
+  }
+  out.push_back('&');
+  out.append(s, n).push_back(';');
+  return true;
+}
+}
+
+XMLPushParser::XMLPushParser(Handler& handler)
+: m_handler(handler)
+{
+  m_text.reserve(XMLPUSHPARSER_TEXT_FLUSH);
+  m_attrs.reserve(4);
+  m_stack.reserve(8);
+  Reset();
+}
+
+void XMLPushParser::Reset()
+{
+  m_state = STATE_TEXT;
+  m_quote = 0;
+  m_marks = 0;
+  m_inEntity = false;
+  m_rootClosed = false;
+  m_text.clear();
+  m_entity.clear();
+  m_name.clear();
+  m_markup.clear();
+  m_attrCount = 0;
+  m_depth = 0;
+}
+
+const std::string* XMLPushParser::FindAttribute(const char* name, const Attribute* attrs, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (attrs[i].name.compare(name) == 0)
+      return &(attrs[i].value);
+  }
+  return nullptr;
+}
+
+bool XMLPushParser::Fail()
+{
+  m_state = STATE_ERROR;
+  return false;
+}
+
+bool XMLPushParser::FlushText()
+{
+  if (m_text.empty())
+    return true;
+  bool ret = true;
+  if (m_depth > 0)
+    ret = m_handler.CharData(m_text.data(), m_text.size());
+  else
+  {
+    // outside the root only blanks are allowed
+    for (char c : m_text)
+    {
+      if (!is_space(c))
+      {
+        ret = false;
+        break;
+      }
+    }
+  }
+  m_text.clear();
+  return ret;
+}
+
+const char* XMLPushParser::ParseEntity(const char* p, const char* end, std::string& out)
+{
+  // the entity is decoded in place when it is complete in the chunk
+  size_t len = end - p;
+  const char* e = (const char*)memchr(p, ';', len > XMLPUSHPARSER_ENTITY_MAXLEN ? XMLPUSHPARSER_ENTITY_MAXLEN + 1 : len);
+  if (e)
+    return (decode_entity(p, e - p, out) ? e + 1 : nullptr);
+  if (len > XMLPUSHPARSER_ENTITY_MAXLEN)
+    return nullptr;
+  m_entity.assign(p, len);
+  m_inEntity = true;
+  return end;
+}
+
+XMLPushParser::Attribute& XMLPushParser::NewAttribute()
+{
+  if (m_attrCount >= m_attrs.size())
+    m_attrs.push_back(Attribute());
+  Attribute& attr = m_attrs[m_attrCount++];
+  attr.name.clear();
+  attr.value.clear();
+  return attr;
+}
+
+bool XMLPushParser::EmitStart(bool empty)
+{
+  if (m_rootClosed)
+    return false;
+  if (m_depth < m_stack.size())
+    m_stack[m_depth].assign(m_name);
+  else
+    m_stack.push_back(m_name);
+  ++m_depth;
+  if (!m_handler.StartElement(m_name, m_attrs.data(), m_attrCount))
+    return false;
+  if (empty)
+    return EmitEnd();
+  return true;
+}
+
+bool XMLPushParser::EmitEnd()
+{
+  if (m_depth == 0 || m_stack[m_depth - 1] != m_name)
+    return false;
+  --m_depth;
+  if (m_depth == 0)
+    m_rootClosed = true;
+  return m_handler.EndElement(m_name);
+}
+
+bool XMLPushParser::Feed(const char* data, size_t len)
+{
+  const char* p = data;
+  const char* end = data + len;
+  while (p < end)
+  {
+    if (m_state == STATE_ERROR)
+      return false;
+
+    // complete the entity split over chunks
+    if (m_inEntity)
+    {
+      char c = *p++;
+      if (c != ';')
+      {
+        if (m_entity.size() >= XMLPUSHPARSER_ENTITY_MAXLEN)
+          return Fail();
+        m_entity.push_back(c);
+        continue;
+      }
+      m_inEntity = false;
+      if (!decode_entity(m_entity.data(), m_entity.size(),
+                         m_state == STATE_TEXT ? m_text : m_attrs[m_attrCount - 1].value))
+        return Fail();
+      continue;
+    }
+
+    switch (m_state)
+    {
+    case STATE_TEXT:
+    {
+      while (p < end)
+      {
+        const char* s = p;
+        while (p < end && *p != '<' && *p != '&')
+          ++p;
+        m_text.append(s, p - s);
+        if (p == end)
+          break;
+        if (*p == '<')
+        {
+          ++p;
+          if (!FlushText())
+            return Fail();
+          m_state = STATE_MARKUP;
+          break;
+        }
+        if (!(p = ParseEntity(p + 1, end, m_text)))
+          return Fail();
+        if (m_text.size() >= XMLPUSHPARSER_TEXT_FLUSH && m_depth > 0 && !FlushText())
+          return Fail();
+      }
+      break;
+    }
+
+    case STATE_MARKUP:
+    {
+      char c = *p++;
+      if (c == '/')
+      {
+        m_name.clear();
+        m_state = STATE_END_NAME;
+      }
+      else if (c == '!')
+      {
+        m_markup.clear();
+        m_state = STATE_BANG;
+      }
+      else if (c == '?')
+      {
+        m_marks = 0;
+        m_state = STATE_PI;
+      }
+      else if (is_name(c))
+      {
+        m_name.assign(1, c);
+        m_attrCount = 0;
+        m_state = STATE_START_NAME;
+      }
+      else
+        return Fail();
+      break;
+    }
+
+    case STATE_START_NAME:
+    {
+      const char* s = p;
+      while (p < end && is_name(*p))
+        ++p;
+      m_name.append(s, p - s);
+      if (p < end)
+      {
+        char c = *p++;
+        if (c == '>')
+        {
+          m_state = STATE_TEXT;
+          if (!EmitStart(false))
+            return Fail();
+        }
+        else if (c == '/')
+          m_state = STATE_EMPTY;
+        else if (is_space(c))
+          m_state = STATE_TAG;
+        else
+          return Fail();
+      }
+      break;
+    }
+
+    case STATE_TAG:
+    {
+      char c = *p++;
+      if (is_space(c))
+        break;
+      if (c == '>')
+      {
+        m_state = STATE_TEXT;
+        if (!EmitStart(false))
+          return Fail();
+      }
+      else if (c == '/')
+        m_state = STATE_EMPTY;
+      else if (is_name(c))
+      {
+        NewAttribute().name.push_back(c);
+        m_state = STATE_ATTR_NAME;
+      }
+      else
+        return Fail();
+      break;
+    }
+
+    case STATE_ATTR_NAME:
+    {
+      const char* s = p;
+      while (p < end && is_name(*p))
+        ++p;
+      m_attrs[m_attrCount - 1].name.append(s, p - s);
+      if (p < end)
+      {
+        char c = *p++;
+        if (c == '=')
+          m_state = STATE_ATTR_QUOTE;
+        else if (is_space(c))
+          m_state = STATE_ATTR_EQ;
+        else
+          return Fail();
+      }
+      break;
+    }
+
+    case STATE_ATTR_EQ:
+    {
+      char c = *p++;
+      if (c == '=')
+        m_state = STATE_ATTR_QUOTE;
+      else if (!is_space(c))
+        return Fail();
+      break;
+    }
+
+    case STATE_ATTR_QUOTE:
+    {
+      char c = *p++;
+      if (c == '"' || c == '\'')
+      {
+        m_quote = c;
+        m_state = STATE_ATTR_VALUE;
+      }
+      else if (!is_space(c))
+        return Fail();
+      break;
+    }
+
+    case STATE_ATTR_VALUE:
+    {
+      std::string& value = m_attrs[m_attrCount - 1].value;
+      while (p < end)
+      {
+        const char* s = p;
+        while (p < end && *p != m_quote && *p != '&' && *p != '<')
+          ++p;
+        value.append(s, p - s);
+        if (p == end)
+          break;
+        char c = *p;
+        if (c == '&')
+        {
+          if (!(p = ParseEntity(p + 1, end, value)))
+            return Fail();
+          continue;
+        }
+        if (c != m_quote)
+          return Fail();
+        ++p;
+        m_state = STATE_TAG;
+        break;
+      }
+      break;
+    }
+
+    case STATE_EMPTY:
+    {
+      if (*p++ != '>')
+        return Fail();
+      m_state = STATE_TEXT;
+      if (!EmitStart(true))
+        return Fail();
+      break;
+    }
+
+    case STATE_END_NAME:
+    {
+      const char* s = p;
+      while (p < end && is_name(*p))
+        ++p;
+      m_name.append(s, p - s);
+      if (p < end)
+      {
+        char c = *p++;
+        if (c == '>')
+        {
+          m_state = STATE_TEXT;
+          if (!EmitEnd())
+            return Fail();
+        }
+        else if (is_space(c))
+          m_state = STATE_END_SPACE;
+        else
+          return Fail();
+      }
+      break;
+    }
+
+    case STATE_END_SPACE:
+    {
+      char c = *p++;
+      if (c == '>')
+      {
+        m_state = STATE_TEXT;
+        if (!EmitEnd())
+          return Fail();
+      }
+      else if (!is_space(c))
+        return Fail();
+      break;
+    }
+
+    case STATE_BANG:
+    {
+      static const char comment[] = "--";
+      static const char cdata[] = "[CDATA[";
+      m_markup.push_back(*p++);
+      if (m_markup.compare(0, m_markup.size(), comment, 0, m_markup.size()) == 0)
+      {
+        if (m_markup.size() == sizeof(comment) - 1)
+        {
+          m_marks = 0;
+          m_state = STATE_COMMENT;
+        }
+      }
+      else if (m_markup.compare(0, m_markup.size(), cdata, 0, m_markup.size()) == 0)
+      {
+        if (m_markup.size() == sizeof(cdata) - 1)
+        {
+          if (m_depth == 0)
+            return Fail();
+          m_marks = 0;
+          m_state = STATE_CDATA;
+        }
+      }
+      else
+      {
+        // a declaration as DOCTYPE: restart the scan from its first char
+        m_marks = 0;
+        m_state = STATE_DECL;
+        p -= 1;
+      }
+      break;
+    }
+
+    case STATE_COMMENT:
+    {
+      char c = *p++;
+      if (c == '-')
+        ++m_marks;
+      else if (c == '>' && m_marks >= 2)
+        m_state = STATE_TEXT;
+      else
+        m_marks = 0;
+      break;
+    }
+
+    case STATE_CDATA:
+    {
+      // the raw content is appended to the text
+      const char* s = p;
+      if (m_marks == 0)
+      {
+        while (p < end && *p != ']')
+          ++p;
+        m_text.append(s, p - s);
+        if (p == end)
+          break;
+      }
+      char c = *p++;
+      if (c == ']')
+      {
+        if (m_marks < 2)
+          ++m_marks;
+        else
+          m_text.push_back(']');
+      }
+      else if (c == '>' && m_marks == 2)
+      {
+        m_marks = 0;
+        m_state = STATE_TEXT;
+      }
+      else
+      {
+        m_text.append(m_marks, ']').push_back(c);
+        m_marks = 0;
+      }
+      break;
+    }
+
+    case STATE_DECL:
+    {
+      // m_marks counts the nesting of the internal subset
+      char c = *p++;
+      if (c == '[')
+        ++m_marks;
+      else if (c == ']' && m_marks > 0)
+        --m_marks;
+      else if (c == '>' && m_marks == 0)
+        m_state = STATE_TEXT;
+      break;
+    }
+
+    case STATE_PI:
+    {
+      char c = *p++;
+      if (c == '>' && m_marks)
+        m_state = STATE_TEXT;
+      else
+        m_marks = (c == '?' ? 1 : 0);
+      break;
+    }
+
+    default:
+      return Fail();
+    }
+  }
+  // pass on the pending text, so a large content is not held until its end
+  if (m_state == STATE_TEXT && m_depth > 0 && !FlushText())
+    return Fail();
+  return (m_state != STATE_ERROR);
+}
+
+bool XMLPushParser::Finish()
+{
+  if (m_state != STATE_TEXT || m_inEntity)
+    return Fail();
+  if (!FlushText() || !m_rootClosed)
+    return Fail();
+  return true;
+}
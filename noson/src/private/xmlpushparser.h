@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef XMLPUSHPARSER_H
+#define XMLPUSHPARSER_H
+
+#include "local_config.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace NSROOT
+{
+
+  /**
+   * A non-validating XML tokenizer fed by chunks of data. Elements and
+   * character data are reported to the handler as soon as they are complete,
+   * so a document can be decoded while it is received, without building a
+   * tree. The entities are decoded in text and attribute values. Comments,
+   * processing instructions and declarations are skipped. The buffers are
+   * reused from one element to the next.
+   */
+  class XMLPushParser
+  {
+  public:
+    struct Attribute
+    {
+      std::string name;
+      std::string value;
+    };
+
+    class Handler
+    {
+    public:
+      virtual ~Handler() { }
+      /**
+       * @return false to stop parsing with error
+       */
+      virtual bool StartElement(const std::string& qname, const Attribute* attrs, unsigned count) = 0;
+      virtual bool EndElement(const std::string& qname) = 0;
+      /**
+       * The text of an element could be reported in several calls.
+       */
+      virtual bool CharData(const char* data, size_t len) = 0;
+    };
+
+    XMLPushParser(Handler& handler);
+    ~XMLPushParser() { }
+
+    /**
+     * Clear the state to parse a new document.
+     */
+    void Reset();
+
+    /**
+     * Parse the next chunk of the document.
+     * @param data
+     * @param len
+     * @return false on error, else true
+     */
+    bool Feed(const char* data, size_t len);
+
+    /**
+     * Terminate the parsing.
+     * @return true if a well-formed document has been parsed, else false
+     */
+    bool Finish();
+
+    bool HasError() const { return m_state == STATE_ERROR; }
+
+    /**
+     * Return the value of the named attribute.
+     * @return the pointer to the value, else null if not found
+     */
+    static const std::string* FindAttribute(const char* name, const Attribute* attrs, unsigned count);
+
+  private:
+    enum STATE
+    {
+      STATE_TEXT,
+      STATE_MARKUP,       // after '<'
+      STATE_START_NAME,
+      STATE_TAG,          // inside a start tag, before or between attributes
+      STATE_ATTR_NAME,
+      STATE_ATTR_EQ,
+      STATE_ATTR_QUOTE,
+      STATE_ATTR_VALUE,
+      STATE_EMPTY,        // after '/' in a start tag
+      STATE_END_NAME,
+      STATE_END_SPACE,
+      STATE_BANG,         // after "<!"
+      STATE_COMMENT,
+      STATE_CDATA,
+      STATE_DECL,
+      STATE_PI,
+      STATE_ERROR,
+    };
+
+    Handler& m_handler;
+    STATE m_state;
+    char m_quote;
+    unsigned m_marks;         // count of significant chars of a closing mark
+    bool m_inEntity;
+    bool m_rootClosed;
+    std::string m_text;
+    std::string m_entity;
+    std::string m_name;
+    std::string m_markup;
+    std::vector<Attribute> m_attrs;
+    unsigned m_attrCount;
+    std::vector<std::string> m_stack;
+    unsigned m_depth;
+
+    bool Fail();
+    bool FlushText();
+    const char* ParseEntity(const char* p, const char* end, std::string& out);
+    bool EmitStart(bool empty);
+    bool EmitEnd();
+    Attribute& NewAttribute();
+  };
+
+}
+
+#endif /* XMLPUSHPARSER_H */
@@ -103,6 +103,14 @@ bool PulseStreamer::HandleRequest(handle * handle)
   return false;
 }
 
+RequestBroker::RouteList PulseStreamer::GetRoutes()
+{
+  RouteList routes;
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Get), PULSESTREAMER_URI));
+  routes.push_back(Route(ws_method_to_str(WS_METHOD_Head), PULSESTREAMER_URI));
+  return routes;
+}
+
 RequestBroker::ResourcePtr PulseStreamer::GetResource(const std::string& title)
 {
   (void)title;
@@ -251,6 +259,8 @@ void PulseStreamer::streamSink(handle * handle)
       delete [] buf;
       if (r == 0)
         handle->broker->ReplyData("0" WS_CRLF WS_CRLF, 1 + WS_CRLF_LEN + WS_CRLF_LEN);
+      else
+        reply.Abort();
     }
 
     m_playbackCount.Sub(1);
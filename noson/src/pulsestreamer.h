@@ -37,6 +37,8 @@ public:
   virtual bool HandleRequest(handle * handle) override;
 
   const char * CommonName() override { return PULSESTREAMER_CNAME; }
+  bool IsStreaming() override { return true; }
+  RequestBroker::RouteList GetRoutes() override;
   RequestBroker::ResourcePtr GetResource(const std::string& title) override;
   RequestBroker::ResourceList GetResourceList() override;
   RequestBroker::ResourcePtr RegisterResource(const std::string& title,
@@ -67,12 +67,20 @@ RenderingControl::~RenderingControl()
   }
 }
 
-bool RenderingControl::GetVolume(uint8_t* value, const char* channel)
+ElementList RenderingControl::VariableArgs(const char* channel, const char* variable, int16_t value)
 {
   ElementList args;
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  ElementList vars = Request("GetVolume", args);
+  if (channel)
+    args.push_back(ElementPtr(new Element("Channel", channel)));
+  if (variable)
+    args.push_back(ElementPtr(new Element(std::string("Desired").append(variable), std::to_string(value))));
+  return args;
+}
+
+bool RenderingControl::GetVolume(uint8_t* value, const char* channel)
+{
+  ElementList vars = Request("GetVolume", VariableArgs(channel));
   if (!vars.empty() && vars[0]->compare("GetVolumeResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentVolume");
@@ -86,11 +94,7 @@ bool RenderingControl::SetVolume(uint8_t value, const char* channel)
 {
   if (m_property.Get()->OutputFixed)
     return false;
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  args.push_back(ElementPtr(new Element("DesiredVolume", std::to_string(value))));
-  ElementList vars = Request("SetVolume", args);
+  ElementList vars = Request("SetVolume", VariableArgs(channel, "Volume", value));
   if (!vars.empty() && vars[0]->compare("SetVolumeResponse") == 0)
     return true;
   return false;
@@ -98,10 +102,7 @@ bool RenderingControl::SetVolume(uint8_t value, const char* channel)
 
 bool RenderingControl::GetVolumeDecibel(int16_t *value, const char *channel)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  ElementList vars = Request("GetVolumeDB", args);
+  ElementList vars = Request("GetVolumeDB", VariableArgs(channel));
   if (!vars.empty() && vars[0]->compare("GetVolumeDBResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentVolume");
@@ -115,11 +116,7 @@ bool RenderingControl::SetVolumeDecibel(int16_t value, const char *channel)
 {
   if (m_property.Get()->OutputFixed)
     return false;
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  args.push_back(ElementPtr(new Element("DesiredVolume", std::to_string(value))));
-  ElementList vars = Request("SetVolumeDB", args);
+  ElementList vars = Request("SetVolumeDB", VariableArgs(channel, "Volume", value));
   if (!vars.empty() && vars[0]->compare("SetVolumeDBResponse") == 0)
     return true;
   return false;
@@ -127,10 +124,7 @@ bool RenderingControl::SetVolumeDecibel(int16_t value, const char *channel)
 
 bool RenderingControl::GetMute(uint8_t* value, const char* channel)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  ElementList vars = Request("GetMute", args);
+  ElementList vars = Request("GetMute", VariableArgs(channel));
   if (!vars.empty() && vars[0]->compare("GetMuteResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentMute");
@@ -142,11 +136,7 @@ bool RenderingControl::GetMute(uint8_t* value, const char* channel)
 
 bool RenderingControl::SetMute(uint8_t value, const char* channel)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  args.push_back(ElementPtr(new Element("DesiredMute", std::to_string(value))));
-  ElementList vars = Request("SetMute", args);
+  ElementList vars = Request("SetMute", VariableArgs(channel, "Mute", value));
   if (!vars.empty() && vars[0]->compare("SetMuteResponse") == 0)
     return true;
   return false;
@@ -206,9 +196,7 @@ bool RenderingControl::SetSubGain(int16_t value)
 
 bool RenderingControl::GetTreble(int8_t* value)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  ElementList vars = Request("GetTreble", args);
+  ElementList vars = Request("GetTreble", VariableArgs(nullptr));
   if (!vars.empty() && vars[0]->compare("GetTrebleResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentTreble");
@@ -220,10 +208,7 @@ bool RenderingControl::GetTreble(int8_t* value)
 
 bool RenderingControl::SetTreble(int8_t value)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("DesiredTreble", std::to_string(value))));
-  ElementList vars = Request("SetTreble", args);
+  ElementList vars = Request("SetTreble", VariableArgs(nullptr, "Treble", value));
   if (!vars.empty() && vars[0]->compare("SetTrebleResponse") == 0)
     return true;
   return false;
@@ -231,9 +216,7 @@ bool RenderingControl::SetTreble(int8_t value)
 
 bool RenderingControl::GetBass(int8_t* value)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  ElementList vars = Request("GetBass", args);
+  ElementList vars = Request("GetBass", VariableArgs(nullptr));
   if (!vars.empty() && vars[0]->compare("GetBassResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentBass");
@@ -246,10 +229,7 @@ bool RenderingControl::GetBass(int8_t* value)
 
 bool RenderingControl::SetBass(int8_t value)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("DesiredBass", std::to_string(value))));
-  ElementList vars = Request("SetBass", args);
+  ElementList vars = Request("SetBass", VariableArgs(nullptr, "Bass", value));
   if (!vars.empty() && vars[0]->compare("SetBassResponse") == 0)
     return true;
   return false;
@@ -296,10 +276,7 @@ bool RenderingControl::SetOutputFixed(uint8_t value)
 
 bool RenderingControl::GetLoudness(uint8_t* value, const char* channel)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  ElementList vars = Request("GetLoudness", args);
+  ElementList vars = Request("GetLoudness", VariableArgs(channel));
   if (!vars.empty() && vars[0]->compare("GetLoudnessResponse") == 0)
   {
     ElementList::const_iterator it = vars.FindKey("CurrentLoudness");
@@ -311,11 +288,7 @@ bool RenderingControl::GetLoudness(uint8_t* value, const char* channel)
 
 bool RenderingControl::SetLoudness(uint8_t value, const char* channel)
 {
-  ElementList args;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("Channel", channel)));
-  args.push_back(ElementPtr(new Element("DesiredLoudness", std::to_string(value))));
-  ElementList vars = Request("SetLoudness", args);
+  ElementList vars = Request("SetLoudness", VariableArgs(channel, "Loudness", value));
   if (!vars.empty() && vars[0]->compare("SetLoudnessResponse") == 0)
     return true;
   return false;
@@ -354,7 +327,7 @@ void RenderingControl::HandleEventMessage(EventMessagePtr msg)
     return;
   if (msg->event == EVENT_UPNP_PROPCHANGE)
   {
-    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "RCS")
+    if (m_subscription.GetSID() == msg->subject[0] && msg->kind == PROPCHANGE_RCS)
     {
       {
         // BEGIN CRITICAL SECTION
@@ -363,8 +336,7 @@ void RenderingControl::HandleEventMessage(EventMessagePtr msg)
         DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
 
         // check for higher sequence
-        uint32_t seq = 0;
-        string_to_uint32(msg->subject[1].c_str(), &seq);
+        uint32_t seq = msg->seq;
         if (msg->subject[0] != prop->EventSID)
         {
           prop->EventSID = msg->subject[0];
@@ -377,87 +349,75 @@ void RenderingControl::HandleEventMessage(EventMessagePtr msg)
         // tracking serial of the event
         prop->EventSEQ = seq;
 
-        std::vector<std::string>::const_iterator it = msg->subject.begin();
-        while (it != msg->subject.end())
+        for (const EventVariable& var : msg->vars)
         {
           int32_t num;
-          if (*it == "Volume/Master")
+          const std::string& val = msg->Value(var);
+          switch (var.key)
           {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+          case EVENT_VAR_Volume_Master:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeMaster = num;
-          }
-          else if (*it == "Volume/LF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Volume_LF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeLF = num;
-          }
-          else if (*it == "Volume/RF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Volume_RF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeRF = num;
-          }
-          else if (*it == "Mute/Master")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Mute_Master:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->MuteMaster = num;
-          }
-          else if (*it == "Mute/LF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Mute_LF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->MuteLF = num;
-          }
-          else if (*it == "Mute/RF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Mute_RF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->MuteRF = num;
-          }
-          else if (*it == "NightMode")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_NightMode:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->NightMode = num;
-          }
-          else if (*it == "SubGain")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_SubGain:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->SubGain = num;
-          }
-          else if (*it == "Bass")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Bass:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->Bass = num;
-          }
-          else if (*it == "Treble")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Treble:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->Treble = num;
-          }
-          else if (*it == "OutputFixed")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_OutputFixed:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->OutputFixed = num;
-          }
-          else if (*it == "Loudness/Master")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_Loudness_Master:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->LoudnessMaster = num;
-          }
-          else if (*it == "VolumeDB/Master")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_VolumeDB_Master:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeDecibelMaster = num;
-          }
-          else if (*it == "VolumeDB/LF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_VolumeDB_LF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeDecibelLF = num;
-          }
-          else if (*it == "VolumeDB/RF")
-          {
-            if (string_to_int32((*++it).c_str(), &num) == 0)
+            break;
+          case EVENT_VAR_VolumeDB_RF:
+            if (string_to_int32(val.c_str(), &num) == 0)
               prop->VolumeDecibelRF = num;
+            break;
+          default:
+            break;
           }
-
-          ++it;
         }
         // END CRITICAL SECTION
       }
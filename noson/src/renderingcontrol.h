@@ -55,6 +55,16 @@ namespace NSROOT
 
     const std::string& GetSCPDURL() const override { return SCPDURL; }
 
+    /**
+     * Build the arguments of the action on a rendering variable, i.e Volume,
+     * Mute, Loudness, Bass or Treble.
+     * @param channel the channel, or null when the variable has no channel
+     * @param variable the name of the variable to set, or null to get it
+     * @param value the value to set
+     * @return the arguments
+     */
+    static ElementList VariableArgs(const char* channel, const char* variable = nullptr, int16_t value = 0);
+
     bool GetVolume(uint8_t* value, const char* channel = CH_MASTER);
 
     bool SetVolume(uint8_t value, const char* channel = CH_MASTER);
@@ -42,6 +42,10 @@ RequestBroker::~RequestBroker()
 
 bool RequestBroker::Initialize() { return true; }
 
+bool RequestBroker::IsStreaming() { return false; }
+
+RequestBroker::RouteList RequestBroker::GetRoutes() { return RouteList(); }
+
 void RequestBroker::TraceResponseStatus(int status)
 {
   switch (ws_status_from_num(status))
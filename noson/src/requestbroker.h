@@ -58,6 +58,32 @@ namespace NSROOT
      */
     virtual bool Initialize();
 
+    /**
+     * @brief Tell whether the broker serves long-running requests, like an
+     * audio stream. Those requests are processed by dedicated workers, so they
+     * never hold back the short-lived ones. The default implementation return
+     * false.
+     * @return true if the broker is streaming, else false
+     */
+    virtual bool IsStreaming();
+
+    struct Route {
+      std::string method;       ///< Method of the request, or empty for any
+      std::string prefix;       ///< Prefix of the request path
+      Route(const std::string& _method, const std::string& _prefix)
+      : method(_method), prefix(_prefix) { }
+    };
+    typedef std::list<Route> RouteList;
+
+    /**
+     * @brief Return the routes of the requests the broker could handle, as
+     * pairs of method and path prefix. They are read on registration. The
+     * default implementation return no route, so the broker is tried for any
+     * request after the routed brokers.
+     * @return the list of routes
+     */
+    virtual RouteList GetRoutes();
+
     /**
      * @brief Handle an incoming request
      * @param handle the data to pass for callback
@@ -23,27 +23,119 @@
 #include "private/wsresponse.h"
 #include "private/debug.h"
 #include "private/cppdef.h"
-#include "private/tinyxml2.h"
 #include "private/xmldict.h"
 #include "private/os/threads/mutex.h"
+#include "private/os/threads/condition.h"
+#include "private/wsasyncclient.h"
+#include "private/requestcache.h"
+#include "private/soapenvelope.h"
+#include "private/soapresponseparser.h"
 #include "sonosplayer.h"
 
-#define NS_PREFIX               "urn:schemas-upnp-org:service:"
-#define NS_SUFFIX               ":1"
-#define SOAP_ENVELOPE_NAMESPACE "http://schemas.xmlsoap.org/soap/envelope/"
-#define SOAP_ENCODING_NAMESPACE "http://schemas.xmlsoap.org/soap/encoding/"
-
 using namespace NSROOT;
 
 namespace NSROOT
 {
-  void __traceServiceError(const tinyxml2::XMLDocument& doc)
+  struct ServiceRequest::Sync
   {
-    DBG(DBG_ERROR, "%s: invalid or not supported response\n", __FUNCTION__);
-    tinyxml2::XMLPrinter out;
-    doc.Accept(&out);
-    DBG(DBG_ERROR, "%s\n", out.CStr());
+    OS::Mutex mutex;
+    OS::Condition<volatile bool> condition;
+    volatile bool completed;
+    volatile bool canceled;
+    Sync() : completed(false), canceled(false) { }
+  };
+
+  class ServiceExchange : public WSAsyncClient::Exchange
+  {
+  public:
+    /**
+     * @param handle the handle of the request
+     * @param scope the cache scope to invalidate on completion, or empty
+     */
+    ServiceExchange(const ServiceRequestPtr& handle, const std::string& scope)
+    : m_handle(handle), m_scope(scope) { }
+    virtual void Completed(WSResponse * response)
+    {
+      ElementList vars;
+      if (response && !m_handle->IsCanceled())
+        Service::ReadResponse(*response, vars);
+      // the action could change the state, and the service could be gone
+      if (!m_scope.empty())
+        RequestCache::Instance().Invalidate(m_scope);
+      m_handle->Complete(vars);
+    }
+    virtual bool IsCanceled() const
+    {
+      return m_handle->IsCanceled();
+    }
+  private:
+    ServiceRequestPtr m_handle;
+    std::string m_scope;
+  };
+}
+
+ServiceRequest::ServiceRequest(void* CBHandle, RequestCB requestCB)
+: m_sync(new Sync())
+, m_CBHandle(CBHandle)
+, m_requestCB(requestCB)
+{
+}
+
+ServiceRequest::~ServiceRequest()
+{
+  SAFE_DELETE(m_sync);
+}
+
+bool ServiceRequest::IsCompleted() const
+{
+  OS::LockGuard lock(m_sync->mutex);
+  return m_sync->completed;
+}
+
+void ServiceRequest::Cancel()
+{
+  OS::LockGuard lock(m_sync->mutex);
+  m_sync->canceled = true;
+}
+
+bool ServiceRequest::IsCanceled() const
+{
+  OS::LockGuard lock(m_sync->mutex);
+  return m_sync->canceled;
+}
+
+bool ServiceRequest::Wait(unsigned timeout)
+{
+  OS::LockGuard lock(m_sync->mutex);
+  return m_sync->condition.wait_for(m_sync->mutex, timeout, m_sync->completed);
+}
+
+const ElementList& ServiceRequest::Wait()
+{
+  OS::LockGuard lock(m_sync->mutex);
+  m_sync->condition.wait(m_sync->mutex, m_sync->completed);
+  return m_vars;
+}
+
+const ElementList& ServiceRequest::GetResponse() const
+{
+  static ElementList nil;
+  OS::LockGuard lock(m_sync->mutex);
+  return (m_sync->completed ? m_vars : nil);
+}
+
+void ServiceRequest::Complete(ElementList& vars)
+{
+  {
+    OS::LockGuard lock(m_sync->mutex);
+    m_vars.swap(vars);
   }
+  // the callback comes first, so the waiters find it done
+  if (m_requestCB)
+    m_requestCB(m_CBHandle, m_vars);
+  OS::LockGuard lock(m_sync->mutex);
+  m_sync->completed = true;
+  m_sync->condition.notify_all();
 }
 
 Service::Service(const std::string& serviceHost, unsigned servicePort)
@@ -65,123 +157,112 @@ ElementList Service::GetLastFault()
   return m_fault;
 }
 
+void Service::MakeRequest(WSRequest& request, const std::string& action, const ElementList& args)
+{
+  const SOAPEnvelope& envelope = SOAPEnvelope::Get(GetName(), action);
+  std::string content;
+  envelope.Build(args, content);
+
+  request.RequestService(GetControlURL(), WS_METHOD_Post);
+  request.SetHeader("SOAPAction", envelope.GetSOAPAction());
+  request.SetContentCustom("text/xml", std::move(content));
+}
+
 ElementList Service::Request(const std::string& action, const ElementList& args)
 {
   ElementList vars;
+  WSRequest request(m_host, m_port);
+  MakeRequest(request, action, args);
+  WSResponse response(request);
+  if (!ReadResponse(response, vars))
+    SetFault(vars);
+  // the action could change the state
+  if (action.compare(0, 3, "Get") != 0)
+    InvalidateCache();
+  return vars;
+}
 
-  std::string soapaction;
-  soapaction.append("\"" NS_PREFIX).append(GetName()).append(NS_SUFFIX "#").append(action).append("\"");
-
-  std::string content;
-  content.append("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
-  // start envelope
-  content.append("<s:Envelope xmlns:s=\"" SOAP_ENVELOPE_NAMESPACE "\" s:encodingStyle=\"" SOAP_ENCODING_NAMESPACE "\">");
-  // start body
-  content.append("<s:Body>");
-  content.append("<u:").append(action).append(" xmlns:u=\"" NS_PREFIX).append(GetName()).append(NS_SUFFIX "\">");
+ElementList Service::RequestCached(const std::string& action, const ElementList& args)
+{
+  std::string key(action);
   for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
-    content.append((*it)->XML());
-  content.append("</u:").append(action).append(">");
-  // end body
-  content.append("</s:Body>");
-  // end envelope
-  content.append("</s:Envelope>");
+    key.append("|").append((*it)->GetKey()).append("=").append(**it);
+  const std::string scope = CacheScope();
+  ElementList vars;
+  if (RequestCache::Instance().Acquire(scope, key, vars))
+  {
+    if (!vars.empty() && vars[0]->compare("Fault") == 0)
+      SetFault(vars);
+    return vars;
+  }
+  vars = Request(action, args);
+  // keep only the successful response
+  bool ok = (!vars.empty() && vars[0]->compare(action + "Response") == 0);
+  RequestCache::Instance().Finish(scope, key, vars, ok ? REQUEST_CACHE_TTL : 0);
+  return vars;
+}
 
+void Service::InvalidateCache()
+{
+  RequestCache::Instance().Invalidate(CacheScope());
+}
+
+std::string Service::CacheScope() const
+{
+  return std::string(m_host).append(":").append(std::to_string(m_port)).append(GetControlURL());
+}
+
+ServiceRequestPtr Service::RequestAsync(const std::string& action, const ElementList& args, RequestCB requestCB, void* CBHandle)
+{
+  ServiceRequestPtr handle(new ServiceRequest(CBHandle, requestCB));
   WSRequest request(m_host, m_port);
-  request.RequestService(GetControlURL(), WS_METHOD_Post);
-  request.SetHeader("SOAPAction", soapaction);
-  request.SetContentCustom("text/xml", content.c_str());
-  WSResponse response(request);
+  MakeRequest(request, action, args);
+  // as Request(), drop the cached responses once a Set* is completed
+  std::string scope;
+  if (action.compare(0, 3, "Get") != 0)
+    scope = CacheScope();
+  if (!WSAsyncClient::Instance().Submit(request, WSAsyncClient::ExchangePtr(new ServiceExchange(handle, scope))))
+  {
+    DBG(DBG_ERROR, "%s: request cannot be sent\n", __FUNCTION__);
+    ElementList vars;
+    handle->Complete(vars);
+  }
+  return handle;
+}
 
+bool Service::ReadResponse(WSResponse& response, ElementList& vars)
+{
   if (!response.IsSuccessful())
   {
     DBG(DBG_ERROR, "%s: invalid response\n", __FUNCTION__);
-    return vars;
+    return true;
   }
 
-  // Receive content data
-  size_t len = 0, l = 0;
-  std::string data;
+  // Decode content data while receiving
+  SOAPResponseParser parser(vars);
+  size_t l = 0;
   char buffer[4096];
+  bool ok = true;
   while ((l = response.ReadContent(buffer, sizeof(buffer))))
   {
-    data.append(buffer, l);
-    len += l;
+    if (ok && !parser.Feed(buffer, l))
+      ok = false;
   }
-
-  // Parse xml content
-  tinyxml2::XMLDocument rootdoc;
-  if (rootdoc.Parse(data.c_str(), len) != tinyxml2::XML_SUCCESS)
+  if (ok)
+    ok = parser.Finish();
+  if (!ok)
   {
     DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
-    return vars;
+    vars.clear();
+    return true;
   }
-  const tinyxml2::XMLElement* elem; // an element
   // Check for response: Envelope/Body/{respTag}
-  if (!(elem = rootdoc.RootElement()) || !XMLNS::NameEqual(elem->Name(), "Envelope"))
-  {
-    __traceServiceError(rootdoc);
-    SetFault(vars);
-    return vars;
-  }
-
-  // search the element 'Body'
-  elem = elem->FirstChildElement();
-  while (elem && !XMLNS::NameEqual(elem->Name(), "Body"))
-    elem = elem->NextSiblingElement(nullptr);
-
-  if (!elem || !(elem = elem->FirstChildElement()))
-  {
-    __traceServiceError(rootdoc);
-    SetFault(vars);
-    return vars;
-  }
-  vars.push_back(ElementPtr(new Element("TAG", XMLNS::LocalName(elem->Name()))));
-  if (vars.back()->compare("Fault") == 0)
+  if (!parser.IsSOAP())
   {
-    const tinyxml2::XMLElement* felem = elem->FirstChildElement(nullptr);
-    while (felem)
-    {
-      if (XMLNS::NameEqual(felem->Name(), "faultcode") && felem->GetText())
-        vars.push_back(ElementPtr(new Element("faultcode", felem->GetText())));
-      else if (XMLNS::NameEqual(felem->Name(), "faultstring") && felem->GetText())
-        vars.push_back(ElementPtr(new Element("faultstring", felem->GetText())));
-      else if (XMLNS::NameEqual(felem->Name(), "detail"))
-      {
-        const tinyxml2::XMLElement* delem = felem->FirstChildElement(nullptr);
-        if (delem && (delem = delem->FirstChildElement(nullptr)))
-        {
-          do
-          {
-            if (delem->GetText())
-            {
-              // remove the namespace qualifier to handle local name as key
-              vars.push_back(ElementPtr(new Element(XMLNS::LocalName(delem->Name()), delem->GetText())));
-              DBG(DBG_PROTO, "%s: [fault] %s = %s\n", __FUNCTION__, vars.back()->GetKey().c_str(), vars.back()->c_str());
-            }
-            delem = delem->NextSiblingElement(nullptr);
-          } while (delem);
-        }
-      }
-      felem = felem->NextSiblingElement(nullptr);
-    }
-    SetFault(vars);
-  }
-  else
-  {
-    elem = elem->FirstChildElement(nullptr);
-    while (elem)
-    {
-      if (elem->GetText())
-      {
-        // remove the namespace qualifier to handle local name as key
-        vars.push_back(ElementPtr(new Element(XMLNS::LocalName(elem->Name()), elem->GetText())));
-        DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, vars.back()->GetKey().c_str(), vars.back()->c_str());
-      }
-      elem = elem->NextSiblingElement(nullptr);
-    }
+    DBG(DBG_ERROR, "%s: invalid or not supported response\n", __FUNCTION__);
+    return false;
   }
-  return vars;
+  return !parser.IsFault();
 }
 
 void Service::SetFault(const ElementList& vars)
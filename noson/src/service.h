@@ -34,8 +34,73 @@ namespace NSROOT
     class Mutex;
   }
 
+  class WSRequest;
+  class WSResponse;
+
+  /**
+   * The callback of an asynchronous request. It is called from a worker
+   * thread with the response of the action: see Service::RequestAsync().
+   */
+  typedef void (*RequestCB)(void* handle, const ElementList& vars);
+
+  class ServiceRequest;
+
+  typedef SHARED_PTR<ServiceRequest> ServiceRequestPtr;
+
+  /**
+   * The handle of an asynchronous request.
+   */
+  class ServiceRequest
+  {
+  public:
+    ServiceRequest(void* CBHandle, RequestCB requestCB);
+    ~ServiceRequest();
+    ServiceRequest(const ServiceRequest&) = delete;
+    ServiceRequest& operator=(const ServiceRequest&) = delete;
+
+    bool IsCompleted() const;
+
+    /**
+     * Give up the request: it is completed with an empty response, and it
+     * isn't sent if still queued.
+     */
+    void Cancel();
+
+    bool IsCanceled() const;
+
+    /**
+     * Wait for the completion until the timeout expires.
+     * @param timeout in millisec
+     * @return true if completed, else false
+     */
+    bool Wait(unsigned timeout);
+
+    /**
+     * Wait for the completion.
+     * @return the response
+     */
+    const ElementList& Wait();
+
+    /**
+     * @return the response once completed, else an empty list
+     */
+    const ElementList& GetResponse() const;
+
+  private:
+    friend class ServiceExchange;
+    friend class Service;
+    struct Sync;
+    Sync* m_sync;
+    ElementList m_vars;
+    void* m_CBHandle;
+    RequestCB m_requestCB;
+
+    void Complete(ElementList& vars);
+  };
+
   class Service
   {
+    friend class ServiceExchange;
   public:
     Service(const std::string& serviceHost, unsigned servicePort);
     virtual ~Service();
@@ -56,17 +121,55 @@ namespace NSROOT
 
     ElementList GetLastFault();
 
+    /**
+     * Send the action without blocking the caller. The response is the list
+     * returned by a blocking request: the first element is tagged with the
+     * name of the response, or "Fault" on failure, else the list is empty.
+     * A fault isn't recorded as the last fault of the service.
+     * @param action the name of the action
+     * @param args the arguments of the action
+     * @param requestCB the callback to call on completion, or null
+     * @param CBHandle the handle to pass to the callback
+     * @return the handle of the request
+     */
+    ServiceRequestPtr RequestAsync(const std::string& action, const ElementList& args, RequestCB requestCB = nullptr, void* CBHandle = nullptr);
+
   protected:
     std::string m_host;
     unsigned m_port;
 
+    /**
+     * Send the action and wait for the response. Unless the action is a Get*,
+     * the cached responses of the service are dropped.
+     */
     ElementList Request(const std::string& action, const ElementList& args);
 
+    /**
+     * Send the read-only action, or share the response of the same request
+     * recently issued, or in flight, on this service of the device.
+     */
+    ElementList RequestCached(const std::string& action, const ElementList& args);
+
+    /**
+     * Drop the cached responses of this service of the device, i.e on event
+     * of change.
+     */
+    void InvalidateCache();
+
+    void MakeRequest(WSRequest& request, const std::string& action, const ElementList& args);
+
+    /**
+     * Read the response of an action into the list.
+     * @return false when the response is a fault to record, else true
+     */
+    static bool ReadResponse(WSResponse& response, ElementList& vars);
+
   private:
     OS::Mutex* m_mutex;
     ElementList m_fault;
 
     void SetFault(const ElementList& vars);
+    std::string CacheScope() const;
   };
 }
 
@@ -23,6 +23,7 @@
 #include "private/os/threads/mutex.h"
 #include "private/os/threads/timeout.h"
 #include "private/tinyxml2.h"
+#include "private/soapresponseparser.h"
 #include "private/xmldict.h"
 #include "private/wsresponse.h"
 #include "private/builtin.h"
@@ -482,103 +483,36 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
   // don't check response status code
   // service will return 500 on soap fault
 
-  // Receive content data
-  size_t len = 0, l = 0;
-  std::string data;
+  // Decode content data while receiving
+  // Some services supply malformed xml with undefined namespace and so translating qualified name will fail,
+  // so the local name is the key
+  SOAPResponseParser parser(vars, true);
+  size_t l = 0;
   char buffer[4096];
+  bool ok = true;
   while ((l = response.ReadContent(buffer, sizeof(buffer))))
   {
-    data.append(buffer, l);
-    len += l;
+    if (ok && !parser.Feed(buffer, l))
+      ok = false;
   }
-
-  // Parse xml content
-  tinyxml2::XMLDocument rootdoc;
-  if (rootdoc.Parse(data.c_str(), len) != tinyxml2::XML_SUCCESS)
+  if (ok)
+    ok = parser.Finish();
+  if (!ok)
   {
     DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
+    vars.clear();
     SetFault(vars);
     return vars;
   }
-  const tinyxml2::XMLElement* elem; // an element
   // Check for response: Envelope/Body/{respTag}
-
-  if (!(elem = rootdoc.RootElement()) || !XMLNS::NameEqual(elem->Name(), "Envelope"))
+  if (!parser.IsSOAP())
   {
-    __traceSMAPIError(rootdoc);
-    SetFault(vars);
-    return vars;
-  }
-  // learn declared namespaces in the element Envelope for translations
-  XMLNames xmlnames;
-  xmlnames.AddXMLNS(elem);
-
-  // search the element 'Body'
-  elem = elem->FirstChildElement();
-  while (elem && !XMLNS::NameEqual(elem->Name(), "Body"))
-    elem = elem->NextSiblingElement(NULL);
-
-  if (!elem || !(elem = elem->FirstChildElement()))
-  {
-    __traceSMAPIError(rootdoc);
+    DBG(DBG_ERROR, "%s: invalid or not supported response\n", __FUNCTION__);
     SetFault(vars);
     return vars;
   }
-  vars.push_back(ElementPtr(new Element("TAG", XMLNS::LocalName(elem->Name()))));
-  if (vars.back()->compare("Fault") == 0)
-  {
-    const tinyxml2::XMLElement* felem = elem->FirstChildElement(NULL);
-    while (felem)
-    {
-      if (XMLNS::NameEqual(felem->Name(), "faultcode") && felem->GetText())
-        vars.push_back(ElementPtr(new Element("faultcode", felem->GetText())));
-      else if (XMLNS::NameEqual(felem->Name(), "faultstring") && felem->GetText())
-        vars.push_back(ElementPtr(new Element("faultstring", felem->GetText())));
-      else if (XMLNS::NameEqual(felem->Name(), "detail"))
-      {
-        const tinyxml2::XMLElement* delem = felem->FirstChildElement(NULL);
-        if (delem && (delem = delem->FirstChildElement(NULL)))
-        {
-          do
-          {
-            if (delem->GetText())
-            {
-              // remove the namespace qualifier to handle local name as key
-              vars.push_back(ElementPtr(new Element(XMLNS::LocalName(delem->Name()), delem->GetText())));
-              DBG(DBG_PROTO, "%s: [fault] %s = %s\n", __FUNCTION__, vars.back()->GetKey().c_str(), vars.back()->c_str());
-            }
-            delem = delem->NextSiblingElement(NULL);
-          } while (delem);
-        }
-      }
-      felem = felem->NextSiblingElement(NULL);
-    }
+  if (parser.IsFault())
     SetFault(vars);
-  }
-  else
-  {
-    elem = elem->FirstChildElement(NULL);
-    while (elem)
-    {
-      if (elem->GetText())
-      {
-        // Some services supply malformed xml with undefined namespace and so translating qualified name will fail.
-        //vars.push_back(ElementPtr(new Element(SMAPIDict.TranslateQName(xmlnames, elem->Name()), elem->GetText())));
-        vars.push_back(ElementPtr(new Element(XMLNS::LocalName(elem->Name()), elem->GetText())));
-        DBG(DBG_PROTO, "%s: %s = %s\n", __FUNCTION__, vars.back()->GetKey().c_str(), vars.back()->c_str());
-      }
-      else if (!elem->NoChildren())
-      {
-        tinyxml2::XMLPrinter out;
-        elem->Accept(&out);
-        // Some services supply malformed xml with undefined namespace and so translating qualified name will fail.
-        //vars.push_back(ElementPtr(new Element(SMAPIDict.TranslateQName(xmlnames, elem->Name()), out.CStr())));
-        vars.push_back(ElementPtr(new Element(XMLNS::LocalName(elem->Name()), out.CStr())));
-        DBG(DBG_PROTO, "%s: dump (%s)\n%s\n", __FUNCTION__, vars.back()->GetKey().c_str(), vars.back()->c_str());
-      }
-      elem = elem->NextSiblingElement(NULL);
-    }
-  }
   return vars;
 }
 
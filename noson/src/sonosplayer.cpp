@@ -28,6 +28,8 @@
 #include "private/debug.h"
 #include "private/uriparser.h"
 #include "private/socket.h"
+#include "private/commandcoalescer.h"
+#include "private/os/threads/timeout.h"
 #include "didlparser.h"
 #include "sonossystem.h"
 #include "filestreamer.h"
@@ -54,6 +56,7 @@ Player::Player(const ZonePtr& zone, System* system, void* CBHandle, EventCB even
 , m_deviceProperties(nullptr)
 , m_AVTransport(nullptr)
 , m_contentDirectory(nullptr)
+, m_commands(new CommandCoalescer())
 , m_subscriptionPool()
 {
   m_valid = Init(system);
@@ -73,6 +76,7 @@ Player::Player(const ZonePlayerPtr& zonePlayer)
 , m_deviceProperties(nullptr)
 , m_AVTransport(nullptr)
 , m_contentDirectory(nullptr)
+, m_commands(new CommandCoalescer())
 , m_subscriptionPool()
 {
   if (zonePlayer && zonePlayer->IsValid())
@@ -100,6 +104,8 @@ Player::Player(const ZonePlayerPtr& zonePlayer)
 
 Player::~Player()
 {
+  // the commands held refer to the services
+  SAFE_DELETE(m_commands);
   SAFE_DELETE(m_contentDirectory);
   SAFE_DELETE(m_AVTransport);
   SAFE_DELETE(m_deviceProperties);
@@ -494,6 +500,186 @@ bool Player::SetOutputFixed(const std::string &uuid, uint8_t value)
   return false;
 }
 
+bool Player::GetGroupVolume(GroupValues& values)
+{
+  return GetGroupVariable("Volume", RenderingControl::CH_MASTER, values);
+}
+
+bool Player::SetGroupVolume(uint8_t value)
+{
+  return SetGroupVariable("Volume", RenderingControl::CH_MASTER, value, false);
+}
+
+bool Player::GetGroupMute(GroupValues& values)
+{
+  return GetGroupVariable("Mute", RenderingControl::CH_MASTER, values);
+}
+
+bool Player::SetGroupMute(uint8_t value)
+{
+  return SetGroupVariable("Mute", RenderingControl::CH_MASTER, value);
+}
+
+bool Player::GetGroupLoudness(GroupValues& values)
+{
+  return GetGroupVariable("Loudness", RenderingControl::CH_MASTER, values);
+}
+
+bool Player::SetGroupLoudness(uint8_t value)
+{
+  return SetGroupVariable("Loudness", RenderingControl::CH_MASTER, value);
+}
+
+bool Player::GetGroupBass(GroupValues& values)
+{
+  return GetGroupVariable("Bass", nullptr, values);
+}
+
+bool Player::SetGroupBass(int8_t value)
+{
+  return SetGroupVariable("Bass", nullptr, value);
+}
+
+bool Player::GetGroupTreble(GroupValues& values)
+{
+  return GetGroupVariable("Treble", nullptr, values);
+}
+
+bool Player::SetGroupTreble(int8_t value)
+{
+  return SetGroupVariable("Treble", nullptr, value);
+}
+
+namespace
+{
+  /**
+   * Wait for the response of a member until the deadline of the group call.
+   * A member which doesn't answer in time is given up, and it fails.
+   */
+  const ElementList& waitGroupRequest(const ServiceRequestPtr& request, const OS::Timeout& timeout)
+  {
+    static const ElementList nil;
+    if (request->Wait(timeout.time_left()))
+      return request->GetResponse();
+    request->Cancel();
+    return nil;
+  }
+}
+
+bool Player::GetGroupVariable(const char* name, const char* channel, GroupValues& values)
+{
+  std::string action("Get");
+  action.append(name);
+  std::vector<std::pair<const SubordinateRC*, ServiceRequestPtr> > calls;
+  const ElementList args = RenderingControl::VariableArgs(channel);
+  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+    calls.push_back(std::make_pair(&(*it), it->renderingControl->RequestAsync(action, args)));
+  const std::string response(action + "Response");
+  const std::string current(std::string("Current").append(name));
+  bool ret = !calls.empty();
+  OS::Timeout timeout(PLAYER_GROUP_TIMEOUT);
+  for (std::vector<std::pair<const SubordinateRC*, ServiceRequestPtr> >::const_iterator ic = calls.begin(); ic != calls.end(); ++ic)
+  {
+    const ElementList& vars = waitGroupRequest(ic->second, timeout);
+    if (!vars.empty() && vars[0]->compare(response) == 0)
+    {
+      ElementList::const_iterator it = vars.FindKey(current);
+      int16_t value;
+      if (it != vars.end() && string_to_int16((*it)->c_str(), &value) == 0)
+      {
+        values[ic->first->uuid] = value;
+        continue;
+      }
+    }
+    DBG(DBG_WARN, "%s: %s failed for '%s'\n", __FUNCTION__, action.c_str(), ic->first->name.c_str());
+    ret = false;
+  }
+  return ret;
+}
+
+bool Player::SetGroupVariable(const char* name, const char* channel, int16_t value, bool fixedOutput)
+{
+  std::string action("Set");
+  action.append(name);
+  std::vector<std::pair<const SubordinateRC*, ServiceRequestPtr> > calls;
+  const ElementList args = RenderingControl::VariableArgs(channel, name, value);
+  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  {
+    if (!fixedOutput && it->renderingControl->GetRenderingProperty().Get()->OutputFixed)
+      continue;
+    calls.push_back(std::make_pair(&(*it), it->renderingControl->RequestAsync(action, args)));
+  }
+  const std::string response(action + "Response");
+  bool ret = !m_RCTable.empty();
+  OS::Timeout timeout(PLAYER_GROUP_TIMEOUT);
+  for (std::vector<std::pair<const SubordinateRC*, ServiceRequestPtr> >::const_iterator ic = calls.begin(); ic != calls.end(); ++ic)
+  {
+    const ElementList& vars = waitGroupRequest(ic->second, timeout);
+    if (vars.empty() || vars[0]->compare(response) != 0)
+    {
+      DBG(DBG_WARN, "%s: %s failed for '%s'\n", __FUNCTION__, action.c_str(), ic->first->name.c_str());
+      ret = false;
+    }
+  }
+  return ret;
+}
+
+bool Player::PostVolume(const std::string& uuid, uint8_t value)
+{
+  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  {
+    if (it->uuid == uuid)
+    {
+      if (it->renderingControl->GetRenderingProperty().Get()->OutputFixed)
+        return false;
+      m_commands->Submit(uuid + ":Volume", it->renderingControl, "SetVolume",
+                         RenderingControl::VariableArgs(RenderingControl::CH_MASTER, "Volume", value));
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Player::PostVolumeDecibel(const std::string& uuid, int16_t value)
+{
+  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  {
+    if (it->uuid == uuid)
+    {
+      if (it->renderingControl->GetRenderingProperty().Get()->OutputFixed)
+        return false;
+      // both set the volume
+      m_commands->Submit(uuid + ":Volume", it->renderingControl, "SetVolumeDB",
+                         RenderingControl::VariableArgs(RenderingControl::CH_MASTER, "Volume", value));
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Player::PostSeekTime(uint16_t reltime)
+{
+  char buf[9];
+  memset(buf, 0, sizeof (buf));
+  snprintf(buf, sizeof(buf), "%.2u:%.2u:%.2u", (unsigned)(reltime / 3600),
+          (unsigned)((reltime % 3600) / 60), (unsigned)(reltime % 60));
+  ElementList args;
+  args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  args.push_back(ElementPtr(new Element("Unit", "REL_TIME")));
+  args.push_back(ElementPtr(new Element("Target", buf)));
+  m_commands->Submit(m_uuid + ":Seek", m_AVTransport, "Seek", args);
+  return true;
+}
+
+CommandStats Player::GetCommandStats()
+{
+  CommandStats stats;
+  stats.sent = m_commands->GetSentCount();
+  stats.dropped = m_commands->GetDroppedCount();
+  stats.failed = m_commands->GetFailedCount();
+  return stats;
+}
+
 bool Player::SetCurrentURI(const DigitalItemPtr& item)
 {
   if (!item)
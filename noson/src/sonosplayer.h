@@ -34,6 +34,8 @@
 #include <vector>
 #include <map>
 
+#define PLAYER_GROUP_TIMEOUT  10000 // Max wait for the members of a group call in millisec
+
 namespace NSROOT
 {
   class AVTransport;
@@ -41,12 +43,29 @@ namespace NSROOT
   class RenderingControl;
   class ContentDirectory;
   class System;
+  class CommandCoalescer;
 
   class Player;
 
   typedef SHARED_PTR<Player> PlayerPtr;
   typedef std::vector<SRProperty> SRPList;
 
+  /**
+   * The values of a rendering variable for the members of a group, indexed
+   * by the member UUID.
+   */
+  typedef std::map<std::string, int16_t> GroupValues;
+
+  /**
+   * The counters of the commands posted to a player.
+   */
+  struct CommandStats
+  {
+    unsigned sent;      // commands completed successfully
+    unsigned dropped;   // commands replaced by a newer one before sending
+    unsigned failed;    // commands completed with a failure
+  };
+
   class Player
   {
   public:
@@ -117,6 +136,35 @@ namespace NSROOT
     bool GetOutputFixed(const std::string& uuid, uint8_t* value);
     bool SetOutputFixed(const std::string& uuid, uint8_t value);
 
+    /**
+     * Group wide rendering: the calls to all members are sent at once, so the
+     * group is controlled in about one round trip.
+     * The result is true when the call succeeded for all the members. A member
+     * which doesn't answer within PLAYER_GROUP_TIMEOUT fails. The volume of a
+     * member with a fixed output is left unchanged.
+     */
+    bool GetGroupVolume(GroupValues& values);
+    bool SetGroupVolume(uint8_t value);
+    bool GetGroupMute(GroupValues& values);
+    bool SetGroupMute(uint8_t value);
+    bool GetGroupLoudness(GroupValues& values);
+    bool SetGroupLoudness(uint8_t value);
+    bool GetGroupBass(GroupValues& values);
+    bool SetGroupBass(int8_t value);
+    bool GetGroupTreble(GroupValues& values);
+    bool SetGroupTreble(int8_t value);
+
+    /**
+     * Post a command without waiting for the completion. While a command of
+     * the same kind is in flight, a newer value replaces the one held, and
+     * only the latest is sent: it fits the rapid-fire controls like a slider.
+     * @return false if the command cannot be posted
+     */
+    bool PostVolume(const std::string& uuid, uint8_t value);
+    bool PostVolumeDecibel(const std::string& uuid, int16_t value);
+    bool PostSeekTime(uint16_t reltime);
+    CommandStats GetCommandStats();
+
     bool SetCurrentURI(const DigitalItemPtr& item);
     bool PlayPulse();
     bool IsPulseStream(const std::string& streamURL);
@@ -188,6 +236,7 @@ namespace NSROOT
     DeviceProperties*   m_deviceProperties;
     AVTransport*        m_AVTransport;
     ContentDirectory*   m_contentDirectory;
+    CommandCoalescer*   m_commands;
 
     // The name and address of this controller
     std::string m_controllerLocalUri;
@@ -213,6 +262,10 @@ namespace NSROOT
     // cold startup
     bool Init(System* system);
 
+    // fan out the action on the rendering variable to all members
+    bool GetGroupVariable(const char* name, const char* channel, GroupValues& values);
+    bool SetGroupVariable(const char* name, const char* channel, int16_t value, bool fixedOutput = true);
+
     // event callback
     static void CB_AVTransport(void* handle);
     static void CB_RenderingControl(void* handle);
@@ -225,6 +225,14 @@ ZonePlayerList System::GetZonePlayerList() const
   return ZonePlayerList();
 }
 
+ZoneListChanges System::GetZoneListChanges() const
+{
+  OS::LockGuard lock(*m_mutex);
+  if (m_groupTopology)
+    return m_groupTopology->GetLastChanges();
+  return ZoneListChanges();
+}
+
 PlayerPtr System::GetPlayer(const ZonePtr& zone, void* CBHandle, EventCB eventCB)
 {
   DBG(DBG_DEBUG, "%s: %s\n", __FUNCTION__, zone->GetZoneName().c_str());
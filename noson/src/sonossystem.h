@@ -58,6 +58,14 @@ namespace NSROOT
 
     bool IsListening() { return m_eventHandler.IsRunning(); }
 
+    /**
+     * Enable the coalescing of the bursts of RCS and AVT updates, which is
+     * disabled by default. A subscriber behind the events then gets the last
+     * value of each variable in one update.
+     * @param millisec the window in milliseconds, or 0 to disable
+     */
+    void SetEventCoalescing(unsigned millisec = EVENTHANDLER_COALESCING_WINDOW) { m_eventHandler.SetCoalescingWindow(millisec); }
+
     bool Discover();
     bool Discover(const std::string& url);
     const std::string& GetHost() const { return m_deviceHost; }
@@ -71,6 +79,12 @@ namespace NSROOT
 
     ZonePlayerList GetZonePlayerList() const;
 
+    /**
+     * Return the groups changed by the last update of the topology. The zones
+     * which are not listed are the same objects as before.
+     */
+    ZoneListChanges GetZoneListChanges() const;
+
     PlayerPtr GetPlayer(const ZonePtr& zone, void* CBHandle = 0, EventCB eventCB = 0);
 
     PlayerPtr GetPlayer(const ZonePlayerPtr& zonePlayer, void* CBHandle = 0, EventCB eventCB = 0);
@@ -100,6 +100,18 @@ namespace NSROOT
       return first->compare(*last) < 0 ? true : false;
     }
   };
+
+  /**
+   * The groups changed by an update of the zone list
+   */
+  struct ZoneListChanges
+  {
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> modified;  // the members or their properties changed
+
+    bool empty() const { return added.empty() && removed.empty() && modified.empty(); }
+  };
 }
 
 #endif	/* SONOSZONE_H */
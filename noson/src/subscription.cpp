@@ -1,5 +1,5 @@
 /*
- *      Copyright (C) 2014-2018 Jean-Luc Barriere
+ *      Copyright (C) 2014-2026 Jean-Luc Barriere
  *
  *  This file is part of Noson
  *
@@ -20,8 +20,9 @@
 
 #include "subscription.h"
 #include "private/cppdef.h"
-#include "private/os/threads/thread.h"
-#include "private/os/threads/event.h"
+#include "private/os/threads/mutex.h"
+#include "private/os/threads/timeout.h"
+#include "private/renewalscheduler.h"
 #include "private/wsresponse.h"
 #include "private/uriparser.h"
 #include "private/socket.h"
@@ -45,12 +46,15 @@ Subscription::SubscriptionThread::~SubscriptionThread()
 namespace NSROOT
 {
 
-  class SubscriptionThreadImpl : public Subscription::SubscriptionThread, private OS::Thread
+  /**
+   * The subscription is renewed by the shared renewal scheduler, so it owns
+   * no thread.
+   */
+  class SubscriptionTaskImpl : public Subscription::SubscriptionThread, private RenewalScheduler::Task
   {
   public:
-    SubscriptionThreadImpl(const std::string& host, unsigned port, const std::string& url, unsigned bindingPort, unsigned ttl)
-    : OS::Thread()
-    , m_SID()
+    SubscriptionTaskImpl(const std::string& host, unsigned port, const std::string& url, unsigned bindingPort, unsigned ttl)
+    : m_SID()
     , m_host(host)
     , m_port(port)
     , m_url(url)
@@ -58,16 +62,23 @@ namespace NSROOT
     , m_ttl(SUBSCRIPTION_TIMEOUT_MAX)
     , m_configured(false)
     , m_renewable(false)
+    , m_running(false)
+    , m_success(false)
+    , m_retry(TIMEOUT_FIRST_RETRY)
     {
       m_ttl = (ttl < SUBSCRIPTION_TIMEOUT_MIN ? SUBSCRIPTION_TIMEOUT_MIN :
               (ttl > SUBSCRIPTION_TIMEOUT_MAX ? SUBSCRIPTION_TIMEOUT_MAX : ttl));
       // Try to configure
       Configure();
+      m_scheduler = RenewalScheduler::Acquire();
+      m_taskId = m_scheduler->Register(this, m_host);
     }
 
-    virtual ~SubscriptionThreadImpl()
+    virtual ~SubscriptionTaskImpl()
     {
       Stop();
+      m_scheduler->Unregister(m_taskId);
+      RenewalScheduler::Release();
     }
 
     virtual bool IsValid()
@@ -77,24 +88,46 @@ namespace NSROOT
 
     virtual bool Start()
     {
-      return OS::Thread::start_thread();
+      {
+        OS::LockGuard lock(m_mutex);
+        if (m_running)
+          return true;
+        m_running = true;
+        m_retry = TIMEOUT_FIRST_RETRY;
+      }
+      m_scheduler->Schedule(m_taskId, 0);
+      return true;
     }
 
     virtual void Stop()
     {
-      OS::Thread::stop_thread(false);
-      m_event.notify_one();
-      OS::Thread::stop_thread(true);
+      {
+        OS::LockGuard lock(m_mutex);
+        if (!m_running)
+          return;
+        m_running = false;
+      }
+      // wait for the running renewal
+      m_scheduler->Cancel(m_taskId);
+      if (m_success)
+        UnSubscribeForEvent();
+      m_success = false;
     }
 
-    virtual bool IsRunning() { return OS::Thread::is_running(); }
+    virtual bool IsRunning()
+    {
+      OS::LockGuard lock(m_mutex);
+      return m_running;
+    }
 
     virtual void AskRenewal()
     {
-      if (IsRunning())
+      OS::LockGuard lock(m_mutex);
+      if (m_running)
       {
         m_timeout.clear();
-        m_event.notify_one();
+        // spread the renewals asked at once
+        m_scheduler->Schedule(m_taskId, SUBSCRIPTION_RENEW_SPREAD, SUBSCRIPTION_RENEW_SPREAD);
       }
     }
 
@@ -117,42 +150,44 @@ namespace NSROOT
     unsigned m_ttl;
     bool m_configured;
     bool m_renewable;
+    bool m_running;
+    bool m_success;
+    unsigned m_retry;
     std::string m_myIP;
     OS::Timeout m_timeout;
-    OS::Event m_event;
+    OS::Mutex m_mutex;
+    RenewalScheduler * m_scheduler;
+    unsigned m_taskId;
 
-    virtual void* process();
+    virtual void Run();
     bool Configure();
     bool SubscribeForEvent(bool renew = false);
     bool UnSubscribeForEvent();
   };
 }
 
-void* SubscriptionThreadImpl::process()
+void SubscriptionTaskImpl::Run()
 {
-  bool success = false;
-  unsigned retry = TIMEOUT_FIRST_RETRY;
-  while (!is_stopped())
+  unsigned delay, jitter = 0;
+  // Reconfigure: IP may be leased for a time
+  if (Configure() && (m_success = SubscribeForEvent(m_success)))
   {
-    // Reconfigure: IP may be leased for a time
-    if (Configure() && (success = SubscribeForEvent(success)))
-    {
-      m_event.wait_for(m_timeout.time_left() * SUBSCRIPTION_RENEW_PCT / 100);
-      retry = TIMEOUT_FIRST_RETRY;
-    }
-    else
-    {
-      // wait before retry
-      m_event.wait_for(retry);
-      retry = TIMEOUT_AGAIN_RETRY;
-    }
+    delay = m_ttl * 10 * SUBSCRIPTION_RENEW_PCT;
+    jitter = m_ttl * 10 * SUBSCRIPTION_RENEW_JITTER_PCT;
+    m_retry = TIMEOUT_FIRST_RETRY;
+  }
+  else
+  {
+    // wait before retry
+    delay = m_retry;
+    m_retry = TIMEOUT_AGAIN_RETRY;
   }
-  if (success)
-    UnSubscribeForEvent();
-  return NULL;
+  OS::LockGuard lock(m_mutex);
+  if (m_running)
+    m_scheduler->Schedule(m_taskId, delay, jitter);
 }
 
-bool SubscriptionThreadImpl::Configure()
+bool SubscriptionTaskImpl::Configure()
 {
   TcpSocket sock;
   sock.Connect(m_host.c_str(), m_port, 0);
@@ -171,7 +206,7 @@ bool SubscriptionThreadImpl::Configure()
   return m_configured = false;
 }
 
-bool SubscriptionThreadImpl::SubscribeForEvent(bool renew)
+bool SubscriptionTaskImpl::SubscribeForEvent(bool renew)
 {
   WSRequest request(m_host, m_port);
   request.RequestService(m_url, WS_METHOD_Subscribe);
@@ -202,7 +237,7 @@ bool SubscriptionThreadImpl::SubscribeForEvent(bool renew)
   return false;
 }
 
-bool SubscriptionThreadImpl::UnSubscribeForEvent()
+bool SubscriptionTaskImpl::UnSubscribeForEvent()
 {
   if (!m_SID.empty())
   {
@@ -226,7 +261,7 @@ Subscription::Subscription()
 Subscription::Subscription(const std::string& host, unsigned port, const std::string& url, unsigned bindingPort, unsigned ttl)
 : m_imp()
 {
-  m_imp = SubscriptionThreadPtr(new SubscriptionThreadImpl(host, port, url, bindingPort, ttl));
+  m_imp = SubscriptionThreadPtr(new SubscriptionTaskImpl(host, port, url, bindingPort, ttl));
 }
 
 Subscription::~Subscription()
@@ -30,6 +30,8 @@
 #define SUBSCRIPTION_TIMEOUT_MAX  300
 #define SUBSCRIPTION_TIMEOUT      SUBSCRIPTION_TIMEOUT_MAX
 #define SUBSCRIPTION_RENEW_PCT    90
+#define SUBSCRIPTION_RENEW_JITTER_PCT 10  // Renewal is advanced by up to this part of the timeout
+#define SUBSCRIPTION_RENEW_SPREAD 2000    // Renewals asked at once are spread on this period in millisec
 
 namespace NSROOT
 {
@@ -21,7 +21,7 @@
 #include "zonegrouptopology.h"
 #include "private/builtin.h"
 #include "private/debug.h"
-#include "private/tinyxml2.h"
+#include "private/xmlpushparser.h"
 #include "private/xmldict.h"
 
 using namespace NSROOT;
@@ -57,8 +57,10 @@ ZoneGroupTopology::ZoneGroupTopology(const std::string& serviceHost, unsigned se
 , m_msgCount(0)
 , m_topologyKey(0)
 , m_eventSEQ(0)
+, m_stateHash(0)
 , m_zones(ZoneList())
 , m_zonePlayers(ZonePlayerList())
+, m_changes(ZoneListChanges())
 {
 }
 
@@ -71,8 +73,10 @@ ZoneGroupTopology::ZoneGroupTopology(const std::string& serviceHost, unsigned se
 , m_msgCount(0)
 , m_topologyKey(0)
 , m_eventSEQ(0)
+, m_stateHash(0)
 , m_zones(ZoneList())
 , m_zonePlayers(ZonePlayerList())
+, m_changes(ZoneListChanges())
 {
   unsigned subId = m_subscriptionPool->GetEventHandler().CreateSubscription(this);
   m_subscriptionPool->GetEventHandler().SubscribeForEvent(subId, EVENT_UPNP_PROPCHANGE);
@@ -101,7 +105,7 @@ bool ZoneGroupTopology::GetZoneGroupState()
 bool ZoneGroupTopology::GetZoneGroupAttributes(ElementList& attributes)
 {
   ElementList args;
-  attributes = Request("GetZoneGroupAttributes", args);
+  attributes = RequestCached("GetZoneGroupAttributes", args);
   return (!attributes.empty() && attributes[0]->compare("GetZoneGroupAttributesResponse") == 0);
 }
 
@@ -111,13 +115,12 @@ void ZoneGroupTopology::HandleEventMessage(EventMessagePtr msg)
     return;
   if (msg->event == EVENT_UPNP_PROPCHANGE)
   {
-    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "PROPERTY")
+    if (m_subscription.GetSID() == msg->subject[0] && msg->kind == PROPCHANGE_PROPERTY)
     {
       DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
 
       // check for higher sequence
-      uint32_t seq = 0;
-      string_to_uint32(msg->subject[1].c_str(), &seq);
+      uint32_t seq = msg->seq;
       if (msg->subject[0] != m_eventSID)
       {
         m_eventSID = msg->subject[0];
@@ -129,22 +132,22 @@ void ZoneGroupTopology::HandleEventMessage(EventMessagePtr msg)
       }
       // tracking serial of the event
       m_eventSEQ = seq;
+      // the state has changed
+      InvalidateCache();
 
-      std::vector<std::string>::const_iterator it = msg->subject.begin();
-      unsigned _oldKey = m_topologyKey;
-      while (it != msg->subject.end())
+      bool changed = false;
+      for (const EventVariable& var : msg->vars)
       {
-        if (*it == "ZoneGroupState")
+        if (var.key == EVENT_VAR_ZoneGroupState)
         {
           // BEGIN CRITICAL SECTION
-          ParseZoneGroupState(*++it);
+          ParseZoneGroupState(msg->Value(var), &changed);
           // END CRITICAL SECTION
           break;
         }
-        ++it;
       }
       // Event is signaled only on first or any change
-      if (m_msgCount && _oldKey == m_topologyKey)
+      if (m_msgCount && !changed)
         return;
       // Signal
       ++m_msgCount;
@@ -154,106 +157,232 @@ void ZoneGroupTopology::HandleEventMessage(EventMessagePtr msg)
   }
 }
 
-bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
+namespace
 {
-  tinyxml2::XMLDocument rootdoc;
-  // Parse xml content
-  if (rootdoc.Parse(xml.c_str(), xml.size()) != tinyxml2::XML_SUCCESS)
+/**
+ * A group as described by the state of the topology
+ */
+struct GroupState
+{
+  struct Member
   {
-    DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
-    return false;
+    std::string name;
+    std::string uuid;
+    std::string location;
+    std::string icon;
+    std::string version;
+    std::string mcversion;
+    std::string lcversion;
+  };
+  std::string id;
+  std::string coordinator;
+  std::vector<Member> members;  // the visible members
+};
+
+/**
+ * Collect the groups from the state: ZoneGroups/ZoneGroup/ZoneGroupMember.
+ * Since API version 10.2 (build 50163230) the root element is ZoneGroupState,
+ * and the element ZoneGroups is one of its children.
+ */
+class GroupStateReader : public XMLPushParser::Handler
+{
+public:
+  GroupStateReader(std::vector<GroupState>& groups) : m_groups(groups), m_depth(0), m_groupsDepth(0) { }
+
+  bool StartElement(const std::string& qname, const XMLPushParser::Attribute* attrs, unsigned count) override
+  {
+    unsigned depth = ++m_depth;
+    if (m_groupsDepth == 0)
+    {
+      if (XMLNS::NameEqual(qname.c_str(), "ZoneGroups") && depth <= 2)
+        m_groupsDepth = depth;
+    }
+    else if (depth == m_groupsDepth + 1)
+    {
+      m_groups.push_back(GroupState());
+      m_groups.back().id = attribute("ID", attrs, count);
+      m_groups.back().coordinator = attribute("Coordinator", attrs, count);
+      DBG(DBG_INFO, "%s: group '%s' with coordinator '%s'\n", __FUNCTION__, m_groups.back().id.c_str(),
+          m_groups.back().coordinator.c_str());
+    }
+    else if (depth == m_groupsDepth + 2 && XMLNS::NameEqual(qname.c_str(), "ZoneGroupMember"))
+    {
+      if (attribute("Invisible", attrs, count) == "1")
+      {
+        DBG(DBG_INFO, "%s: discard invisible group member '%s' (%s)\n", __FUNCTION__,
+            attribute("UUID", attrs, count).c_str(), attribute("ZoneName", attrs, count).c_str());
+        return true;
+      }
+      GroupState::Member member;
+      member.name = attribute("ZoneName", attrs, count);
+      member.uuid = attribute("UUID", attrs, count);
+      member.location = attribute("Location", attrs, count);
+      member.icon = attribute("Icon", attrs, count);
+      member.version = attribute("SoftwareVersion", attrs, count);
+      member.mcversion = attribute("MinCompatibleVersion", attrs, count);
+      member.lcversion = attribute("LegacyCompatibleVersion", attrs, count);
+      m_groups.back().members.push_back(member);
+    }
+    return true;
+  }
+
+  bool EndElement(const std::string& qname) override
+  {
+    (void)qname;
+    if (m_depth-- == m_groupsDepth)
+      m_groupsDepth = 0;
+    return true;
   }
 
-  const tinyxml2::XMLElement* elem; // an element
-  if ((elem = rootdoc.RootElement()))
+  bool CharData(const char* data, size_t len) override
   {
-    // since API version 10.2 (build 50163230): the root element is 'ZoneGroupState'
-    if (XMLNS::NameEqual(elem->Name(), "ZoneGroupState"))
-      elem = elem->FirstChildElement();
+    (void)data;
+    (void)len;
+    return true;
   }
-  else
+
+private:
+  std::vector<GroupState>& m_groups;
+  unsigned m_depth;
+  unsigned m_groupsDepth;
+
+  static const std::string& attribute(const char* name, const XMLPushParser::Attribute* attrs, unsigned count)
   {
-    DBG(DBG_ERROR, "%s: invalid or not supported content\n", __FUNCTION__);
-    tinyxml2::XMLPrinter out;
-    rootdoc.Accept(&out);
-    DBG(DBG_ERROR, "%s\n", out.CStr());
+    static const std::string nil;
+    const std::string* str = XMLPushParser::FindAttribute(name, attrs, count);
+    return (str ? *str : nil);
+  }
+};
+
+uint64_t hashContent(const std::string& str)
+{
+  // FNV-1a
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (char c : str)
+  {
+    h ^= (unsigned char)c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+bool samePlayer(ZonePlayer& zp, const GroupState::Member& member, bool coordinator)
+{
+  return (zp.compare(member.name) == 0 &&
+          zp.GetAttribut(ZP_UUID) == member.uuid &&
+          zp.GetAttribut(ZP_COORDINATOR) == (coordinator ? "true" : "false") &&
+          zp.GetAttribut(ZP_LOCATION) == member.location &&
+          zp.GetAttribut(ZP_ICON) == member.icon &&
+          zp.GetAttribut(ZP_VERSION) == member.version &&
+          zp.GetAttribut(ZP_MCVERSION) == member.mcversion &&
+          zp.GetAttribut(ZP_LCVERSION) == member.lcversion);
+}
+
+ZonePlayerPtr findPlayer(const Zone& zone, const std::string& uuid)
+{
+  for (const ZonePlayerPtr& zp : zone)
+  {
+    if (zp->GetUUID() == uuid)
+      return zp;
+  }
+  return ZonePlayerPtr();
+}
+
+bool sameGroup(const Zone& zone, const GroupState& group)
+{
+  if (zone.size() != group.members.size())
     return false;
+  for (const GroupState::Member& member : group.members)
+  {
+    ZonePlayerPtr zp = findPlayer(zone, member.uuid);
+    if (!zp || !samePlayer(*zp, member, member.uuid == group.coordinator))
+      return false;
   }
+  return true;
+}
+}
 
+bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml, bool* changed)
+{
+  if (changed)
+    *changed = false;
+  // the state is sent again on any change of the group: skip it if unchanged
+  uint64_t hash = hashContent(xml);
   Locked<ZoneList>::pointer zones = m_zones.Get();
-  Locked<ZonePlayerList>::pointer zonePlayers = m_zonePlayers.Get();
-  zones->clear();
-  zonePlayers->clear();
+  if (hash == m_stateHash)
+  {
+    DBG(DBG_DEBUG, "%s: state is unchanged\n", __FUNCTION__);
+    return (!zones->empty());
+  }
 
-  while (elem)
+  std::vector<GroupState> groups;
+  GroupStateReader reader(groups);
+  XMLPushParser parser(reader);
+  if (!parser.Feed(xml.c_str(), xml.size()) || !parser.Finish())
   {
-    // VanishedDevices: Added in API version 10.2 (build 50163230)
-    // ZoneGroups
-    if (XMLNS::NameEqual(elem->Name(), "ZoneGroups"))
+    DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
+    return false;
+  }
+
+  // rebuild the lists, keeping the zones and players which are unchanged
+  ZoneListChanges changes;
+  ZoneList nextZones;
+  ZonePlayerList nextPlayers;
+  for (const GroupState& group : groups)
+  {
+    if (group.members.empty())
+      continue;
+    ZoneList::const_iterator it = zones->find(group.id);
+    ZonePtr zone;
+    if (it != zones->end() && sameGroup(*(it->second), group))
+      zone = it->second;
+    else
     {
-      const tinyxml2::XMLElement* gelem = elem->FirstChildElement();
-      while (gelem)
+      zone.reset(new Zone(group.id));
+      for (const GroupState::Member& member : group.members)
       {
-        const tinyxml2::XMLAttribute* attr = gelem->FirstAttribute();
-        Element zoneGroup(gelem->Name());
-        while (attr)
-        {
-          zoneGroup.SetAttribut(attr->Name(), attr->Value());
-          attr = attr->Next();
-        }
-        ZonePtr zone(new Zone(zoneGroup.GetAttribut("ID")));
-        const std::string& cuuid = zoneGroup.GetAttribut("Coordinator");
-        DBG(DBG_INFO, "%s: new group '%s' with coordinator '%s'\n", __FUNCTION__, zone->GetGroup().c_str(), cuuid.c_str());
-        // browse childs
-        const tinyxml2::XMLElement* child = gelem->FirstChildElement();
-        while (child)
-        {
-          if (XMLNS::NameEqual(child->Name(), "ZoneGroupMember"))
-          {
-            const tinyxml2::XMLAttribute* cattr = child->FirstAttribute();
-            Element zoneGroupMember(child->Name());
-            while (cattr)
-            {
-              zoneGroupMember.SetAttribut(cattr->Name(), cattr->Value());
-              cattr = cattr->Next();
-            }
-            if (zoneGroupMember.GetAttribut("Invisible") == "1")
-            {
-              const std::string& mname = zoneGroupMember.GetAttribut("ZoneName");
-              const std::string& muuid = zoneGroupMember.GetAttribut("UUID");
-              DBG(DBG_INFO, "%s: discard invisible group member '%s' (%s)\n", __FUNCTION__, muuid.c_str(), mname.c_str());
-            }
-            else
-            {
-              ZonePlayerPtr zp(new ZonePlayer(zoneGroupMember.GetAttribut("ZoneName")));
-              const std::string& muuid = zoneGroupMember.GetAttribut("UUID");
-              zp->SetAttribut(ZP_UUID, muuid);
-              if (muuid == cuuid)
-                zp->SetAttribut(ZP_COORDINATOR, "true");
-              else
-                zp->SetAttribut(ZP_COORDINATOR, "false");
-              zp->SetAttribut(ZP_LOCATION, zoneGroupMember.GetAttribut("Location"));
-              zp->SetAttribut(ZP_ICON, zoneGroupMember.GetAttribut("Icon"));
-              zp->SetAttribut(ZP_VERSION, zoneGroupMember.GetAttribut("SoftwareVersion"));
-              zp->SetAttribut(ZP_MCVERSION, zoneGroupMember.GetAttribut("MinCompatibleVersion"));
-              zp->SetAttribut(ZP_LCVERSION, zoneGroupMember.GetAttribut("LegacyCompatibleVersion"));
-              DBG(DBG_INFO, "%s: new group member '%s' (%s)\n", __FUNCTION__, muuid.c_str(), zp->c_str());
-              zonePlayers->insert(std::make_pair(*zp, zp));
-              zone->push_back(zp);
-            }
-          }
-          child = child->NextSiblingElement(NULL);
-        }
-        if (!zone->empty())
+        bool coordinator = (member.uuid == group.coordinator);
+        ZonePlayerPtr zp;
+        // the player could come from another group
+        for (ZoneList::const_iterator zit = zones->begin(); !zp && zit != zones->end(); ++zit)
+          zp = findPlayer(*(zit->second), member.uuid);
+        if (!zp || !samePlayer(*zp, member, coordinator))
         {
-          zone->Revamp();
-          zones->insert(std::make_pair(zone->GetGroup(), zone));
+          zp.reset(new ZonePlayer(member.name));
+          zp->SetAttribut(ZP_UUID, member.uuid);
+          zp->SetAttribut(ZP_COORDINATOR, coordinator ? "true" : "false");
+          zp->SetAttribut(ZP_LOCATION, member.location);
+          zp->SetAttribut(ZP_ICON, member.icon);
+          zp->SetAttribut(ZP_VERSION, member.version);
+          zp->SetAttribut(ZP_MCVERSION, member.mcversion);
+          zp->SetAttribut(ZP_LCVERSION, member.lcversion);
+          DBG(DBG_INFO, "%s: new group member '%s' (%s)\n", __FUNCTION__, member.uuid.c_str(), zp->c_str());
         }
-        gelem = gelem->NextSiblingElement(NULL);
+        zone->push_back(zp);
       }
+      zone->Revamp();
+      if (it != zones->end())
+        changes.modified.push_back(group.id);
+      else
+        changes.added.push_back(group.id);
+      DBG(DBG_INFO, "%s: %s group '%s'\n", __FUNCTION__, (it != zones->end() ? "modified" : "new"), group.id.c_str());
     }
-    elem = elem->NextSiblingElement(NULL);
+    for (const ZonePlayerPtr& zp : *zone)
+      nextPlayers.insert(std::make_pair(*zp, zp));
+    nextZones.insert(std::make_pair(group.id, zone));
   }
+  for (ZoneList::const_iterator it = zones->begin(); it != zones->end(); ++it)
+  {
+    if (nextZones.find(it->first) == nextZones.end())
+    {
+      changes.removed.push_back(it->first);
+      DBG(DBG_INFO, "%s: removed group '%s'\n", __FUNCTION__, it->first.c_str());
+    }
+  }
+
+  zones->swap(nextZones);
+  m_zonePlayers.Get()->swap(nextPlayers);
+  m_stateHash = hash;
   // compute a key for this state
   std::string keyStr;
   keyStr.reserve(zones->size() << 5);
@@ -261,5 +390,8 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
     keyStr.append(it->first);
   m_topologyKey = __hashvalue(0xFFFFFFFF, keyStr.c_str());
   DBG(DBG_INFO, "%s: topology key %u\n", __FUNCTION__, m_topologyKey);
+  if (changed)
+    *changed = !changes.empty();
+  m_changes.Store(changes);
   return (!zones->empty());
 }
@@ -28,6 +28,10 @@
 #include "sonoszone.h"
 #include "locked.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace NSROOT
 {
 
@@ -57,6 +61,12 @@ namespace NSROOT
 
     unsigned GetTopologyKey() const { return m_topologyKey; }
 
+    /**
+     * Return the groups changed by the last update. The zone and player
+     * objects of the unchanged groups are kept from one update to the next.
+     */
+    ZoneListChanges GetLastChanges() { return m_changes.Load(); }
+
     Locked<ZoneList>& GetZoneList() { return m_zones; }
 
     Locked<ZonePlayerList>& GetZonePlayerList() { return m_zonePlayers; }
@@ -73,11 +83,13 @@ namespace NSROOT
     unsigned m_topologyKey;
     unsigned m_eventSEQ;
     std::string m_eventSID;
+    uint64_t m_stateHash;
 
     Locked<ZoneList> m_zones;
     Locked<ZonePlayerList> m_zonePlayers;
+    Locked<ZoneListChanges> m_changes;
 
-    bool ParseZoneGroupState(const std::string& xml);
+    bool ParseZoneGroupState(const std::string& xml, bool* changed = nullptr);
 
   };
 }
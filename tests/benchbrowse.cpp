@@ -0,0 +1,205 @@
+#if (defined(_WIN32) || defined(_WIN64))
+#define __WINDOWS__
+#endif
+
+#ifdef __WINDOWS__
+#include <WinSock2.h>
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#include "soapstub.h"
+
+#include "private/wsconnectionpool.h"
+#include "private/wsasyncclient.h"
+#include "private/debug.h"
+#include <noson/contentdirectory.h>
+#include <noson/librarycache.h>
+#include <noson/digitalsnapshot.h>
+
+#include <string.h>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define BENCH_ITEMS     5000  // Size of the content
+#define BENCH_DELAY     10    // Think time of the stand-in media server in millisec
+#define BENCH_WORK      100   // Time spent by the consumer on an item in microsec
+
+static unsigned g_total = BENCH_ITEMS;
+
+/**
+ * The stand-in media server.
+ */
+static SOAPStub::Reply browse(const SOAPStub::Request& request)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_DELAY));
+  return SOAPStub::BrowseResponse(SOAPStub::TagValue(request.body, "StartingIndex"),
+                                  SOAPStub::TagValue(request.body, "RequestedCount"), g_total, 1);
+}
+
+static void work(unsigned usec)
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - t0 < std::chrono::microseconds(usec));
+}
+
+/**
+ * Walk the content with ContentList, spending BENCH_WORK on each item.
+ * @return the elapsed time in millisec
+ */
+static double runList(SONOS::ContentDirectory& service, unsigned lookahead, unsigned& stall)
+{
+  unsigned count = 0;
+  double wait = 0;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  SONOS::ContentList list(service, "A:TRACKS", BROWSE_COUNT, lookahead);
+  SONOS::ContentList::iterator it = list.begin();
+  while (it != list.end())
+  {
+    ++count;
+    work(BENCH_WORK);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    ++it;
+    std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t1;
+    wait += d.count();
+  }
+  std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+  if (count != g_total || list.failure())
+    fprintf(stderr, "browsed %u items of %u\n", count, g_total);
+  stall = (unsigned)wait;
+  return d.count();
+}
+
+/**
+ * Load the content with ContentDirectory::BrowseAll.
+ * @return the elapsed time in millisec
+ */
+static double runAll(SONOS::ContentDirectory& service, unsigned concurrency)
+{
+  std::vector<SONOS::DigitalItemPtr> items;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  bool ok = service.BrowseAll("A:TRACKS", items, concurrency);
+  std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+  if (!ok || items.size() != g_total || items.back()->GetValue("dc:title") != std::string("Track ").append(std::to_string(g_total - 1)))
+    fprintf(stderr, "loaded %u items of %u\n", (unsigned)items.size(), g_total);
+  return d.count();
+}
+
+/**
+ * Load the content stored in the library cache.
+ * @return the elapsed time in millisec
+ */
+static double runCache(SONOS::LibraryCache& cache)
+{
+  SONOS::DigitalItemList items;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  bool ok = cache.Load("A:TRACKS", "A:,1", items);
+  std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+  if (!ok || items.size() != g_total)
+    fprintf(stderr, "loaded %u items of %u from cache\n", (unsigned)items.size(), g_total);
+  return d.count();
+}
+
+/**
+ * Open the snapshot and view the title of every item.
+ * @return the elapsed time in millisec
+ */
+static double runSnapshot(const char * path)
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  SONOS::DigitalSnapshot snapshot;
+  size_t length = 0;
+  if (snapshot.Open(path))
+  {
+    for (SONOS::DigitalSnapshot::iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+      length += strlen((*it).GetValue("dc:title"));
+  }
+  std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+  if (snapshot.size() != g_total || length == 0)
+    fprintf(stderr, "viewed %u items of %u from snapshot\n", snapshot.size(), g_total);
+  return d.count();
+}
+
+int main(int argc, char** argv)
+{
+  int ret = 0;
+#ifdef __WINDOWS__
+  //Initialize Winsock
+  WSADATA wsaData;
+  if ((ret = WSAStartup(MAKEWORD(2, 2), &wsaData)))
+    return ret;
+#else
+  signal(SIGPIPE, SIG_IGN);
+#endif /* __WINDOWS__ */
+
+  if (argc > 1)
+    g_total = (unsigned)atoi(argv[1]);
+
+  SONOS::DBGLevel(0);
+
+  SOAPStub stub(browse);
+  if (!stub.IsValid())
+  {
+    fprintf(stderr, "cannot listen\n");
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "ContentList of %u items, server answering in %u ms, consumer spending %u us per item\n",
+          g_total, BENCH_DELAY, BENCH_WORK);
+  SONOS::ContentDirectory service("127.0.0.1", stub.GetPort());
+  double base = 0;
+  for (unsigned lookahead : { 0, 1, 2, 4 })
+  {
+    unsigned stall = 0;
+    double elapsed = runList(service, lookahead, stall);
+    if (lookahead == 0)
+      base = elapsed;
+    fprintf(stdout, "lookahead %u              : %8.1f ms (x%.2f), stalled %5u ms\n",
+            lookahead, elapsed, base / elapsed, stall);
+  }
+
+  fprintf(stdout, "Load all the %u items\n", g_total);
+  base = 0;
+  SONOS::WSAsyncClient::Instance().SetHostConcurrency(4);
+  for (unsigned concurrency : { 1, 2, 4 })
+  {
+    double elapsed = runAll(service, concurrency);
+    if (concurrency == 1)
+      base = elapsed;
+    fprintf(stdout, "concurrency %u            : %8.1f ms (x%.2f)\n", concurrency, elapsed, base / elapsed);
+  }
+
+  SONOS::DigitalItemList items;
+  SONOS::LibraryCache cache(".", "Sonos_bench");
+  if (service.BrowseAll("A:TRACKS", items) && cache.Store("A:TRACKS", "A:,1", items))
+  {
+    double elapsed = runCache(cache);
+    fprintf(stdout, "library cache            : %8.1f ms (x%.2f)\n", elapsed, base / elapsed);
+    cache.Erase("A:TRACKS");
+  }
+  SONOS::DigitalSnapshot::Writer writer;
+  writer.Add(items);
+  if (writer.Save("benchbrowse.snapshot"))
+  {
+    FILE * file = fopen("benchbrowse.snapshot", "rb");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    double elapsed = runSnapshot("benchbrowse.snapshot");
+    fprintf(stdout, "snapshot                 : %8.1f ms (x%.2f), %ld bytes per item\n",
+            elapsed, base / elapsed, size / (long)g_total);
+    remove("benchbrowse.snapshot");
+  }
+
+  SONOS::WSConnectionPool::Instance().Clear();
+
+#ifdef __WINDOWS__
+  WSACleanup();
+#endif /* __WINDOWS__ */
+  return ret;
+}
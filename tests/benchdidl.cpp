@@ -0,0 +1,101 @@
+#include <noson/didlparser.h>
+#include "private/debug.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define BENCH_PAGES     200   // Pages parsed by a run
+#define BENCH_PAGE_SIZE 100   // Items of a page, as BROWSE_COUNT
+
+/**
+ * The corpus: items shaped as the players return them, from the library,
+ * the favorites and a music service. They are repeated to fill a page.
+ */
+static const char * g_header =
+  "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+  " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">";
+
+static const char * g_corpus[] = {
+  "<item id=\"S://nas/music/Artist%20Name/Album%20Title%20(Deluxe%20Edition)/01%20-%20Track%20Title.flac\""
+  " parentID=\"A:ALBUMARTIST/Artist%20Name/Album%20Title%20(Deluxe%20Edition)\" restricted=\"true\">"
+  "<res protocolInfo=\"x-file-cifs:*:audio/flac:*\" duration=\"0:04:12\">x-file-cifs://nas/music/Artist%20Name/"
+  "Album%20Title%20(Deluxe%20Edition)/01%20-%20Track%20Title.flac</res>"
+  "<upnp:albumArtURI>/getaa?u=x-file-cifs%3a%2f%2fnas%2fmusic%2fArtist%2520Name%2fAlbum%2520Title%2520(Deluxe%2520Edition)"
+  "%2f01%2520-%2520Track%2520Title.flac&amp;v=1284</upnp:albumArtURI>"
+  "<dc:title>Track Title</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>Artist Name</dc:creator><upnp:album>Album Title (Deluxe Edition)</upnp:album>"
+  "<upnp:originalTrackNumber>1</upnp:originalTrackNumber><r:albumArtist>Artist Name</r:albumArtist></item>",
+
+  "<container id=\"A:ALBUMARTIST/Artist%20Name/Album%20Title\" parentID=\"A:ALBUMARTIST/Artist%20Name\" restricted=\"true\">"
+  "<dc:title>Album Title</dc:title><upnp:class>object.container.album.musicAlbum</upnp:class>"
+  "<res protocolInfo=\"x-rincon-playlist:*:*:*\">x-rincon-playlist:RINCON_000E58C0FFEE01400#A:ALBUMARTIST/Artist%20Name/Album%20Title</res>"
+  "<dc:creator>Artist Name</dc:creator>"
+  "<upnp:albumArtURI>/getaa?u=x-file-cifs%3a%2f%2fnas%2fmusic%2fArtist%2520Name%2fAlbum%2520Title%2f01%2520-%2520Intro.flac&amp;v=1284</upnp:albumArtURI>"
+  "</container>",
+
+  "<item id=\"FV:2/42\" parentID=\"FV:2\" restricted=\"false\"><dc:title>Morning Radio</dc:title>"
+  "<upnp:class>object.itemobject.item.sonos-favorite</upnp:class><r:ordinal>4</r:ordinal>"
+  "<res protocolInfo=\"x-sonosapi-stream:*:*:*\">x-sonosapi-stream:s24939?sid=254&amp;flags=8224&amp;sn=0</res>"
+  "<upnp:albumArtURI>https://cdn-profiles.tunein.com/s24939/images/logoq.png?t=636602555323000000</upnp:albumArtURI>"
+  "<r:type>instantPlay</r:type><r:description>TuneIn Station</r:description>"
+  "<r:resMD>&lt;DIDL-Lite xmlns:dc=&quot;http://purl.org/dc/elements/1.1/&quot; xmlns:upnp=&quot;urn:schemas-upnp-org:metadata-1-0/upnp/&quot;"
+  " xmlns:r=&quot;urn:schemas-rinconnetworks-com:metadata-1-0/&quot; xmlns=&quot;urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/&quot;&gt;"
+  "&lt;item id=&quot;F00092020s24939&quot; parentID=&quot;L&quot; restricted=&quot;true&quot;&gt;&lt;dc:title&gt;Morning Radio&lt;/dc:title&gt;"
+  "&lt;upnp:class&gt;object.item.audioItem.audioBroadcast&lt;/upnp:class&gt;&lt;desc id=&quot;cdudn&quot;"
+  " nameSpace=&quot;urn:schemas-rinconnetworks-com:metadata-1-0/&quot;&gt;SA_RINCON65031_&lt;/desc&gt;&lt;/item&gt;&lt;/DIDL-Lite&gt;</r:resMD></item>",
+
+  "<item id=\"10032020spotify%3atrack%3a4uLU6hMCjMI75M1A2tKUQC\" parentID=\"10052064spotify%3aalbum%3a6N9PS4QXF1D0OWPk0Sxtb4\" restricted=\"true\">"
+  "<res protocolInfo=\"sonos.com-spotify:*:audio/x-spotify:*\" duration=\"0:03:33\">x-sonos-spotify:spotify%3atrack%3a4uLU6hMCjMI75M1A2tKUQC?sid=12&amp;flags=8224&amp;sn=3</res>"
+  "<upnp:albumArtURI>https://i.scdn.co/image/ab67616d0000b273e319baafd16e84f0408af2a0</upnp:albumArtURI>"
+  "<dc:title>Streamed Track</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>Band</dc:creator><upnp:album>Streamed Album</upnp:album></item>",
+};
+
+static std::string page()
+{
+  std::string doc(g_header);
+  const unsigned n = sizeof(g_corpus) / sizeof(g_corpus[0]);
+  // mostly tracks of the library, as an album or tracks browse returns
+  for (unsigned i = 0; i < BENCH_PAGE_SIZE; ++i)
+    doc.append(g_corpus[(i % 10) < 7 ? 0 : 1 + (i % n) % (n - 1)]);
+  doc.append("</DIDL-Lite>");
+  return doc;
+}
+
+static double run(const std::string& doc, unsigned pages, bool streaming)
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  size_t count = 0;
+  for (unsigned i = 0; i < pages; ++i)
+  {
+    SONOS::DIDLParser didl(doc.c_str(), BENCH_PAGE_SIZE, streaming);
+    count += didl.GetItems().size();
+  }
+  std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - t0;
+  if (count != (size_t)pages * BENCH_PAGE_SIZE)
+    fprintf(stderr, "parsed %u items of %u\n", (unsigned)count, pages * BENCH_PAGE_SIZE);
+  return d.count() / pages;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned pages = BENCH_PAGES;
+  if (argc > 1)
+    pages = (unsigned)atoi(argv[1]);
+
+  SONOS::DBGLevel(0);
+
+  std::string doc = page();
+  fprintf(stdout, "DIDL page of %u items (%u bytes) x %u\n", BENCH_PAGE_SIZE, (unsigned)doc.size(), pages);
+  // warm up
+  run(doc, 10, false);
+  run(doc, 10, true);
+  double dom = run(doc, pages, false);
+  fprintf(stdout, "DOM                      : %8.1f us per page\n", dom);
+  double stream = run(doc, pages, true);
+  fprintf(stdout, "streaming                : %8.1f us per page (x%.2f)\n", stream, dom / stream);
+  return 0;
+}
@@ -0,0 +1,172 @@
+#if (defined(_WIN32) || defined(_WIN64))
+#define __WINDOWS__
+#endif
+
+#ifdef __WINDOWS__
+#include <WinSock2.h>
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#include "private/wsresponse.h"
+#include "private/socket.h"
+#include "private/debug.h"
+#include "private/os/threads/timeout.h"
+#include <noson/eventhandler.h>
+#include <noson/intrinsic.h>
+
+#include <string.h>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+#define BENCH_PORT      1401
+#define BENCH_REQUESTS  5000
+
+static const char * g_body =
+  "<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\">"
+  "<e:property><ZoneGroupName>Living Room</ZoneGroupName></e:property>"
+  "</e:propertyset>";
+
+class Subscriber : public SONOS::EventSubscriber
+{
+public:
+  Subscriber() : m_started(0), m_count(0) { }
+  void HandleEventMessage(SONOS::EventMessagePtr msg) override
+  {
+    if (msg->event == SONOS::EVENT_UPNP_PROPCHANGE)
+      m_count.Increment();
+    else if (msg->event == SONOS::EVENT_HANDLER_STATUS && msg->subject[0] == EVENTHANDLER_STARTED)
+      m_started.Increment();
+  }
+  bool Started() { return m_started.GetValue() > 0; }
+  int Count() { return m_count.GetValue(); }
+private:
+  SONOS::IntrinsicCounter m_started;
+  SONOS::IntrinsicCounter m_count;
+};
+
+static std::string notifyMessage(unsigned port, unsigned seq, bool keepAlive)
+{
+  std::string msg;
+  msg.append("NOTIFY / HTTP/1.1\r\n");
+  msg.append("HOST: 127.0.0.1:").append(std::to_string(port)).append("\r\n");
+  msg.append("CONTENT-TYPE: text/xml\r\n");
+  msg.append("NT: upnp:event\r\n");
+  msg.append("NTS: upnp:propchange\r\n");
+  msg.append("SID: uuid:RINCON_000000000000001400_sub0000000001\r\n");
+  msg.append("SEQ: ").append(std::to_string(seq)).append("\r\n");
+  msg.append("CONTENT-LENGTH: ").append(std::to_string(strlen(g_body))).append("\r\n");
+  msg.append("CONNECTION: ").append(keepAlive ? "keep-alive" : "close").append("\r\n");
+  msg.append("\r\n");
+  msg.append(g_body);
+  return msg;
+}
+
+/**
+ * Send a request and read the response until the end of its content.
+ * @return the status code, else 0 on failure
+ */
+static int sendRequest(SONOS::TcpSocket& sock, const std::string& msg)
+{
+  if (!sock.SendData(msg.c_str(), msg.size()))
+    return 0;
+  std::string line;
+  size_t len;
+  int status = 0;
+  size_t contentLength = 0;
+  while (SONOS::WSResponse::ReadHeaderLine(&sock, "\r\n", line, &len))
+  {
+    if (len == 0)
+      break;
+    if (status == 0 && sscanf(line.c_str(), "%*s %d", &status) != 1)
+      return 0;
+    if (line.compare(0, 15, "Content-Length:") == 0)
+      contentLength = (size_t)atol(line.c_str() + 15);
+  }
+  char buf[256];
+  while (contentLength > 0)
+  {
+    size_t r = sock.ReceiveData(buf, contentLength > sizeof(buf) ? sizeof(buf) : contentLength);
+    if (r == 0)
+      return 0;
+    contentLength -= r;
+  }
+  return status;
+}
+
+static double run(unsigned port, unsigned count, bool reuse)
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  SONOS::TcpSocket sock;
+  unsigned done = 0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (!sock.IsValid() && !sock.Connect("127.0.0.1", port, 0))
+      break;
+    if (sendRequest(sock, notifyMessage(port, i, reuse)) != 200)
+      break;
+    if (!reuse)
+      sock.Disconnect();
+    ++done;
+  }
+  sock.Disconnect();
+  std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+  if (done < count)
+    fprintf(stderr, "failed after %u requests\n", done);
+  return done / d.count();
+}
+
+int main(int argc, char** argv)
+{
+  int ret = 0;
+#ifdef __WINDOWS__
+  //Initialize Winsock
+  WSADATA wsaData;
+  if ((ret = WSAStartup(MAKEWORD(2, 2), &wsaData)))
+    return ret;
+#else
+  signal(SIGPIPE, SIG_IGN);
+#endif /* __WINDOWS__ */
+
+  unsigned count = BENCH_REQUESTS;
+  if (argc > 1)
+    count = (unsigned)atoi(argv[1]);
+
+  SONOS::DBGLevel(0);
+
+  Subscriber sub;
+  SONOS::EventHandler handler(BENCH_PORT);
+  unsigned subId = handler.CreateSubscription(&sub);
+  handler.SubscribeForEvent(subId, SONOS::EVENT_HANDLER_STATUS);
+  handler.SubscribeForEvent(subId, SONOS::EVENT_UPNP_PROPCHANGE);
+  handler.SetKeepAlive(5, 0);
+  if (!handler.Start())
+    return EXIT_FAILURE;
+  // wait for the listener
+  SONOS::OS::Timeout timeout(5000);
+  while (!sub.Started() && timeout.time_left())
+    usleep(10000);
+
+  fprintf(stdout, "NOTIFY x %u on port %u\n", count, handler.GetPort());
+  double rps = run(handler.GetPort(), count, false);
+  fprintf(stdout, "connection per request : %10.0f req/s\n", rps);
+  double rpsReuse = run(handler.GetPort(), count, true);
+  fprintf(stdout, "persistent connection  : %10.0f req/s (x%.2f)\n", rpsReuse, rpsReuse / rps);
+
+  // wait for the dispatching of all events
+  timeout.set(5000);
+  while ((unsigned)sub.Count() < 2 * count && timeout.time_left())
+    usleep(10000);
+  fprintf(stdout, "events dispatched      : %10d\n", sub.Count());
+  fprintf(stdout, "dispatcher threads     : %10u\n", handler.GetDispatcherThreadCount());
+
+  handler.Stop();
+
+#ifdef __WINDOWS__
+  WSACleanup();
+#endif /* __WINDOWS__ */
+  return ret;
+}
@@ -0,0 +1,296 @@
+
+#include "private/notifyparser.h"
+#include "private/tinyxml2.h"
+#include "private/xmldict.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <new>
+
+#define BENCH_EVENTS    20000
+#define BENCH_CHUNK     4096
+
+/*
+ * Count the allocations made by the parsers
+ */
+static unsigned long g_allocs = 0;
+
+void * operator new(size_t size)
+{
+  ++g_allocs;
+  void * p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void * p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+  free(p);
+}
+
+static std::string escape(const std::string& str)
+{
+  std::string out;
+  for (char c : str)
+  {
+    switch (c)
+    {
+    case '<': out.append("&lt;"); break;
+    case '>': out.append("&gt;"); break;
+    case '&': out.append("&amp;"); break;
+    case '"': out.append("&quot;"); break;
+    default: out.push_back(c);
+    }
+  }
+  return out;
+}
+
+static std::string lastChange(const std::string& event)
+{
+  return std::string("<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\"><e:property><LastChange>")
+          .append(escape(event)).append("</LastChange></e:property></e:propertyset>");
+}
+
+/*
+ * Payloads as sent by a player
+ */
+static std::string payloadAVT()
+{
+  std::string didl(
+    "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+    " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
+    "<item id=\"-1\" parentID=\"-1\" restricted=\"true\"><res protocolInfo=\"x-file-cifs:*:audio/flac:*\""
+    " duration=\"0:04:12\">x-file-cifs://nas/music/Artist/Album/01%20Track.flac</res>"
+    "<r:streamContent></r:streamContent><upnp:albumArtURI>/getaa?s=1&amp;u=x-file-cifs%3a%2f%2fnas%2fmusic%2fArtist"
+    "%2fAlbum%2f01%2520Track.flac</upnp:albumArtURI><dc:title>Track</dc:title><upnp:class>object.item.audioItem.musicTrack"
+    "</upnp:class><dc:creator>Artist</dc:creator><upnp:album>Album</upnp:album><upnp:originalTrackNumber>1"
+    "</upnp:originalTrackNumber><r:albumArtist>Artist</r:albumArtist></item></DIDL-Lite>");
+  std::string event(
+    "<Event xmlns=\"urn:schemas-upnp-org:metadata-1-0/AVT/\" xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\">"
+    "<InstanceID val=\"0\"><TransportState val=\"PLAYING\"/><CurrentPlayMode val=\"NORMAL\"/>"
+    "<CurrentCrossfadeMode val=\"0\"/><NumberOfTracks val=\"12\"/><CurrentTrack val=\"1\"/><CurrentSection val=\"0\"/>"
+    "<CurrentTrackURI val=\"x-file-cifs://nas/music/Artist/Album/01%20Track.flac\"/><CurrentTrackDuration val=\"0:04:12\"/>");
+  event.append("<CurrentTrackMetaData val=\"").append(escape(didl)).append("\"/>");
+  event.append("<r:NextTrackURI val=\"x-file-cifs://nas/music/Artist/Album/02%20Track.flac\"/>");
+  event.append("<r:NextTrackMetaData val=\"").append(escape(didl)).append("\"/>");
+  event.append(
+    "<r:EnqueuedTransportURI val=\"x-rincon-playlist:RINCON_000000000000001400#A:ALBUM/Album\"/>"
+    "<AVTransportURI val=\"x-rincon-queue:RINCON_000000000000001400#0\"/><NextAVTransportURI val=\"\"/>"
+    "<TransportStatus val=\"OK\"/><r:SleepTimerGeneration val=\"0\"/><r:AlarmRunning val=\"0\"/>"
+    "<r:SnoozeRunning val=\"0\"/><r:RestartPending val=\"0\"/><TransportPlaySpeed val=\"1\"/>"
+    "<CurrentMediaDuration val=\"\"/><RecordStorageMedium val=\"NOT_IMPLEMENTED\"/><PlayMedium val=\"NETWORK\"/>"
+    "<PossiblePlaybackStorageMedia val=\"NONE,NETWORK\"/><RecordMediumWriteStatus val=\"NOT_IMPLEMENTED\"/>"
+    "<CurrentRecordQualityMode val=\"NOT_IMPLEMENTED\"/><PossibleRecordQualityModes val=\"NOT_IMPLEMENTED\"/>"
+    "</InstanceID></Event>");
+  return lastChange(event);
+}
+
+static std::string payloadRCS()
+{
+  return lastChange(
+    "<Event xmlns=\"urn:schemas-upnp-org:metadata-1-0/RCS/\"><InstanceID val=\"0\">"
+    "<Volume channel=\"Master\" val=\"21\"/><Volume channel=\"LF\" val=\"100\"/><Volume channel=\"RF\" val=\"100\"/>"
+    "<Mute channel=\"Master\" val=\"0\"/><Mute channel=\"LF\" val=\"0\"/><Mute channel=\"RF\" val=\"0\"/>"
+    "<Bass val=\"0\"/><Treble val=\"0\"/><Loudness channel=\"Master\" val=\"1\"/><OutputFixed val=\"0\"/>"
+    "<HeadphoneConnected val=\"0\"/><SpeakerSize val=\"5\"/><SubGain val=\"0\"/><SubCrossover val=\"0\"/>"
+    "<SubPolarity val=\"0\"/><SubEnabled val=\"1\"/><SonarEnabled val=\"0\"/><SonarCalibrationAvailable val=\"0\"/>"
+    "<PresetNameList val=\"FactoryDefaults\"/></InstanceID></Event>");
+}
+
+static std::string payloadZoneGroupState()
+{
+  std::string state("<ZoneGroupState><ZoneGroups>");
+  for (int g = 0; g < 4; ++g)
+  {
+    std::string coordinator("RINCON_00000000000");
+    coordinator.append(std::to_string(g)).append("1400");
+    state.append("<ZoneGroup Coordinator=\"").append(coordinator)
+         .append("\" ID=\"").append(coordinator).append(":").append(std::to_string(100 + g)).append("\">");
+    for (int m = 0; m < 2; ++m)
+    {
+      state.append("<ZoneGroupMember UUID=\"RINCON_00000000000").append(std::to_string(g)).append(std::to_string(m))
+           .append("1400\" Location=\"http://192.168.1.").append(std::to_string(10 + g * 2 + m))
+           .append(":1400/xml/device_description.xml\" ZoneName=\"Room ").append(std::to_string(g)).append("\"")
+           .append(" Icon=\"x-rincon-roomicon:living\" Configuration=\"1\" SoftwareVersion=\"70.3-35220\""
+                   " MinCompatibleVersion=\"69.0-00000\" LegacyCompatibleVersion=\"58.0-00000\" BootSeq=\"42\" TVConfigurationError=\"0\""
+                   " HdmiCecAvailable=\"0\" WirelessMode=\"0\" WirelessLeafOnly=\"0\" ChannelFreq=\"2412\" BehindWifiExtender=\"0\""
+                   " WifiEnabled=\"1\" Orientation=\"0\" RoomCalibrationState=\"4\" SecureRegState=\"3\" VoiceConfigState=\"0\""
+                   " MicEnabled=\"0\" AirPlayEnabled=\"1\" IdleState=\"1\"/>");
+    }
+    state.append("</ZoneGroup>");
+  }
+  state.append("</ZoneGroups><VanishedDevices></VanishedDevices></ZoneGroupState>");
+  // the embedded document must be well formed, with all its members
+  tinyxml2::XMLDocument doc;
+  if (doc.Parse(state.c_str(), state.size()) != tinyxml2::XML_SUCCESS)
+    return std::string();
+  unsigned members = 0;
+  for (const tinyxml2::XMLElement* group = doc.RootElement()->FirstChildElement("ZoneGroups")->FirstChildElement("ZoneGroup");
+          group; group = group->NextSiblingElement("ZoneGroup"))
+  {
+    for (const tinyxml2::XMLElement* member = group->FirstChildElement("ZoneGroupMember");
+            member; member = member->NextSiblingElement("ZoneGroupMember"))
+      ++members;
+  }
+  if (members != 8)
+    return std::string();
+  return std::string("<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\">"
+                     "<e:property><ZoneGroupState>").append(escape(state)).append("</ZoneGroupState></e:property>"
+                     "<e:property><ThirdPartyMediaServersX>0</ThirdPartyMediaServersX></e:property>"
+                     "<e:property><AvailableSoftwareUpdate>&lt;UpdateItem/&gt;</AvailableSoftwareUpdate></e:property>"
+                     "<e:property><ZoneGroupName>Room 0</ZoneGroupName></e:property>"
+                     "<e:property><ZoneGroupID>RINCON_000000000000001400:100</ZoneGroupID></e:property>"
+                     "<e:property><ZonePlayerUUIDsInGroup>RINCON_000000000000001400,RINCON_000000000000011400"
+                     "</ZonePlayerUUIDsInGroup></e:property></e:propertyset>");
+}
+
+/*
+ * The former decoding: a DOM for the body, then a DOM for the embedded document
+ */
+#define NS_RCS "urn:schemas-upnp-org:metadata-1-0/RCS/"
+#define NS_AVT "urn:schemas-upnp-org:metadata-1-0/AVT/"
+
+namespace NSROOT
+{
+  extern XMLDict RCSDict;
+  extern XMLDict AVTDict;
+}
+
+static bool parseDOM(const std::string& body, std::vector<std::string>& subject)
+{
+  std::string data;
+  for (size_t p = 0; p < body.size(); p += BENCH_CHUNK)
+    data.append(body, p, BENCH_CHUNK);
+  tinyxml2::XMLDocument rootdoc;
+  if (rootdoc.Parse(data.c_str(), data.size()) != tinyxml2::XML_SUCCESS)
+    return false;
+  const tinyxml2::XMLElement* root;
+  const tinyxml2::XMLElement* elem;
+  const tinyxml2::XMLNode* node;
+  tinyxml2::XMLDocument doc;
+  const char* str;
+  if (!(root = rootdoc.RootElement()) || !SONOS::XMLNS::NameEqual(root->Name(), "propertyset"))
+    return false;
+  if ((node = root->FirstChild()) && SONOS::XMLNS::NameEqual(node->Value(), "property"))
+  {
+    if ((elem = node->FirstChildElement("LastChange")))
+    {
+      if (doc.Parse(elem->GetText()) != tinyxml2::XML_SUCCESS || !(elem = doc.RootElement()))
+        return false;
+      SONOS::XMLNames docns;
+      docns.AddXMLNS(elem);
+      bool rcs = false;
+      SONOS::XMLDict* dict = nullptr;
+      if (docns.FindName(NS_RCS) && (node = elem->FirstChildElement("InstanceID")))
+      {
+        subject.push_back("RCS");
+        dict = &SONOS::RCSDict;
+        rcs = true;
+      }
+      else if (docns.FindName(NS_AVT) && (node = elem->FirstChildElement("InstanceID")))
+      {
+        subject.push_back("AVT");
+        dict = &SONOS::AVTDict;
+      }
+      if (dict)
+      {
+        elem = node->FirstChildElement(NULL);
+        while (elem)
+        {
+          std::string name(dict->TranslateQName(docns, elem->Name()));
+          if (rcs && (str = elem->Attribute("channel")))
+            name.append("/").append(str);
+          subject.push_back(name);
+          subject.push_back((str = elem->Attribute("val")) ? str : "");
+          elem = elem->NextSiblingElement(NULL);
+        }
+      }
+    }
+    else
+    {
+      subject.push_back("PROPERTY");
+      do
+      {
+        if ((elem = node->FirstChildElement(NULL)))
+        {
+          subject.push_back(SONOS::XMLNS::LocalName(elem->Name()));
+          subject.push_back((str = elem->GetText()) ? str : "");
+        }
+        node = node->NextSibling();
+      } while (node && SONOS::XMLNS::NameEqual(node->Value(), "property"));
+    }
+  }
+  return true;
+}
+
+static bool parseStream(const std::string& body, std::vector<std::string>& subject)
+{
+  SONOS::NotifyParser parser(subject);
+  for (size_t p = 0; p < body.size(); p += BENCH_CHUNK)
+  {
+    if (!parser.Feed(body.data() + p, std::min((size_t)BENCH_CHUNK, body.size() - p)))
+      return false;
+  }
+  return parser.Finish();
+}
+
+typedef bool (*parser_t)(const std::string&, std::vector<std::string>&);
+
+static bool run(const char * name, parser_t parser, const std::string& body)
+{
+  unsigned long allocs = g_allocs;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_EVENTS; ++i)
+  {
+    std::vector<std::string> subject;
+    if (!parser(body, subject))
+    {
+      fprintf(stderr, "%s: parse failed\n", name);
+      return false;
+    }
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  allocs = g_allocs - allocs;
+  fprintf(stdout, "  %-8s %8.2f us/event %8.1f allocs/event\n", name,
+          elapsed.count() / BENCH_EVENTS, (double)allocs / BENCH_EVENTS);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  struct { const char * name; std::string body; } payloads[] = {
+    { "AVT", payloadAVT() },
+    { "RCS", payloadRCS() },
+    { "ZoneGroupState", payloadZoneGroupState() },
+  };
+  for (auto& payload : payloads)
+  {
+    if (payload.body.empty())
+    {
+      fprintf(stderr, "%s: malformed payload\n", payload.name);
+      return EXIT_FAILURE;
+    }
+    std::vector<std::string> expected, actual;
+    if (!parseDOM(payload.body, expected) || !parseStream(payload.body, actual) || expected != actual)
+    {
+      fprintf(stderr, "%s: results differ\n", payload.name);
+      return EXIT_FAILURE;
+    }
+    fprintf(stdout, "%s (%u bytes, %u values)\n", payload.name,
+            (unsigned)payload.body.size(), (unsigned)(actual.size() - 1) / 2);
+    if (!run("dom", parseDOM, payload.body) || !run("stream", parseStream, payload.body))
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+#if (defined(_WIN32) || defined(_WIN64))
+#define __WINDOWS__
+#endif
+
+#ifdef __WINDOWS__
+#include <WinSock2.h>
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#include "soapstub.h"
+
+#include "private/wsresponse.h"
+#include "private/wsconnectionpool.h"
+#include "private/debug.h"
+#include <noson/avtransport.h>
+
+#include <string.h>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+
+#define BENCH_REQUESTS  2000
+#define BENCH_HOSTS     4     // Stand-in players for the asynchronous requests
+#define BENCH_DELAY     2     // Think time of the stand-in players in millisec
+
+static const char * g_soapAction = "\"urn:schemas-upnp-org:service:AVTransport:1#GetPositionInfo\"";
+
+static const char * g_soapRequest =
+  "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+  "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"
+  "<s:Body><u:GetPositionInfo xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">"
+  "<InstanceID>0</InstanceID></u:GetPositionInfo></s:Body></s:Envelope>";
+
+static const char * g_soapResponse =
+  "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"
+  "<s:Body><u:GetPositionInfoResponse xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">"
+  "<Track>3</Track><TrackDuration>0:03:45</TrackDuration>"
+  "<TrackMetaData>&lt;DIDL-Lite xmlns:dc=&quot;http://purl.org/dc/elements/1.1/&quot;&gt;&lt;item id=&quot;-1&quot;&gt;"
+  "&lt;dc:title&gt;Track&lt;/dc:title&gt;&lt;/item&gt;&lt;/DIDL-Lite&gt;</TrackMetaData>"
+  "<TrackURI>x-file-cifs://server/music/track.flac</TrackURI><RelTime>0:01:02</RelTime>"
+  "<AbsTime>NOT_IMPLEMENTED</AbsTime><RelCount>2147483647</RelCount><AbsCount>2147483647</AbsCount>"
+  "</u:GetPositionInfoResponse></s:Body></s:Envelope>";
+
+/**
+ * The stand-in player, answering after the delay.
+ */
+struct Player
+{
+  unsigned delay;
+  SOAPStub::Reply operator()(const SOAPStub::Request&) const
+  {
+    if (delay)
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    SOAPStub::Reply reply;
+    reply.status = 200;
+    reply.content.assign(g_soapResponse);
+    return reply;
+  }
+};
+
+struct Stats
+{
+  double mean;
+  double p50;
+  double p99;
+  unsigned connections;
+};
+
+static Stats stats(std::vector<double>& samples, unsigned connections)
+{
+  Stats st;
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for (double d : samples)
+    sum += d;
+  st.mean = sum / samples.size();
+  st.p50 = samples[samples.size() / 2];
+  st.p99 = samples[samples.size() * 99 / 100];
+  st.connections = connections;
+  return st;
+}
+
+static void print(const char * label, const Stats& st)
+{
+  fprintf(stdout, "%-25s: mean %7.1f us, p50 %7.1f us, p99 %7.1f us, %5u connections\n",
+          label, st.mean, st.p50, st.p99, st.connections);
+}
+
+/**
+ * Post GetPositionInfo as Service::Request does.
+ */
+static Stats runRaw(SOAPStub& stub, unsigned count, bool keepAlive)
+{
+  std::vector<double> samples;
+  unsigned c0 = stub.GetConnectionCount();
+  for (unsigned i = 0; i < count; ++i)
+  {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    SONOS::WSRequest request("127.0.0.1", stub.GetPort());
+    request.RequestService("/MediaRenderer/AVTransport/Control", WS_METHOD_Post);
+    request.SetHeader("SOAPAction", g_soapAction);
+    request.SetContentCustom("text/xml", g_soapRequest);
+    request.SetKeepAlive(keepAlive);
+    SONOS::WSResponse response(request);
+    std::string data;
+    char buffer[4096];
+    size_t l;
+    while ((l = response.ReadContent(buffer, sizeof(buffer))))
+      data.append(buffer, l);
+    if (!response.IsSuccessful() || data.size() != strlen(g_soapResponse))
+    {
+      fprintf(stderr, "failed after %u requests\n", i);
+      break;
+    }
+    std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - t0;
+    samples.push_back(d.count());
+  }
+  return stats(samples, stub.GetConnectionCount() - c0);
+}
+
+/**
+ * Call AVTransport::GetPositionInfo. The service caches the position for a
+ * second, so a new one is used for each call.
+ */
+static Stats runService(SOAPStub& stub, unsigned count)
+{
+  std::vector<double> samples;
+  unsigned c0 = stub.GetConnectionCount();
+  for (unsigned i = 0; i < count; ++i)
+  {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    SONOS::AVTransport avt("127.0.0.1", stub.GetPort());
+    SONOS::ElementList vars;
+    if (!avt.GetPositionInfo(vars))
+    {
+      fprintf(stderr, "failed after %u requests\n", i);
+      break;
+    }
+    std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - t0;
+    samples.push_back(d.count());
+  }
+  return stats(samples, stub.GetConnectionCount() - c0);
+}
+
+static void countResponse(void * handle, const SONOS::ElementList& vars)
+{
+  if (!vars.empty() && vars[0]->compare("GetPositionInfoResponse") == 0)
+    ++(*static_cast<std::atomic<unsigned>*>(handle));
+}
+
+/**
+ * Call GetPositionInfo on several players, one call after the other, or all
+ * at once.
+ * @return the elapsed time in millisec
+ */
+static double runPlayers(const std::vector<unsigned>& ports, unsigned count, bool async)
+{
+  std::vector<SONOS::AVTransport*> players;
+  for (unsigned port : ports)
+    players.push_back(new SONOS::AVTransport("127.0.0.1", port));
+  SONOS::ElementList args;
+  args.push_back(SONOS::ElementPtr(new SONOS::Element("InstanceID", "0")));
+  std::atomic<unsigned> done(0);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  if (async)
+  {
+    std::vector<SONOS::ServiceRequestPtr> calls;
+    for (unsigned i = 0; i < count; ++i)
+      calls.push_back(players[i % players.size()]->RequestAsync("GetPositionInfo", args, countResponse, &done));
+    for (SONOS::ServiceRequestPtr& call : calls)
+      call->Wait();
+  }
+  else
+  {
+    for (unsigned i = 0; i < count; ++i)
+    {
+      // the cached position is dropped with the service
+      SONOS::AVTransport avt("127.0.0.1", ports[i % ports.size()]);
+      SONOS::ElementList vars;
+      if (avt.GetPositionInfo(vars))
+        ++done;
+    }
+  }
+  std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+  for (SONOS::AVTransport * avt : players)
+    delete avt;
+  if (done < count)
+    fprintf(stderr, "%u requests failed\n", count - done);
+  return d.count();
+}
+
+int main(int argc, char** argv)
+{
+  int ret = 0;
+#ifdef __WINDOWS__
+  //Initialize Winsock
+  WSADATA wsaData;
+  if ((ret = WSAStartup(MAKEWORD(2, 2), &wsaData)))
+    return ret;
+#else
+  signal(SIGPIPE, SIG_IGN);
+#endif /* __WINDOWS__ */
+
+  unsigned count = BENCH_REQUESTS;
+  if (argc > 1)
+    count = (unsigned)atoi(argv[1]);
+
+  SONOS::DBGLevel(0);
+
+  SOAPStub server(Player { 0 });
+  // the stand-in players for the asynchronous requests
+  std::vector<SOAPStub*> players;
+  std::vector<unsigned> ports;
+  for (unsigned h = 0; h < BENCH_HOSTS; ++h)
+  {
+    players.push_back(new SOAPStub(Player { BENCH_DELAY }));
+    ports.push_back(players.back()->GetPort());
+  }
+  if (!server.IsValid() || std::find(ports.begin(), ports.end(), 0) != ports.end())
+  {
+    fprintf(stderr, "cannot listen\n");
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "GetPositionInfo x %u on port %u\n", count, server.GetPort());
+  Stats perRequest = runRaw(server, count, false);
+  print("connection per request", perRequest);
+  Stats pooled = runRaw(server, count, true);
+  print("pooled connection", pooled);
+  print("AVTransport (pooled)", runService(server, count));
+  fprintf(stdout, "speedup (mean)           : x%.2f\n", perRequest.mean / pooled.mean);
+
+  unsigned calls = count / 4;
+  fprintf(stdout, "GetPositionInfo x %u on %u players answering in %u ms\n", calls, BENCH_HOSTS, BENCH_DELAY);
+  double sequential = runPlayers(ports, calls, false);
+  fprintf(stdout, "one after the other      : %8.1f ms\n", sequential);
+  double async = runPlayers(ports, calls, true);
+  fprintf(stdout, "asynchronous             : %8.1f ms (x%.2f)\n", async, sequential / async);
+  fprintf(stdout, "idle pooled connections  : %u\n", SONOS::WSConnectionPool::Instance().GetIdleCount());
+
+  SONOS::WSConnectionPool::Instance().Clear();
+  for (SOAPStub * player : players)
+    delete player;
+
+#ifdef __WINDOWS__
+  WSACleanup();
+#endif /* __WINDOWS__ */
+  return ret;
+}
@@ -0,0 +1,220 @@
+#if (defined(_WIN32) || defined(_WIN64))
+#define __WINDOWS__
+#endif
+
+#ifdef __WINDOWS__
+#include <WinSock2.h>
+#include <Windows.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include "soapstub.h"
+
+#include <private/wsresponse.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __WINDOWS__
+#define strncasecmp _strnicmp
+#endif
+
+using namespace NSROOT;
+
+unsigned BindFreePort(TcpServerSocket& server)
+{
+  if (!server.Create(SOCKET_AF_INET4) || !server.Bind(0))
+    return 0;
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(server.GetHandle(), (struct sockaddr*)&addr, &len) != 0)
+    return 0;
+  return ntohs(addr.sin_port);
+}
+
+SOAPStub::SOAPStub(const Handler& handler)
+: m_handler(handler)
+, m_port(0)
+, m_stop(false)
+, m_connections(0)
+{
+  unsigned port = BindFreePort(m_server);
+  if (port && m_server.ListenConnection())
+  {
+    m_port = port;
+    m_listener = std::thread(&SOAPStub::Listen, this);
+  }
+}
+
+SOAPStub::~SOAPStub()
+{
+  m_stop = true;
+  if (m_listener.joinable())
+    m_listener.join();
+  for (std::thread& t : m_threads)
+    t.join();
+}
+
+std::vector<SOAPStub::Request> SOAPStub::GetRequests()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_requests;
+}
+
+bool SOAPStub::WaitRequests(size_t count, unsigned timeout)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return m_condition.wait_for(lock, std::chrono::milliseconds(timeout), [&]{ return m_requests.size() >= count; });
+}
+
+SOAPStub::Reply SOAPStub::Response(const std::string& service, const std::string& action, const std::string& content)
+{
+  Reply reply;
+  reply.status = 200;
+  reply.content.assign("<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"
+                       "<s:Body><u:").append(action).append("Response xmlns:u=\"urn:schemas-upnp-org:service:")
+               .append(service).append(":1\">").append(content).append("</u:").append(action)
+               .append("Response></s:Body></s:Envelope>");
+  return reply;
+}
+
+SOAPStub::Reply SOAPStub::Fault(int errorCode)
+{
+  Reply reply;
+  reply.status = 500;
+  reply.content.assign("<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"
+                       "<s:Body><s:Fault><faultcode>s:Client</faultcode><faultstring>UPnPError</faultstring><detail>"
+                       "<UPnPError xmlns=\"urn:schemas-upnp-org:control-1-0\"><errorCode>")
+               .append(std::to_string(errorCode)).append("</errorCode></UPnPError></detail></s:Fault></s:Body></s:Envelope>");
+  return reply;
+}
+
+static void appendEscaped(std::string& out, const std::string& str)
+{
+  for (char c : str)
+  {
+    switch (c)
+    {
+    case '<': out.append("&lt;"); break;
+    case '>': out.append("&gt;"); break;
+    case '&': out.append("&amp;"); break;
+    case '"': out.append("&quot;"); break;
+    default: out.push_back(c);
+    }
+  }
+}
+
+SOAPStub::Reply SOAPStub::BrowseResponse(unsigned index, unsigned count, unsigned total, unsigned updateID)
+{
+  std::string didl("<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+                   " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">");
+  unsigned n = 0;
+  for (unsigned i = index; i < total && n < count; ++i, ++n)
+  {
+    std::string id = std::to_string(i);
+    didl.append("<item id=\"S://server/music/").append(id).append(".flac\" parentID=\"A:TRACKS\" restricted=\"true\">")
+        .append("<res protocolInfo=\"x-file-cifs:*:audio/flac:*\">x-file-cifs://server/music/").append(id).append(".flac</res>")
+        .append("<upnp:albumArtURI>/getaa?u=x-file-cifs%3a%2f%2fserver%2fmusic%2f").append(id).append(".flac&amp;v=1</upnp:albumArtURI>")
+        .append("<dc:title>Track ").append(id).append("</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>")
+        .append("<dc:creator>Artist</dc:creator><upnp:album>Album</upnp:album><upnp:originalTrackNumber>")
+        .append(std::to_string(i % 12 + 1)).append("</upnp:originalTrackNumber></item>");
+  }
+  didl.append("</DIDL-Lite>");
+  std::string content("<Result>");
+  appendEscaped(content, didl);
+  content.append("</Result><NumberReturned>").append(std::to_string(n)).append("</NumberReturned>")
+         .append("<TotalMatches>").append(std::to_string(total)).append("</TotalMatches>")
+         .append("<UpdateID>").append(std::to_string(updateID)).append("</UpdateID>");
+  return Response("ContentDirectory", "Browse", content);
+}
+
+unsigned SOAPStub::TagValue(const std::string& body, const char * tag)
+{
+  std::string open = std::string("<").append(tag).append(">");
+  size_t p = body.find(open);
+  if (p == std::string::npos)
+    return 0;
+  return (unsigned)atol(body.c_str() + p + open.size());
+}
+
+void SOAPStub::Listen()
+{
+  while (!m_stop)
+  {
+    TcpSocket * sock = new TcpSocket();
+    if (m_server.AcceptConnection(*sock, 1) == TcpServerSocket::ACCEPT_SUCCESS)
+    {
+      ++m_connections;
+      m_threads.push_back(std::thread(&SOAPStub::Serve, this, sock));
+    }
+    else
+      delete sock;
+  }
+}
+
+void SOAPStub::Serve(TcpSocket * sock)
+{
+  for (;;)
+  {
+    // await the next request, so an idle connection sees the stop
+    int ready = (sock->HasBufferedData() ? 1 : 0);
+    while (ready == 0 && !m_stop)
+    {
+      struct timeval tv = { 0, 100000 };
+      ready = sock->Listen(&tv);
+    }
+    if (ready <= 0)
+      break;
+    Request request;
+    std::string line;
+    size_t len;
+    size_t contentLength = 0;
+    bool close = false;
+    int n = 0;
+    while (WSResponse::ReadHeaderLine(sock, "\r\n", line, &len))
+    {
+      ++n;
+      if (len == 0)
+        break;
+      if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0)
+        contentLength = (size_t)atol(line.c_str() + 15);
+      else if (strncasecmp(line.c_str(), "Connection:", 11) == 0 && strstr(line.c_str(), "close"))
+        close = true;
+      else if (strncasecmp(line.c_str(), "SOAPAction:", 11) == 0)
+      {
+        size_t p = line.find('#');
+        if (p != std::string::npos)
+          request.action = line.substr(p + 1, line.find('"', p) - p - 1);
+      }
+    }
+    if (n == 0 || len != 0)
+      break;
+    char buf[1024];
+    while (contentLength > 0)
+    {
+      size_t r = sock->ReceiveData(buf, contentLength > sizeof(buf) ? sizeof(buf) : contentLength);
+      if (r == 0)
+        break;
+      request.body.append(buf, r);
+      contentLength -= r;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_requests.push_back(request);
+      m_condition.notify_all();
+    }
+    Reply reply = m_handler(request);
+    std::string msg("HTTP/1.1 ");
+    msg.append(std::to_string(reply.status)).append(reply.status == 200 ? " OK" : " Internal Server Error").append("\r\n")
+       .append("CONTENT-TYPE: text/xml; charset=\"utf-8\"\r\nSERVER: Linux UPnP/1.0 Sonos/70.3\r\n")
+       .append("CONTENT-LENGTH: ").append(std::to_string(reply.content.size())).append("\r\n")
+       .append("CONNECTION: ").append(close ? "close" : "keep-alive").append("\r\n\r\n").append(reply.content);
+    if (!sock->SendData(msg.c_str(), msg.size()) || close)
+      break;
+  }
+  sock->Disconnect();
+  delete sock;
+}
@@ -0,0 +1,106 @@
+#ifndef SOAPSTUB_H
+#define SOAPSTUB_H
+
+#include <private/socket.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Bind the server socket to a free port of the host.
+ * @return the port, else 0 on failure
+ */
+unsigned BindFreePort(NSROOT::TcpServerSocket& server);
+
+/**
+ * A stand-in for the SOAP services of a player. It listens on a free port,
+ * and serves each connection from its own thread, keeping it alive until
+ * the client closes it or asks for closing. The requests are recorded, then
+ * passed to the handler, which could block or delay its reply.
+ */
+class SOAPStub
+{
+public:
+  struct Request
+  {
+    std::string action;   // the name of the action, i.e GetVolume
+    std::string body;     // the SOAP envelope
+  };
+
+  struct Reply
+  {
+    int status;           // the HTTP status
+    std::string content;  // the SOAP envelope
+  };
+
+  typedef std::function<Reply(const Request&)> Handler;
+
+  SOAPStub(const Handler& handler);
+
+  /**
+   * Stop listening, and wait for the connections to be closed by the
+   * clients or found idle.
+   */
+  ~SOAPStub();
+
+  SOAPStub(const SOAPStub&) = delete;
+  SOAPStub& operator=(const SOAPStub&) = delete;
+
+  bool IsValid() const { return m_port != 0; }
+
+  unsigned GetPort() const { return m_port; }
+
+  unsigned GetConnectionCount() const { return m_connections; }
+
+  std::vector<Request> GetRequests();
+
+  /**
+   * Wait until the count of received requests is reached.
+   * @param timeout in millisec
+   * @return true if reached, else false
+   */
+  bool WaitRequests(size_t count, unsigned timeout);
+
+  /**
+   * @return the response of the action of the service, i.e RenderingControl
+   */
+  static Reply Response(const std::string& service, const std::string& action, const std::string& content);
+
+  /**
+   * @return the UPnP fault with the error code
+   */
+  static Reply Fault(int errorCode);
+
+  /**
+   * @return the response of Browse with the tracks of the range, whose
+   * title is "Track {index}"
+   */
+  static Reply BrowseResponse(unsigned index, unsigned count, unsigned total, unsigned updateID);
+
+  /**
+   * @return the number in the element of the body, or 0
+   */
+  static unsigned TagValue(const std::string& body, const char * tag);
+
+private:
+  Handler m_handler;
+  NSROOT::TcpServerSocket m_server;
+  unsigned m_port;
+  std::atomic<bool> m_stop;
+  std::atomic<unsigned> m_connections;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::vector<Request> m_requests;
+  std::vector<std::thread> m_threads;
+  std::thread m_listener;
+
+  void Listen();
+  void Serve(NSROOT::TcpSocket * sock);
+};
+
+#endif /* SOAPSTUB_H */
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <noson/service.h>
+#include <private/commandcoalescer.h>
+
+using namespace NSROOT;
+
+class StubService : public Service
+{
+public:
+  StubService(unsigned port) : Service("127.0.0.1", port) { }
+  const std::string& GetName() const { return Name; }
+  const std::string& GetControlURL() const { return ControlURL; }
+  const std::string& GetEventURL() const { return EventURL; }
+  const std::string& GetSCPDURL() const { return SCPDURL; }
+  static const std::string Name;
+  static const std::string ControlURL;
+  static const std::string EventURL;
+  static const std::string SCPDURL;
+};
+
+const std::string StubService::Name("RenderingControl");
+const std::string StubService::ControlURL("/MediaRenderer/RenderingControl/Control");
+const std::string StubService::EventURL("/MediaRenderer/RenderingControl/Event");
+const std::string StubService::SCPDURL("/xml/RenderingControl1.xml");
+
+/**
+ * The gate holds the responses until it is opened, and fails SetMute.
+ */
+struct Gate
+{
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool open = false;
+
+  void Open()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    open = true;
+    condition.notify_all();
+  }
+
+  SOAPStub::Reply operator()(const SOAPStub::Request& request)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    // bounded, so a failed test doesn't hang
+    condition.wait_for(lock, std::chrono::seconds(5), [&]{ return open; });
+    if (request.action == "SetMute")
+      return SOAPStub::Fault(501);
+    return SOAPStub::Response(StubService::Name, request.action, "");
+  }
+};
+
+static ElementList volumeArgs(int value)
+{
+  ElementList args;
+  args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  args.push_back(ElementPtr(new Element("Channel", "Master")));
+  args.push_back(ElementPtr(new Element("DesiredVolume", std::to_string(value))));
+  return args;
+}
+
+TEST_CASE("Coalesce the commands of a same kind")
+{
+  Gate gate;
+  SOAPStub stub(std::ref(gate));
+  REQUIRE( stub.IsValid() );
+  StubService service(stub.GetPort());
+  {
+    CommandCoalescer commands;
+    commands.Submit("Volume", &service, "SetVolume", volumeArgs(1));
+    REQUIRE( stub.WaitRequests(1, 5000) );
+    // the first is in flight: each one replaces the one held
+    for (int v = 2; v <= 5; ++v)
+      commands.Submit("Volume", &service, "SetVolume", volumeArgs(v));
+    REQUIRE( commands.GetDroppedCount() == 3 );
+    REQUIRE( !commands.WaitIdle(100) );
+    gate.Open();
+    REQUIRE( commands.WaitIdle(5000) );
+    REQUIRE( commands.GetSentCount() == 2 );
+    REQUIRE( commands.GetDroppedCount() == 3 );
+    REQUIRE( commands.GetFailedCount() == 0 );
+    std::vector<SOAPStub::Request> requests = stub.GetRequests();
+    REQUIRE( requests.size() == 2 );
+    REQUIRE( requests[0].body.find("<DesiredVolume>1</DesiredVolume>") != std::string::npos );
+    REQUIRE( requests[1].body.find("<DesiredVolume>5</DesiredVolume>") != std::string::npos );
+
+    // a failure is counted
+    ElementList args;
+    args.push_back(ElementPtr(new Element("InstanceID", "0")));
+    commands.Submit("Mute", &service, "SetMute", args);
+    REQUIRE( commands.WaitIdle(5000) );
+    REQUIRE( commands.GetSentCount() == 2 );
+    REQUIRE( commands.GetFailedCount() == 1 );
+  }
+}
+
+TEST_CASE("Destroy the coalescer with a command in flight")
+{
+  Gate gate;
+  SOAPStub stub(std::ref(gate));
+  REQUIRE( stub.IsValid() );
+  StubService service(stub.GetPort());
+
+  CommandCoalescer * commands = new CommandCoalescer();
+  commands->Submit("Volume", &service, "SetVolume", volumeArgs(1));
+  REQUIRE( stub.WaitRequests(1, 5000) );
+  commands->Submit("Volume", &service, "SetVolume", volumeArgs(2));
+  // the destructor doesn't wait for the response held by the stub
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  delete commands;
+  REQUIRE( std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000) );
+  // the completion comes after the coalescer is gone
+  gate.Open();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  REQUIRE( stub.GetRequests().size() == 1 );
+}
@@ -0,0 +1,224 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <noson/contentdirectory.h>
+#include <private/wsasyncclient.h>
+
+using namespace NSROOT;
+
+/**
+ * A stand-in media server: it delays the first chunk of each pair, so the
+ * responses come out of order, and it could shorten a chunk or change the
+ * UpdateID of the content at a given index. Once held, it answers the first
+ * chunk only until it is released.
+ */
+struct MediaServer
+{
+  unsigned total = 350;
+  unsigned shortIndex = 0;      // the chunk to shorten, if not 0
+  unsigned shortCount = 0;
+  unsigned changeIndex = 0;     // the content changes at this index, if not 0
+  std::atomic<unsigned> updateID{1};
+  std::atomic<unsigned> active{0};
+  std::atomic<unsigned> maxActive{0};
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool held = false;
+
+  void Hold(bool hold)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    held = hold;
+    condition.notify_all();
+  }
+
+  SOAPStub::Reply operator()(const SOAPStub::Request& request)
+  {
+    if (request.action != "Browse")
+      return SOAPStub::Fault(401);
+    unsigned index = SOAPStub::TagValue(request.body, "StartingIndex");
+    unsigned count = SOAPStub::TagValue(request.body, "RequestedCount");
+    if (index > 0)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      // bounded, so a failed test doesn't hang
+      condition.wait_for(lock, std::chrono::seconds(5), [&]{ return !held; });
+    }
+    unsigned n = ++active;
+    unsigned m = maxActive;
+    while (n > m && !maxActive.compare_exchange_weak(m, n));
+    if (changeIndex && index == changeIndex)
+      updateID = 2;
+    if ((index / BROWSE_COUNT) % 2 == 1)
+      std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    if (shortIndex && index == shortIndex)
+      count = shortCount;
+    SOAPStub::Reply reply = SOAPStub::BrowseResponse(index, count, total, updateID);
+    --active;
+    return reply;
+  }
+};
+
+static bool inOrder(const std::vector<DigitalItemPtr>& items, unsigned total)
+{
+  if (items.size() != total)
+    return false;
+  for (unsigned i = 0; i < total; ++i)
+  {
+    if (items[i]->GetValue("dc:title") != "Track " + std::to_string(i))
+      return false;
+  }
+  return true;
+}
+
+static std::vector<DigitalItemPtr> load(ContentList& list)
+{
+  std::vector<DigitalItemPtr> items;
+  for (ContentList::iterator it = list.begin(); it != list.end(); ++it)
+    items.push_back(*it);
+  return items;
+}
+
+static unsigned requested(SOAPStub& stub, unsigned index)
+{
+  std::string tag = "<StartingIndex>" + std::to_string(index) + "</StartingIndex>";
+  unsigned n = 0;
+  for (const SOAPStub::Request& request : stub.GetRequests())
+  {
+    if (request.body.find(tag) != std::string::npos)
+      ++n;
+  }
+  return n;
+}
+
+TEST_CASE("Load all the items in order")
+{
+  MediaServer server;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+
+  std::vector<DigitalItemPtr> items;
+  unsigned updateID = 0;
+  REQUIRE( service.BrowseAll("A:TRACKS", items, 4, &updateID) );
+  REQUIRE( inOrder(items, server.total) );
+  REQUIRE( updateID == 1 );
+  // the concurrency is clamped to the limit of the asynchronous client
+  REQUIRE( server.maxActive <= WSAsyncClient::Instance().GetHostConcurrency() );
+
+  WSAsyncClient::Instance().SetHostConcurrency(1);
+  REQUIRE( WSAsyncClient::Instance().GetHostConcurrency() == 1 );
+  server.maxActive = 0;
+  REQUIRE( service.BrowseAll("A:TRACKS", items, 4) );
+  REQUIRE( inOrder(items, server.total) );
+  REQUIRE( server.maxActive == 1 );
+  WSAsyncClient::Instance().SetHostConcurrency(WSASYNC_HOST_CONCURRENCY);
+}
+
+TEST_CASE("Refill the gap left by a short chunk")
+{
+  MediaServer server;
+  server.shortIndex = 100;
+  server.shortCount = 60;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+
+  std::vector<DigitalItemPtr> items;
+  REQUIRE( service.BrowseAll("A:TRACKS", items, 2) );
+  REQUIRE( inOrder(items, server.total) );
+  // the missing items are requested alone
+  REQUIRE( requested(stub, 160) == 1 );
+}
+
+TEST_CASE("Restart when the content changes while loading")
+{
+  MediaServer server;
+  server.changeIndex = 200;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+
+  std::vector<DigitalItemPtr> items;
+  unsigned updateID = 0;
+  REQUIRE( service.BrowseAll("A:TRACKS", items, 2, &updateID) );
+  REQUIRE( inOrder(items, server.total) );
+  REQUIRE( updateID == 2 );
+  REQUIRE( requested(stub, 0) == 2 );
+}
+
+TEST_CASE("Browse the list with lookahead")
+{
+  MediaServer server;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+
+  ContentList plain(service, "A:TRACKS", 30);
+  REQUIRE( !plain.failure() );
+  std::vector<DigitalItemPtr> items = load(plain);
+  REQUIRE( !plain.failure() );
+  REQUIRE( inOrder(items, server.total) );
+
+  // the chunks in advance give the same items
+  ContentList list(service, "A:TRACKS", 30, 3);
+  REQUIRE( list.size() == server.total );
+  items = load(list);
+  REQUIRE( !list.failure() );
+  REQUIRE( inOrder(items, server.total) );
+  REQUIRE( list.GetUpdateID() == plain.GetUpdateID() );
+}
+
+TEST_CASE("Restart the lookahead after a short chunk")
+{
+  MediaServer server;
+  server.shortIndex = 30;
+  server.shortCount = 10;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+
+  ContentList list(service, "A:TRACKS", 30, 2);
+  std::vector<DigitalItemPtr> items = load(list);
+  REQUIRE( !list.failure() );
+  REQUIRE( inOrder(items, server.total) );
+  // the chunks in advance were misaligned, so the next one is browsed
+  // from the short end
+  REQUIRE( requested(stub, 40) == 1 );
+}
+
+TEST_CASE("Cancel the lookahead when the list is destroyed")
+{
+  MediaServer server;
+  SOAPStub stub(std::ref(server));
+  REQUIRE( stub.IsValid() );
+  ContentDirectory service("127.0.0.1", stub.GetPort());
+  WSAsyncClient& client = WSAsyncClient::Instance();
+  client.SetHostConcurrency(1);
+
+  server.Hold(true);
+  ContentList * list = new ContentList(service, "A:TRACKS", 30, 4);
+  REQUIRE( list->size() == server.total );
+  // the first chunk in advance is held by the server, the others are queued
+  REQUIRE( stub.WaitRequests(2, 5000) );
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  delete list;
+  REQUIRE( std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000) );
+  server.Hold(false);
+  for (int i = 0; i < 50 && client.GetPendingCount() > 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE( client.GetPendingCount() == 0 );
+  // the queued chunks were dropped without being sent
+  REQUIRE( stub.GetRequests().size() == 2 );
+  REQUIRE( requested(stub, 30) == 1 );
+  client.SetHostConcurrency(WSASYNC_HOST_CONCURRENCY);
+}
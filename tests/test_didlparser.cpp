@@ -0,0 +1,87 @@
+#include <string>
+
+#include <test.h>
+
+#include <noson/didlparser.h>
+
+using namespace NSROOT;
+
+static const char * g_tracks =
+  "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+  " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
+  "<item id=\"S://server/music/Caf%c3%a9.flac\" parentID=\"A:TRACKS\" restricted=\"true\">"
+  "<res protocolInfo=\"x-file-cifs:*:audio/flac:*\" duration=\"0:03:45\">x-file-cifs://server/music/Caf%c3%a9.flac</res>"
+  "<upnp:albumArtURI>/getaa?u=x-file-cifs%3a%2f%2fserver%2fmusic%2fCaf%25c3%25a9.flac&amp;v=432</upnp:albumArtURI>"
+  "<dc:title>Caf&#233; &amp; &#x43;o</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>  Artist  </dc:creator><upnp:album><![CDATA[Album <1>]]></upnp:album>"
+  "<upnp:originalTrackNumber>1</upnp:originalTrackNumber></item>"
+  "<container id=\"A:ALBUM/Album\" parentID=\"A:ALBUM\"><dc:title>Album</dc:title>"
+  "<upnp:class>object.container.album.musicAlbum</upnp:class><dc:creator/><upnp:genre>   </upnp:genre>"
+  "<upnp:albumArtURI>first<x>nested</x>last</upnp:albumArtURI></container>"
+  "<desc id=\"cdudn\">RINCON_AssociatedZPUDN</desc>"
+  "</DIDL-Lite>";
+
+static const char * g_favorites =
+  "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+  " xmlns:rinc=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
+  "<item id=\"FV:2/13\" parentID=\"FV:2\" restricted=\"false\"><dc:title>Radio</dc:title>"
+  "<upnp:class>object.itemobject.item.sonos-favorite</upnp:class><rinc:ordinal>1</rinc:ordinal>"
+  "<res protocolInfo=\"x-rincon-mp3radio:*:*:*\">x-rincon-mp3radio://radio.example.com/stream</res>"
+  "<rinc:type>instantPlay</rinc:type><rinc:description>TuneIn Station</rinc:description>"
+  "<rinc:resMD>&lt;DIDL-Lite xmlns:dc=&quot;http://purl.org/dc/elements/1.1/&quot;&gt;&lt;item id=&quot;F00092020s17492&quot;"
+  " parentID=&quot;L&quot; restricted=&quot;true&quot;&gt;&lt;dc:title&gt;Radio&lt;/dc:title&gt;&lt;/item&gt;&lt;/DIDL-Lite&gt;</rinc:resMD>"
+  "<other:tag xmlns:other=\"urn:other\">undeclared</other:tag></item>"
+  "</DIDL-Lite>";
+
+static void compare(const char * document)
+{
+  DIDLParser dom(document, 0, false);
+  DIDLParser stream(document);
+  REQUIRE( dom.IsValid() );
+  REQUIRE( stream.IsValid() );
+  REQUIRE( stream.GetItems().size() == dom.GetItems().size() );
+  for (size_t i = 0; i < dom.GetItems().size(); ++i)
+  {
+    const DigitalItemPtr& a = dom.GetItems()[i];
+    const DigitalItemPtr& b = stream.GetItems()[i];
+    REQUIRE( b->GetObjectID() == a->GetObjectID() );
+    REQUIRE( b->GetParentID() == a->GetParentID() );
+    REQUIRE( b->GetRestricted() == a->GetRestricted() );
+    REQUIRE( b->IsContainer() == a->IsContainer() );
+    REQUIRE( b->subType() == a->subType() );
+    REQUIRE( b->DIDL() == a->DIDL() );
+  }
+}
+
+TEST_CASE("Stream the same items as the DOM")
+{
+  compare(g_tracks);
+  compare(g_favorites);
+  compare("<DIDL-Lite xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\"></DIDL-Lite>");
+
+  DIDLParser didl(g_tracks);
+  REQUIRE( didl.GetItems().size() == 2 );
+  const DigitalItemPtr& track = didl.GetItems()[0];
+  REQUIRE( track->GetValue("dc:title") == "Caf\xC3\xA9 & Co" );
+  REQUIRE( track->GetValue("dc:creator") == "  Artist  " );
+  REQUIRE( track->GetValue("upnp:album") == "Album <1>" );
+  REQUIRE( track->GetProperty("res")->GetAttribut("duration") == "0:03:45" );
+  const DigitalItemPtr& album = didl.GetItems()[1];
+  REQUIRE( !album->GetRestricted() );
+  REQUIRE( !album->GetProperty("dc:creator") );
+  REQUIRE( !album->GetProperty("upnp:genre") );
+  REQUIRE( album->GetValue("upnp:albumArtURI") == "first" );
+
+  DIDLParser favorites(g_favorites);
+  REQUIRE( favorites.GetItems()[0]->GetValue("r:ordinal") == "1" );
+  REQUIRE( favorites.GetItems()[0]->GetValue("r:resMD").compare(0, 10, "<DIDL-Lite") == 0 );
+}
+
+TEST_CASE("Reject an invalid DIDL document")
+{
+  REQUIRE( !DIDLParser("<root><item id=\"1\"><dc:title>x</dc:title></item></root>").IsValid() );
+  REQUIRE( !DIDLParser("<DIDL-Lite><item id=\"1\"><dc:title>x</item></DIDL-Lite>").IsValid() );
+  REQUIRE( !DIDLParser("<DIDL-Lite><item id=\"1\">").IsValid() );
+  REQUIRE( !DIDLParser("").IsValid() );
+  REQUIRE( DIDLParser("").GetItems().empty() );
+}
@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <test.h>
+
+#include <noson/digitalsnapshot.h>
+#include <noson/didlparser.h>
+
+using namespace NSROOT;
+
+static const char * g_didl =
+  "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+  " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
+  "<container id=\"A:ALBUM/Album\" parentID=\"A:ALBUM\" restricted=\"true\"><dc:title>Album</dc:title>"
+  "<upnp:class>object.container.album.musicAlbum</upnp:class></container>"
+  "<item id=\"S://server/music/1.flac\" parentID=\"A:TRACKS\" restricted=\"false\">"
+  "<res protocolInfo=\"x-file-cifs:*:audio/flac:*\" duration=\"0:03:45\">x-file-cifs://server/music/1.flac</res>"
+  "<dc:title>Caf\xC3\xA9 &amp; Co</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>Artist</dc:creator><upnp:album>Album</upnp:album></item>"
+  "<item id=\"S://server/music/2.flac\" parentID=\"A:TRACKS\" restricted=\"true\">"
+  "<dc:title>Second</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>Artist</dc:creator><upnp:album>Album</upnp:album></item>"
+  "</DIDL-Lite>";
+
+TEST_CASE("Write and view a snapshot")
+{
+  DIDLParser didl(g_didl);
+  REQUIRE( didl.IsValid() );
+  DigitalSnapshot::Writer writer;
+  writer.Add(didl.GetItems());
+  REQUIRE( writer.size() == 3 );
+  REQUIRE( writer.Save("test_digitalsnapshot.dat") );
+
+  DigitalSnapshot snapshot;
+  REQUIRE( snapshot.Open("test_digitalsnapshot.dat") );
+  REQUIRE( snapshot.size() == 3 );
+  REQUIRE( snapshot[0].IsContainer() );
+  REQUIRE( strcmp(snapshot[0].GetObjectID(), "A:ALBUM/Album") == 0 );
+  REQUIRE( snapshot[0].GetRestricted() );
+  DigitalSnapshot::ItemView track = snapshot[1];
+  REQUIRE( track.IsItem() );
+  REQUIRE( !track.GetRestricted() );
+  REQUIRE( strcmp(track.GetParentID(), "A:TRACKS") == 0 );
+  REQUIRE( track.GetPropertyCount() == 5 );
+  REQUIRE( strcmp(track.GetPropertyKey(0), "res") == 0 );
+  REQUIRE( strcmp(track.GetValue("dc:title"), "Caf\xC3\xA9 & Co") == 0 );
+  REQUIRE( strcmp(track.GetValue("upnp:genre"), "") == 0 );
+  REQUIRE( strcmp(track.GetAttribut("res", "duration"), "0:03:45") == 0 );
+  REQUIRE( strcmp(track.GetAttribut("res", "size"), "") == 0 );
+  // the repeated strings are shared
+  REQUIRE( snapshot[2].GetValue("dc:creator") == track.GetValue("dc:creator") );
+
+  unsigned count = 0;
+  for (DigitalSnapshot::iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+  {
+    DigitalItemPtr item = (*it).ToDigitalItem();
+    REQUIRE( item->DIDL() == didl.GetItems()[count]->DIDL() );
+    REQUIRE( item->subType() == didl.GetItems()[count]->subType() );
+    ++count;
+  }
+  REQUIRE( count == 3 );
+
+  // replace the file while it is mapped
+  DigitalSnapshot::Writer other;
+  other.Add(*didl.GetItems()[0]);
+  REQUIRE( other.Save("test_digitalsnapshot.dat") );
+  REQUIRE( strcmp(snapshot[2].GetValue("dc:title"), "Second") == 0 );
+  DigitalSnapshot replaced;
+  REQUIRE( replaced.Open("test_digitalsnapshot.dat") );
+  REQUIRE( replaced.size() == 1 );
+
+  snapshot.Close();
+  REQUIRE( !snapshot.IsOpen() );
+  remove("test_digitalsnapshot.dat");
+}
+
+TEST_CASE("Reject an invalid snapshot")
+{
+  DIDLParser didl(g_didl);
+  DigitalSnapshot::Writer writer;
+  writer.Add(didl.GetItems());
+  REQUIRE( writer.Save("test_digitalsnapshot.dat") );
+  std::string data;
+  FILE * file = fopen("test_digitalsnapshot.dat", "rb");
+  REQUIRE( file != nullptr );
+  char buf[4096];
+  size_t r;
+  while ((r = fread(buf, 1, sizeof(buf), file)) > 0)
+    data.append(buf, r);
+  fclose(file);
+
+  DigitalSnapshot snapshot;
+  // truncated
+  file = fopen("test_digitalsnapshot.dat", "wb");
+  fwrite(data.data(), 1, data.size() - 1, file);
+  fclose(file);
+  REQUIRE( !snapshot.Open("test_digitalsnapshot.dat") );
+  // a reference out of the string table
+  std::string bad(data);
+  uint32_t offset = 0xffff;
+  memcpy(&bad[sizeof(DigitalSnapshot::Header)], &offset, sizeof(offset));
+  file = fopen("test_digitalsnapshot.dat", "wb");
+  fwrite(bad.data(), 1, bad.size(), file);
+  fclose(file);
+  REQUIRE( !snapshot.Open("test_digitalsnapshot.dat") );
+  REQUIRE( !snapshot.IsOpen() );
+  remove("test_digitalsnapshot.dat");
+  REQUIRE( !snapshot.Open("test_digitalsnapshot.dat") );
+}
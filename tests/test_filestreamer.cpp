@@ -0,0 +1,215 @@
+#if (defined(_WIN32) || defined(_WIN64))
+#define __WINDOWS__
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifndef __WINDOWS__
+#include <strings.h>
+#endif
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <noson/filestreamer.h>
+#include <private/socket.h>
+#include <private/wsrequestbroker.h>
+#include <private/wsresponse.h>
+
+#ifdef __WINDOWS__
+#define strncasecmp _strnicmp
+#endif
+
+using namespace NSROOT;
+
+#define TRACK_PATH  "test_filestreamer.flac"
+#define TRACK_SIZE  (2621440 + 123) // more than two slices of 1 MB
+
+/**
+ * A track with a FLAC signature, followed by a pattern that makes any
+ * misplaced byte visible.
+ */
+static std::string makeTrack()
+{
+  std::string data("fLaC");
+  data.reserve(TRACK_SIZE);
+  for (size_t i = data.size(); i < TRACK_SIZE; ++i)
+    data.push_back((char)((i * 7 + i / 251) & 0xff));
+  FILE * file = fopen(TRACK_PATH, "wb");
+  if (file)
+  {
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+  }
+  return data;
+}
+
+struct Response
+{
+  int status = 0;
+  std::vector<std::string> headers;
+  std::string content;
+
+  std::string Header(const char * name) const
+  {
+    size_t n = strlen(name);
+    for (const std::string& h : headers)
+    {
+      if (h.size() > n && h[n] == ':' && strncasecmp(h.c_str(), name, n) == 0)
+        return h.substr(h.find_first_not_of(' ', n + 1));
+    }
+    return std::string();
+  }
+};
+
+/**
+ * Serve the request with the streamer on a loopback connection, and read
+ * the response until the connection is closed.
+ */
+static bool get(FileStreamer& streamer, const std::string& range, Response& response)
+{
+  TcpServerSocket server;
+  unsigned port = BindFreePort(server);
+  if (port == 0 || !server.ListenConnection())
+    return false;
+  TcpSocket client;
+  if (!client.Connect("127.0.0.1", port, 0))
+    return false;
+  TcpSocket sock;
+  if (server.AcceptConnection(sock, 5) != TcpServerSocket::ACCEPT_SUCCESS)
+    return false;
+
+  std::string request("GET " FILESTREAMER_URI ".flac?" FILESTREAMER_PARAM_PATH "=" TRACK_PATH " HTTP/1.1\r\n");
+  request.append("Host: 127.0.0.1\r\nConnection: close\r\n");
+  if (!range.empty())
+    request.append("Range: ").append(range).append("\r\n");
+  request.append("\r\n");
+  if (!client.SendData(request.c_str(), request.size()))
+    return false;
+
+  bool handled = false;
+  std::thread serve([&]{
+    WSRequestBroker broker(&sock, false, 5);
+    RequestBroker::handle handle = { nullptr, &broker };
+    handled = (broker.IsParsed() && streamer.HandleRequest(&handle));
+    sock.Disconnect();
+  });
+
+  std::string line;
+  size_t len;
+  if (WSResponse::ReadHeaderLine(&client, "\r\n", line, &len) && line.size() > 9)
+    response.status = atoi(line.c_str() + 9);
+  while (WSResponse::ReadHeaderLine(&client, "\r\n", line, &len) && len > 0)
+    response.headers.push_back(line);
+  char buf[16384];
+  size_t r;
+  while ((r = client.ReceiveData(buf, sizeof(buf))) > 0)
+    response.content.append(buf, r);
+  serve.join();
+  return handled;
+}
+
+TEST_CASE("Send a region of file")
+{
+  std::string track = makeTrack();
+  FILE * file = fopen(TRACK_PATH, "rb");
+  REQUIRE( file != nullptr );
+
+  TcpServerSocket server;
+  unsigned port = BindFreePort(server);
+  REQUIRE( port != 0 );
+  REQUIRE( server.ListenConnection() );
+  TcpSocket client;
+  REQUIRE( client.Connect("127.0.0.1", port, 0) );
+  TcpSocket sock;
+  REQUIRE( server.AcceptConnection(sock, 5) == TcpServerSocket::ACCEPT_SUCCESS );
+
+  const uint64_t offset = 1000001;
+  const size_t size = 1500000;
+  bool sent = false;
+  std::thread send([&]{
+    sent = sock.SendFile(file, offset, size);
+    sock.Disconnect();
+  });
+  std::string data;
+  char buf[16384];
+  size_t r;
+  while ((r = client.ReceiveData(buf, sizeof(buf))) > 0)
+    data.append(buf, r);
+  send.join();
+  fclose(file);
+  REQUIRE( sent );
+  REQUIRE( data.size() == size );
+  REQUIRE( data == track.substr(offset, size) );
+  remove(TRACK_PATH);
+}
+
+TEST_CASE("Stream the whole file")
+{
+  std::string track = makeTrack();
+  FileStreamer streamer;
+  Response response;
+  REQUIRE( get(streamer, "", response) );
+  REQUIRE( response.status == 200 );
+  REQUIRE( response.Header("Content-Length") == std::to_string(TRACK_SIZE) );
+  REQUIRE( response.content.size() == TRACK_SIZE );
+  REQUIRE( response.content == track );
+  remove(TRACK_PATH);
+}
+
+TEST_CASE("Stream a single range")
+{
+  std::string track = makeTrack();
+  FileStreamer streamer;
+  Response response;
+  REQUIRE( get(streamer, "bytes=1000-1500999", response) );
+  REQUIRE( response.status == 206 );
+  REQUIRE( response.Header("Content-Range") == "bytes 1000-1500999/" + std::to_string(TRACK_SIZE) );
+  REQUIRE( response.Header("Content-Length") == "1500000" );
+  REQUIRE( response.content.size() == 1500000 );
+  REQUIRE( response.content == track.substr(1000, 1500000) );
+  remove(TRACK_PATH);
+}
+
+TEST_CASE("Stream multiple ranges")
+{
+  std::string track = makeTrack();
+  FileStreamer streamer;
+  Response response;
+  REQUIRE( get(streamer, "bytes=0-99,1048000-2200000,-500", response) );
+  REQUIRE( response.status == 206 );
+  std::string type = response.Header("Content-Type");
+  REQUIRE( type.compare(0, 31, "multipart/byteranges; boundary=") == 0 );
+  std::string boundary = type.substr(31);
+  // the announced length is the exact length of the body
+  REQUIRE( response.Header("Content-Length") == std::to_string(response.content.size()) );
+
+  struct { size_t start, end; } ranges[] = {
+    { 0, 99 }, { 1048000, 2200000 }, { TRACK_SIZE - 500, TRACK_SIZE - 1 },
+  };
+  const std::string& body = response.content;
+  size_t p = 0;
+  for (const auto& rg : ranges)
+  {
+    std::string delimiter = "--" + boundary + "\r\n";
+    REQUIRE( body.compare(p, delimiter.size(), delimiter) == 0 );
+    size_t e = body.find("\r\n\r\n", p);
+    REQUIRE( e != std::string::npos );
+    std::string headers = body.substr(p, e - p);
+    std::string crg = "bytes " + std::to_string(rg.start) + "-" + std::to_string(rg.end) + "/" + std::to_string(TRACK_SIZE);
+    REQUIRE( headers.find(crg) != std::string::npos );
+    p = e + 4;
+    size_t len = rg.end - rg.start + 1;
+    REQUIRE( body.compare(p, len, track, rg.start, len) == 0 );
+    p += len;
+    REQUIRE( body.compare(p, 2, "\r\n") == 0 );
+    p += 2;
+  }
+  REQUIRE( body.substr(p) == "--" + boundary + "--\r\n" );
+  remove(TRACK_PATH);
+}
@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <dirent.h>
+
+#include <test.h>
+
+#include <noson/librarycache.h>
+#include <noson/didlparser.h>
+#include <noson/sonostypes.h>
+
+using namespace NSROOT;
+
+static const char * g_didl =
+  "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\""
+  " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
+  "<container id=\"A:ALBUM/Album\" parentID=\"A:ALBUM\" restricted=\"true\"><dc:title>Album</dc:title>"
+  "<upnp:class>object.container.album.musicAlbum</upnp:class></container>"
+  "<item id=\"S://server/music/1.flac\" parentID=\"A:TRACKS\" restricted=\"false\">"
+  "<res protocolInfo=\"x-file-cifs:*:audio/flac:*\" duration=\"0:03:45\">x-file-cifs://server/music/1.flac</res>"
+  "<dc:title>Caf\xC3\xA9 &amp; Co</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class>"
+  "<dc:creator>Artist</dc:creator><upnp:originalTrackNumber>1</upnp:originalTrackNumber></item>"
+  "</DIDL-Lite>";
+
+TEST_CASE("Compute the update token of a container")
+{
+  ContentProperty prop;
+  REQUIRE( LibraryCache::UpdateToken(prop, "A:TRACKS").empty() );
+  prop.ContainerUpdateIDs.emplace_back("S:", 3);
+  prop.ContainerUpdateIDs.emplace_back("A:", 12);
+  prop.SavedQueuesUpdateID = "RINCON_1,10";
+  REQUIRE( LibraryCache::UpdateToken(prop, "A:TRACKS") == "A:,12" );
+  REQUIRE( LibraryCache::UpdateToken(prop, "A:ALBUMARTIST/Artist") == "A:,12" );
+  REQUIRE( LibraryCache::UpdateToken(prop, "S://server/music") == "S:,3" );
+  REQUIRE( LibraryCache::UpdateToken(prop, "SQ:") == "SQ,RINCON_1,10" );
+  REQUIRE( LibraryCache::UpdateToken(prop, "FV:2").empty() );
+  REQUIRE( LibraryCache::UpdateToken(prop, "Q:0").empty() );
+  prop.ShareIndexInProgress = true;
+  REQUIRE( LibraryCache::UpdateToken(prop, "A:TRACKS").empty() );
+}
+
+TEST_CASE("Store and load a container")
+{
+  DIDLParser didl(g_didl);
+  REQUIRE( didl.IsValid() );
+  REQUIRE( didl.GetItems().size() == 2 );
+
+  LibraryCache cache(".", "Sonos_1234");
+  cache.Erase("A:TRACKS");
+  DigitalItemList items;
+  REQUIRE( !cache.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( !cache.Store("A:TRACKS", "", didl.GetItems()) );
+  REQUIRE( cache.Store("A:TRACKS", "A:,12", didl.GetItems()) );
+  REQUIRE( cache.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( cache.GetHitCount() == 1 );
+  REQUIRE( items.size() == 2 );
+
+  REQUIRE( items[0]->IsContainer() );
+  REQUIRE( items[0]->subType() == DigitalItem::SubType_album );
+  REQUIRE( items[0]->GetObjectID() == "A:ALBUM/Album" );
+  REQUIRE( items[0]->GetRestricted() );
+  REQUIRE( items[1]->IsItem() );
+  REQUIRE( items[1]->GetParentID() == "A:TRACKS" );
+  REQUIRE( !items[1]->GetRestricted() );
+  REQUIRE( items[1]->GetValue("dc:title") == "Caf\xC3\xA9 & Co" );
+  REQUIRE( items[1]->GetProperty("res")->GetAttribut("duration") == "0:03:45" );
+  REQUIRE( items[1]->DIDL() == didl.GetItems()[1]->DIDL() );
+
+  // the content of another household isn't seen
+  LibraryCache other(".", "Sonos_5678");
+  REQUIRE( !other.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( cache.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( items.size() == 2 );
+
+  // another container isn't confused with this one
+  REQUIRE( !cache.Load("A:ALBUM", "A:,12", items) );
+  // the content changed: the file is dropped
+  REQUIRE( !cache.Load("A:TRACKS", "A:,13", items) );
+  REQUIRE( items.empty() );
+  REQUIRE( !cache.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( cache.GetMissCount() == 4 );
+  REQUIRE( cache.GetHitCount() == 2 );
+}
+
+/**
+ * @return the path of the cache file holding the text, else empty
+ */
+static std::string findCacheFile(const std::string& text)
+{
+  std::string found;
+  DIR * dir = opendir(".");
+  struct dirent * entry;
+  while (dir && found.empty() && (entry = readdir(dir)))
+  {
+    if (strncmp(entry->d_name, "library-", 8) != 0)
+      continue;
+    FILE * file = fopen(entry->d_name, "rb");
+    char buf[256];
+    size_t r = (file ? fread(buf, 1, sizeof(buf), file) : 0);
+    if (file)
+      fclose(file);
+    if (std::string(buf, r).find(text) != std::string::npos)
+      found.assign(entry->d_name);
+  }
+  if (dir)
+    closedir(dir);
+  return found;
+}
+
+TEST_CASE("Drop a corrupted container")
+{
+  DIDLParser didl(g_didl);
+  LibraryCache cache(".", "Sonos_corrupted");
+  REQUIRE( cache.Store("A:TRACKS", "A:,12", didl.GetItems()) );
+  std::string path = findCacheFile("Sonos_corrupted");
+  REQUIRE( !path.empty() );
+
+  // overwrite the count of items, which follows the token
+  FILE * file = fopen(path.c_str(), "r+b");
+  REQUIRE( file );
+  char buf[256];
+  size_t r = fread(buf, 1, sizeof(buf), file);
+  size_t pos = std::string(buf, r).find("A:,12") + 5;
+  fseek(file, (long)pos, SEEK_SET);
+  fwrite("\xff\xff\xff\xff", 1, 4, file);
+  fclose(file);
+
+  DigitalItemList items;
+  REQUIRE( !cache.Load("A:TRACKS", "A:,12", items) );
+  REQUIRE( items.empty() );
+  // the file has been removed
+  REQUIRE( findCacheFile("Sonos_corrupted").empty() );
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <test.h>
+
+#include <private/notifyparser.h>
+#include <noson/eventhandler.h>
+
+using namespace NSROOT;
+
+static bool parse(const std::string& body, std::vector<std::string>& subject, size_t chunk)
+{
+  NotifyParser parser(subject);
+  for (size_t p = 0; p < body.size(); p += chunk)
+  {
+    if (!parser.Feed(body.data() + p, std::min(chunk, body.size() - p)))
+      return false;
+  }
+  return parser.Finish();
+}
+
+static std::string join(const std::vector<std::string>& subject)
+{
+  std::string str;
+  for (const std::string& s : subject)
+    str.append(str.empty() ? "" : "|").append(s);
+  return str;
+}
+
+static const char * g_rcs =
+  "<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\"><e:property>"
+  "<LastChange>&lt;Event xmlns=&quot;urn:schemas-upnp-org:metadata-1-0/RCS/&quot;&gt;"
+  "&lt;InstanceID val=&quot;0&quot;&gt;"
+  "&lt;Volume channel=&quot;Master&quot; val=&quot;12&quot;/&gt;"
+  "&lt;Mute channel=&quot;Master&quot; val=&quot;0&quot;/&gt;"
+  "&lt;OutputFixed val=&quot;0&quot;/&gt;"
+  "&lt;/InstanceID&gt;&lt;/Event&gt;</LastChange>"
+  "</e:property></e:propertyset>";
+
+static const char * g_avt =
+  "<?xml version=\"1.0\"?>\r\n"
+  "<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\"><e:property>"
+  "<LastChange><![CDATA[<Event xmlns=\"urn:schemas-upnp-org:metadata-1-0/AVT/\""
+  " xmlns:r=\"urn:schemas-rinconnetworks-com:metadata-1-0/\">"
+  "<InstanceID val=\"0\"><TransportState val=\"PLAYING\"/>"
+  "<CurrentTrackMetaData val=\"&lt;DIDL-Lite&gt;&amp;amp;&lt;/DIDL-Lite&gt;\"/>"
+  "<r:NextTrackURI val='x-file:&#233;t&#xE9;'/><r:Empty/>"
+  "</InstanceID></Event>]]></LastChange>"
+  "</e:property></e:propertyset>";
+
+static const char * g_property =
+  "<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\">\n"
+  "  <e:property><ZoneGroupName>Living &amp; Kitchen</ZoneGroupName></e:property>\n"
+  "  <e:property><e:ZoneGroupID>\n  </e:ZoneGroupID></e:property>\n"
+  "  <!-- comment -->\n"
+  "  <e:property><ZoneGroupState>&lt;ZoneGroups/&gt;<x/>tail</ZoneGroupState></e:property>\n"
+  "</e:propertyset>\n";
+
+TEST_CASE("Decode LastChange of RCS")
+{
+  for (size_t chunk : { (size_t)1, (size_t)7, (size_t)4096 })
+  {
+    std::vector<std::string> subject;
+    REQUIRE( parse(g_rcs, subject, chunk) );
+    REQUIRE( join(subject) == "RCS|Volume/Master|12|Mute/Master|0|OutputFixed|0" );
+  }
+}
+
+TEST_CASE("Decode LastChange of AVT")
+{
+  for (size_t chunk : { (size_t)1, (size_t)5, (size_t)4096 })
+  {
+    std::vector<std::string> subject;
+    REQUIRE( parse(g_avt, subject, chunk) );
+    REQUIRE( join(subject) == "AVT|TransportState|PLAYING|CurrentTrackMetaData|<DIDL-Lite>&amp;</DIDL-Lite>"
+                              "|r:NextTrackURI|x-file:\xC3\xA9t\xC3\xA9|r:Empty|" );
+  }
+}
+
+TEST_CASE("Decode property set")
+{
+  for (size_t chunk : { (size_t)1, (size_t)3, (size_t)4096 })
+  {
+    std::vector<std::string> subject;
+    REQUIRE( parse(g_property, subject, chunk) );
+    REQUIRE( join(subject) == "PROPERTY|ZoneGroupName|Living & Kitchen|ZoneGroupID||ZoneGroupState|<ZoneGroups/>" );
+  }
+}
+
+TEST_CASE("Reject invalid content")
+{
+  std::vector<std::string> subject;
+  // not a property set
+  REQUIRE( !parse("<root><property/></root>", subject, 4096) );
+  // mismatched tag
+  REQUIRE( !parse("<e:propertyset><e:property></e:propertyset>", subject, 4096) );
+  // truncated
+  REQUIRE( !parse("<e:propertyset><e:property>", subject, 4096) );
+  // invalid embedded document
+  REQUIRE( !parse("<e:propertyset><e:property><LastChange>&lt;Event&gt;</LastChange></e:property></e:propertyset>", subject, 4096) );
+  REQUIRE( !parse("<e:propertyset><e:property><LastChange></LastChange></e:property></e:propertyset>", subject, 4096) );
+}
+
+TEST_CASE("Unknown LastChange is not supported")
+{
+  std::vector<std::string> subject;
+  NotifyParser parser(subject);
+  std::string body("<e:propertyset><e:property><LastChange>&lt;Event xmlns=&quot;urn:other&quot;&gt;"
+                   "&lt;InstanceID val=&quot;0&quot;/&gt;&lt;/Event&gt;</LastChange></e:property></e:propertyset>");
+  REQUIRE( parser.Feed(body.data(), body.size()) );
+  REQUIRE( parser.Finish() );
+  REQUIRE( !parser.IsSupported() );
+  REQUIRE( subject.empty() );
+}
+
+TEST_CASE("Index the variables of a property change")
+{
+  EventMessage msg;
+  msg.event = EVENT_UPNP_PROPCHANGE;
+  msg.subject.push_back("uuid:RINCON_1");
+  msg.subject.push_back("42");
+  REQUIRE( parse(g_rcs, msg.subject, 4096) );
+  msg.Index();
+  REQUIRE( msg.kind == PROPCHANGE_RCS );
+  REQUIRE( msg.seq == 42 );
+  REQUIRE( msg.vars.size() == 3 );
+  REQUIRE( msg.vars[0].key == EVENT_VAR_Volume_Master );
+  REQUIRE( msg.Value(msg.vars[0]) == "12" );
+  REQUIRE( msg.vars[1].key == EVENT_VAR_Mute_Master );
+  REQUIRE( msg.vars[2].key == EVENT_VAR_OutputFixed );
+  REQUIRE( msg.Name(msg.vars[2]) == "OutputFixed" );
+
+  REQUIRE( EventMessage::InternName("r:NextTrackURI") == EVENT_VAR_r_NextTrackURI );
+  REQUIRE( EventMessage::InternName("ZoneGroupState") == EVENT_VAR_ZoneGroupState );
+  REQUIRE( EventMessage::InternName("Unknown") == EVENT_VAR_UNKNOWN );
+}
+
+static EventMessage update(const char * sid, const char * seq, const char * kind, const std::vector<std::string>& vars)
+{
+  EventMessage msg;
+  msg.event = EVENT_UPNP_PROPCHANGE;
+  msg.subject.push_back(sid);
+  msg.subject.push_back(seq);
+  msg.subject.push_back(kind);
+  msg.subject.insert(msg.subject.end(), vars.begin(), vars.end());
+  msg.Index();
+  return msg;
+}
+
+TEST_CASE("Coalesce the property changes")
+{
+  EventMessage prev = update("uuid:RINCON_1", "7", "RCS", { "Volume/Master", "12", "Mute/Master", "0", "Custom", "a" });
+  EventMessage next = update("uuid:RINCON_1", "8", "RCS", { "Custom", "b", "Bass", "2", "Volume/Master", "15" });
+  EventMessage * msg = EventMessage::Coalesce(prev, next);
+  REQUIRE( msg != nullptr );
+  // the last value wins, the variables keep their order of arrival
+  std::vector<std::string> subject = { "uuid:RINCON_1", "8", "RCS",
+                                       "Volume/Master", "15", "Mute/Master", "0", "Custom", "b", "Bass", "2" };
+  REQUIRE( msg->subject == subject );
+  REQUIRE( msg->kind == PROPCHANGE_RCS );
+  REQUIRE( msg->seq == 8 );
+  REQUIRE( msg->vars.size() == 4 );
+  REQUIRE( msg->vars[0].key == EVENT_VAR_Volume_Master );
+  REQUIRE( msg->vars[3].key == EVENT_VAR_Bass );
+  delete msg;
+
+  // an unknown variable is matched by its name
+  EventMessage other = update("uuid:RINCON_1", "8", "RCS", { "Other", "c" });
+  msg = EventMessage::Coalesce(prev, other);
+  REQUIRE( msg != nullptr );
+  REQUIRE( msg->subject.size() == 3 + 8 );
+  REQUIRE( msg->subject[8] == "a" );
+  REQUIRE( msg->subject[10] == "c" );
+  delete msg;
+}
+
+TEST_CASE("Do not coalesce unrelated property changes")
+{
+  EventMessage prev = update("uuid:RINCON_1", "7", "RCS", { "Volume/Master", "12" });
+  // the sequence goes back
+  REQUIRE( EventMessage::Coalesce(prev, update("uuid:RINCON_1", "6", "RCS", { "Volume/Master", "15" })) == nullptr );
+  // another subscription
+  REQUIRE( EventMessage::Coalesce(prev, update("uuid:RINCON_2", "8", "RCS", { "Volume/Master", "15" })) == nullptr );
+  // another kind
+  REQUIRE( EventMessage::Coalesce(prev, update("uuid:RINCON_1", "8", "AVT", { "TransportState", "PLAYING" })) == nullptr );
+  // the other properties are not merged
+  EventMessage prop = update("uuid:RINCON_1", "7", "PROPERTY", { "ZoneGroupState", "x" });
+  REQUIRE( EventMessage::Coalesce(prop, update("uuid:RINCON_1", "8", "PROPERTY", { "ZoneGroupState", "y" })) == nullptr );
+  // same sequence is allowed
+  EventMessage * msg = EventMessage::Coalesce(prev, update("uuid:RINCON_1", "7", "RCS", { "Volume/Master", "15" }));
+  REQUIRE( msg != nullptr );
+  delete msg;
+}
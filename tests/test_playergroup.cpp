@@ -0,0 +1,67 @@
+#include <string>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <noson/sonosplayer.h>
+
+using namespace NSROOT;
+
+/**
+ * A stand-in rendering control: it answers the actions, and fails GetTreble.
+ */
+static SOAPStub::Reply reply(const SOAPStub::Request& request)
+{
+  if (request.action == "GetVolume")
+    return SOAPStub::Response("RenderingControl", request.action, "<CurrentVolume>21</CurrentVolume>");
+  if (request.action == "GetBass")
+    return SOAPStub::Response("RenderingControl", request.action, "<CurrentBass>-2</CurrentBass>");
+  if (request.action == "GetTreble")
+    return SOAPStub::Fault(402);
+  return SOAPStub::Response("RenderingControl", request.action, "");
+}
+
+static bool received(SOAPStub& stub, const char * action, const char * arg)
+{
+  for (const SOAPStub::Request& request : stub.GetRequests())
+  {
+    if (request.body.find(action) != std::string::npos && (!arg || request.body.find(arg) != std::string::npos))
+      return true;
+  }
+  return false;
+}
+
+TEST_CASE("Control the rendering of the group")
+{
+  SOAPStub stub(reply);
+  REQUIRE( stub.IsValid() );
+
+  ZonePlayerPtr zp(new ZonePlayer("Living Room"));
+  zp->SetAttribut(ZP_UUID, "RINCON_000000000000001400");
+  zp->SetAttribut(ZP_LOCATION, "http://127.0.0.1:" + std::to_string(stub.GetPort()) + "/xml/device_description.xml");
+  Player player(zp);
+  REQUIRE( player.IsValid() );
+
+  GroupValues values;
+  REQUIRE( player.GetGroupVolume(values) );
+  REQUIRE( values.size() == 1 );
+  REQUIRE( values["RINCON_000000000000001400"] == 21 );
+  REQUIRE( received(stub, "<u:GetVolume ", "<Channel>Master</Channel>") );
+
+  values.clear();
+  REQUIRE( player.GetGroupBass(values) );
+  REQUIRE( values["RINCON_000000000000001400"] == -2 );
+  REQUIRE( !received(stub, "<u:GetBass ", "<Channel>") );
+
+  REQUIRE( player.SetGroupVolume(30) );
+  REQUIRE( received(stub, "<u:SetVolume ", "<DesiredVolume>30</DesiredVolume>") );
+  REQUIRE( player.SetGroupBass(-3) );
+  REQUIRE( received(stub, "<u:SetBass ", "<DesiredBass>-3</DesiredBass>") );
+  REQUIRE( !received(stub, "<u:SetBass ", "<Channel>") );
+
+  // a member failing fails the group call
+  values.clear();
+  REQUIRE( !player.GetGroupTreble(values) );
+  REQUIRE( values.empty() );
+}
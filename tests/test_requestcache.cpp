@@ -0,0 +1,104 @@
+#include <string>
+#include <thread>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <noson/avtransport.h>
+#include <private/requestcache.h>
+
+using namespace NSROOT;
+
+static ElementList response(const char * value)
+{
+  ElementList vars;
+  vars.push_back(ElementPtr(new Element("TAG", "GetZoneInfoResponse")));
+  vars.push_back(ElementPtr(new Element("SerialNumber", value)));
+  return vars;
+}
+
+TEST_CASE("Keep the response until invalidated")
+{
+  RequestCache& cache = RequestCache::Instance();
+  ElementList vars;
+  REQUIRE( !cache.Acquire("test1", "GetZoneInfo", vars) );
+  cache.Finish("test1", "GetZoneInfo", response("1"), 60000);
+  REQUIRE( cache.Acquire("test1", "GetZoneInfo", vars) );
+  REQUIRE( vars.GetValue("SerialNumber") == "1" );
+  // another scope
+  REQUIRE( !cache.Acquire("test2", "GetZoneInfo", vars) );
+  cache.Finish("test2", "GetZoneInfo", response("2"), 0);
+  REQUIRE( !cache.Acquire("test2", "GetZoneInfo", vars) );
+  cache.Finish("test2", "GetZoneInfo", response("2"), 0);
+
+  cache.Invalidate("test1");
+  REQUIRE( !cache.Acquire("test1", "GetZoneInfo", vars) );
+  // changed while in flight: the response isn't kept
+  cache.Invalidate("test1");
+  cache.Finish("test1", "GetZoneInfo", response("3"), 60000);
+  REQUIRE( !cache.Acquire("test1", "GetZoneInfo", vars) );
+  cache.Finish("test1", "GetZoneInfo", response("4"), 60000);
+  REQUIRE( cache.Acquire("test1", "GetZoneInfo", vars) );
+  REQUIRE( vars.GetValue("SerialNumber") == "4" );
+}
+
+TEST_CASE("Share the request in flight")
+{
+  RequestCache& cache = RequestCache::Instance();
+  ElementList vars;
+  REQUIRE( !cache.Acquire("test3", "GetZoneInfo", vars) );
+  ElementList shared;
+  bool found = false;
+  std::thread waiter([&cache, &shared, &found]() {
+    found = cache.Acquire("test3", "GetZoneInfo", shared);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // the failed response isn't kept, but it is shared with the waiter
+  cache.Finish("test3", "GetZoneInfo", response("5"), 0);
+  waiter.join();
+  REQUIRE( found );
+  REQUIRE( shared.GetValue("SerialNumber") == "5" );
+  REQUIRE( !cache.Acquire("test3", "GetZoneInfo", vars) );
+  cache.Finish("test3", "GetZoneInfo", response("6"), 0);
+}
+
+static SOAPStub::Reply transport(const SOAPStub::Request& request)
+{
+  if (request.action == "GetTransportInfo")
+    return SOAPStub::Response("AVTransport", request.action, "<CurrentTransportState>PLAYING</CurrentTransportState>");
+  return SOAPStub::Response("AVTransport", request.action, "");
+}
+
+static unsigned countRequests(SOAPStub& stub, const char * action)
+{
+  unsigned n = 0;
+  for (const SOAPStub::Request& request : stub.GetRequests())
+    if (request.action == action)
+      ++n;
+  return n;
+}
+
+TEST_CASE("Drop the cached responses after an asynchronous action")
+{
+  SOAPStub stub(transport);
+  REQUIRE( stub.IsValid() );
+  AVTransport avt("127.0.0.1", stub.GetPort());
+  ElementList vars;
+  REQUIRE( avt.GetTransportInfo(vars) );
+  REQUIRE( avt.GetTransportInfo(vars) );
+  REQUIRE( countRequests(stub, "GetTransportInfo") == 1 );
+
+  // a Get* doesn't change the state
+  ElementList args;
+  args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  REQUIRE( avt.RequestAsync("GetMediaInfo", args)->Wait(5000) );
+  REQUIRE( avt.GetTransportInfo(vars) );
+  REQUIRE( countRequests(stub, "GetTransportInfo") == 1 );
+
+  args.push_back(ElementPtr(new Element("Unit", "REL_TIME")));
+  args.push_back(ElementPtr(new Element("Target", "0:01:00")));
+  REQUIRE( avt.RequestAsync("Seek", args)->Wait(5000) );
+  REQUIRE( avt.GetTransportInfo(vars) );
+  REQUIRE( countRequests(stub, "GetTransportInfo") == 2 );
+}
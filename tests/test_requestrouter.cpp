@@ -0,0 +1,109 @@
+#include <string>
+
+#include <test.h>
+
+#include <private/requestrouter.h>
+
+using namespace NSROOT;
+
+class StubBroker : public RequestBroker
+{
+public:
+  StubBroker(const char * name, const RouteList& routes) : m_name(name), m_routes(routes) { }
+  bool HandleRequest(handle * handle) override { (void)handle; return false; }
+  const char * CommonName() override { return m_name; }
+  RouteList GetRoutes() override { return m_routes; }
+  ResourcePtr GetResource(const std::string& title) override { (void)title; return ResourcePtr(); }
+  ResourceList GetResourceList() override { return ResourceList(); }
+  ResourcePtr RegisterResource(const std::string& title, const std::string& description,
+                               const std::string& path, StreamReader * delegate) override
+  { (void)title; (void)description; (void)path; (void)delegate; return ResourcePtr(); }
+  void UnregisterResource(const std::string& uri) override { (void)uri; }
+private:
+  const char * m_name;
+  RouteList m_routes;
+};
+
+static std::string names(const RequestRouter::Selection& list)
+{
+  std::string str;
+  for (const RequestBrokerPtr& rb : *list)
+    str.append(str.empty() ? "" : ",").append(rb->CommonName());
+  return str;
+}
+
+TEST_CASE("Route requests by method and prefix")
+{
+  RequestBroker::RouteList root, images, track, notify;
+  root.push_back(RequestBroker::Route("GET", "/"));
+  images.push_back(RequestBroker::Route("GET", "/images/"));
+  images.push_back(RequestBroker::Route("HEAD", "/images/"));
+  track.push_back(RequestBroker::Route("GET", "/music/track"));
+  notify.push_back(RequestBroker::Route("NOTIFY", "/"));
+
+  std::vector<RequestBrokerPtr> brokers;
+  brokers.push_back(RequestBrokerPtr(new StubBroker("images", images)));
+  brokers.push_back(RequestBrokerPtr(new StubBroker("main", root)));
+  brokers.push_back(RequestBrokerPtr(new StubBroker("notify", notify)));
+  brokers.push_back(RequestBrokerPtr(new StubBroker("track", track)));
+
+  RequestRouter router;
+  REQUIRE( router.Route(WS_METHOD_Get, "/")->empty() );
+
+  router.Update(brokers);
+  REQUIRE( names(router.Route(WS_METHOD_Notify, "/")) == "notify" );
+  REQUIRE( names(router.Route(WS_METHOD_Notify, "/any/path")) == "notify" );
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/")) == "main" );
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/images/cover.png")) == "images,main" );
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/images")) == "main" );
+  REQUIRE( names(router.Route(WS_METHOD_Head, "/images/cover.png")) == "images" );
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/music/track.flac")) == "track,main" );
+  REQUIRE( names(router.Route(WS_METHOD_Post, "/music/track.flac")) == "" );
+  REQUIRE( names(router.Route(WS_METHOD_UNKNOWN, "/")) == "" );
+}
+
+TEST_CASE("Fallback to brokers without route")
+{
+  RequestBroker::RouteList track, none;
+  track.push_back(RequestBroker::Route("GET", "/music/track"));
+  track.push_back(RequestBroker::Route("", "/music/any"));
+
+  std::vector<RequestBrokerPtr> brokers;
+  brokers.push_back(RequestBrokerPtr(new StubBroker("custom", none)));
+  brokers.push_back(RequestBrokerPtr(new StubBroker("track", track)));
+
+  RequestRouter router;
+  router.Update(brokers);
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/music/track.flac")) == "track,custom" );
+  REQUIRE( names(router.Route(WS_METHOD_Post, "/music/track.flac")) == "custom" );
+  REQUIRE( names(router.Route(WS_METHOD_Delete, "/music/any")) == "track,custom" );
+
+  // the table is replaced on update
+  brokers.pop_back();
+  router.Update(brokers);
+  REQUIRE( names(router.Route(WS_METHOD_Get, "/music/track.flac")) == "custom" );
+}
+
+TEST_CASE("Release the replaced tables")
+{
+  RequestBroker::RouteList track;
+  track.push_back(RequestBroker::Route("GET", "/music/track"));
+  RequestBrokerPtr rb(new StubBroker("track", track));
+  std::vector<RequestBrokerPtr> brokers;
+  brokers.push_back(rb);
+
+  RequestRouter router;
+  router.Update(brokers);
+  brokers.clear();
+  int count = rb.use_count();
+  {
+    // a selection in progress keeps its table
+    RequestRouter::Selection selection = router.Route(WS_METHOD_Get, "/music/track.flac");
+    router.Update(brokers);
+    REQUIRE( names(selection) == "track" );
+    REQUIRE( rb.use_count() == count );
+    REQUIRE( names(router.Route(WS_METHOD_Get, "/music/track.flac")) == "" );
+  }
+  // the broker is no longer referenced by the router
+  REQUIRE( rb.use_count() == 1 );
+}
@@ -0,0 +1,37 @@
+#include <test.h>
+
+#include <private/socket.h>
+
+using namespace NSROOT;
+
+TEST_CASE("Resolve the host name once")
+{
+  TcpServerSocket server;
+  REQUIRE( server.Create(SOCKET_AF_INET4) );
+  REQUIRE( server.Bind(1498) );
+  REQUIRE( server.ListenConnection() );
+
+  ResolverCache::Clear();
+  unsigned hits = ResolverCache::GetHitCount();
+  unsigned misses = ResolverCache::GetMissCount();
+  // a literal address isn't cached
+  TcpSocket socket;
+  REQUIRE( socket.Connect("127.0.0.1", 1498, 0) );
+  socket.Disconnect();
+  REQUIRE( ResolverCache::GetHitCount() == hits );
+  REQUIRE( ResolverCache::GetMissCount() == misses );
+
+  REQUIRE( socket.Connect("localhost", 1498, 0) );
+  socket.Disconnect();
+  REQUIRE( ResolverCache::GetMissCount() == misses + 1 );
+  REQUIRE( socket.Connect("localhost", 1498, 0) );
+  socket.Disconnect();
+  REQUIRE( ResolverCache::GetHitCount() == hits + 1 );
+  REQUIRE( ResolverCache::GetMissCount() == misses + 1 );
+
+  // the entry is dropped when no address can be connected
+  REQUIRE( !socket.Connect("localhost", 1497, 0) );
+  REQUIRE( ResolverCache::GetMissCount() == misses + 2 );
+  REQUIRE( !socket.Connect("localhost", 1497, 0) );
+  REQUIRE( ResolverCache::GetMissCount() == misses + 3 );
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <list>
 
@@ -8,6 +9,7 @@
 #include <noson/didlparser.h>
 #include <private/tinyxml2.h>
 #include <private/xmldict.h>
+#include <private/soapresponseparser.h>
 
 TEST_CASE("Parse SOAP response 1")
 {
@@ -102,3 +104,89 @@ TEST_CASE("Parse SOAP response 1")
   SONOS::DIDLParser didl2(item->DIDL().c_str());
   REQUIRE(didl2.IsValid() == true);
 }
+
+static bool streamSOAP(const std::string& data, size_t chunk, SONOS::SOAPResponseParser& parser)
+{
+  for (size_t p = 0; p < data.size(); p += chunk)
+  {
+    if (!parser.Feed(data.data() + p, std::min(chunk, data.size() - p)))
+      return false;
+  }
+  return parser.Finish();
+}
+
+TEST_CASE("Stream SOAP response 1")
+{
+  const std::string data((const char*)soap_response_1_html, soap_response_1_html_len);
+  for (size_t chunk : { (size_t)7, (size_t)4096 })
+  {
+    SONOS::ElementList vars;
+    SONOS::SOAPResponseParser parser(vars);
+    REQUIRE(streamSOAP(data, chunk, parser));
+    REQUIRE(parser.IsSOAP());
+    REQUIRE(!parser.IsFault());
+    REQUIRE(vars.size() == 5);
+    REQUIRE((*vars[0]) == "BrowseResponse");
+    REQUIRE(vars[1]->GetKey() == "Result");
+    REQUIRE((*vars[1]).substr(0, 10) == "<DIDL-Lite");
+    REQUIRE(vars.GetValue("NumberReturned") == "24");
+    REQUIRE(vars.GetValue("UpdateID") == "154");
+
+    SONOS::DIDLParser didl(vars[1]->c_str());
+    REQUIRE(didl.IsValid() == true);
+    REQUIRE(didl.GetItems().size() == 24);
+    REQUIRE(didl.GetItems()[21]->GetValue("upnp:album") == "Œuvres pour piano (France Clidat)");
+  }
+}
+
+TEST_CASE("Stream SOAP fault")
+{
+  const std::string data(
+    "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\"><s:Body><s:Fault>"
+    "<faultcode>s:Client.TokenRefreshRequired</faultcode><faultstring>TokenRefreshRequired</faultstring>"
+    "<detail><ns:refreshAuthTokenResult><ns:authToken>NEW&amp;TOKEN</ns:authToken><ns:privateKey>KEY</ns:privateKey>"
+    "</ns:refreshAuthTokenResult><ns:other><ns:x>1</ns:x></ns:other></detail>"
+    "</s:Fault></s:Body></s:Envelope>");
+  SONOS::ElementList vars;
+  SONOS::SOAPResponseParser parser(vars);
+  REQUIRE(streamSOAP(data, 5, parser));
+  REQUIRE(parser.IsFault());
+  REQUIRE(vars.size() == 5);
+  REQUIRE(vars.GetValue("faultcode") == "s:Client.TokenRefreshRequired");
+  REQUIRE(vars.GetValue("authToken") == "NEW&TOKEN");
+  REQUIRE(vars.GetValue("privateKey") == "KEY");
+  REQUIRE(vars.GetValue("x") == "");
+}
+
+TEST_CASE("Stream SOAP response with trees")
+{
+  const std::string data(
+    "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\"><s:Header/><s:Body><ns:getMetadataResponse>"
+    "<ns:getMetadataResult><ns:index>0</ns:index><ns:mediaCollection id=\"a&quot;b\"><ns:title>A &lt; B</ns:title>"
+    "</ns:mediaCollection></ns:getMetadataResult><ns:empty/><ns:count>1</ns:count>"
+    "</ns:getMetadataResponse></s:Body></s:Envelope>");
+  {
+    SONOS::ElementList vars;
+    SONOS::SOAPResponseParser parser(vars, true);
+    REQUIRE(streamSOAP(data, 3, parser));
+    REQUIRE(vars.size() == 3);
+    REQUIRE((*vars[0]) == "getMetadataResponse");
+    REQUIRE(vars.GetValue("getMetadataResult") ==
+            "<ns:getMetadataResult><ns:index>0</ns:index><ns:mediaCollection id=\"a&quot;b\"><ns:title>A &lt; B</ns:title>"
+            "</ns:mediaCollection></ns:getMetadataResult>");
+    REQUIRE(vars.GetValue("count") == "1");
+  }
+  {
+    SONOS::ElementList vars;
+    SONOS::SOAPResponseParser parser(vars);
+    REQUIRE(streamSOAP(data, 4096, parser));
+    REQUIRE(vars.size() == 2);
+    REQUIRE(vars.GetValue("count") == "1");
+  }
+  {
+    SONOS::ElementList vars;
+    SONOS::SOAPResponseParser parser(vars);
+    REQUIRE(!streamSOAP("<html><body/></html>", 4096, parser));
+    REQUIRE(!parser.IsSOAP());
+  }
+}
@@ -0,0 +1,31 @@
+#include <string>
+
+#include <test.h>
+
+#include <private/soapenvelope.h>
+
+using namespace NSROOT;
+
+TEST_CASE("Build the envelope of an action")
+{
+  const SOAPEnvelope& envelope = SOAPEnvelope::Get("AVTransport", "AddURIToQueue");
+  REQUIRE( &envelope == &SOAPEnvelope::Get("AVTransport", "AddURIToQueue") );
+  REQUIRE( envelope.GetSOAPAction() == "\"urn:schemas-upnp-org:service:AVTransport:1#AddURIToQueue\"" );
+
+  ElementList args;
+  args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  args.push_back(ElementPtr(new Element("EnqueuedURIMetaData", "<DIDL-Lite a=\"b\">&amp;</DIDL-Lite>")));
+  args.back()->SetAttribut("x", "<\"&\">");
+  args.push_back(ElementPtr(new Element("Empty", "")));
+  std::string content;
+  envelope.Build(args, content);
+  std::string expected("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"
+    "<s:Body><u:AddURIToQueue xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">");
+  for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
+    expected.append((*it)->XML());
+  expected.append("</u:AddURIToQueue></s:Body></s:Envelope>");
+  REQUIRE( content == expected );
+  REQUIRE( args[1]->XML() == "<EnqueuedURIMetaData x=\"&lt;&quot;&amp;&quot;&gt;\">"
+                             "&lt;DIDL-Lite a=&quot;b&quot;&gt;&amp;amp;&lt;/DIDL-Lite&gt;</EnqueuedURIMetaData>" );
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <vector>
+
+#include <test.h>
+
+#include <private/timerwheel.h>
+
+using namespace NSROOT;
+
+static unsigned advance(TimerWheel& wheel, unsigned ticks, std::vector<unsigned>& expired)
+{
+  for (unsigned n = 0; n < ticks; ++n)
+    wheel.Tick(expired);
+  return (unsigned)expired.size();
+}
+
+TEST_CASE("Expire the timers on time")
+{
+  TimerWheel wheel;
+  // in the first level, then cascaded from each upper level, then parked
+  const unsigned delays[] = { 1, 63, 64, 65, 4095, 4096, 5000, 300000 };
+  for (unsigned id = 0; id < sizeof(delays) / sizeof(unsigned); ++id)
+    wheel.Schedule(id, delays[id]);
+  REQUIRE( wheel.Size() == 8 );
+  uint64_t prev = 0;
+  for (unsigned id = 0; id < sizeof(delays) / sizeof(unsigned); ++id)
+  {
+    std::vector<unsigned> expired;
+    REQUIRE( advance(wheel, (unsigned)(delays[id] - prev - 1), expired) == 0 );
+    REQUIRE( advance(wheel, 1, expired) == 1 );
+    REQUIRE( expired[0] == id );
+    prev = delays[id];
+  }
+  REQUIRE( wheel.Size() == 0 );
+  REQUIRE( wheel.NextTick() == 0 );
+}
+
+TEST_CASE("Cancel and reschedule the timers")
+{
+  TimerWheel wheel;
+  wheel.Schedule(1, 10);
+  wheel.Schedule(2, 10);
+  wheel.Schedule(3, 100);
+  REQUIRE( wheel.NextTick() == 10 );
+  REQUIRE( wheel.Cancel(2) );
+  REQUIRE( !wheel.Cancel(2) );
+  // replace the timer
+  wheel.Schedule(3, 20);
+  std::vector<unsigned> expired;
+  REQUIRE( advance(wheel, 10, expired) == 1 );
+  REQUIRE( expired[0] == 1 );
+  REQUIRE( advance(wheel, 10, expired) == 2 );
+  REQUIRE( expired[1] == 3 );
+  REQUIRE( advance(wheel, 200, expired) == 2 );
+  REQUIRE( !wheel.IsScheduled(3) );
+}
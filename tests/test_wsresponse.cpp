@@ -0,0 +1,112 @@
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <test.h>
+
+#include "soapstub.h"
+
+#include <private/wsresponse.h>
+#include <private/wsconnectionpool.h>
+#include <private/socket.h>
+
+using namespace NSROOT;
+
+#define RESPONSE_OK "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok"
+
+struct Reply
+{
+  const char * data;  // the bytes to send, or nullptr
+  bool close;         // close the connection after
+};
+
+struct Served
+{
+  unsigned connections = 0;
+  unsigned requests = 0;
+};
+
+static void serve(TcpServerSocket * server, std::vector<Reply> replies, Served * served)
+{
+  size_t next = 0;
+  while (next < replies.size())
+  {
+    TcpSocket sock;
+    if (server->AcceptConnection(sock, 5) != TcpServerSocket::ACCEPT_SUCCESS)
+      return;
+    ++served->connections;
+    while (next < replies.size())
+    {
+      std::string line;
+      size_t len;
+      bool ok;
+      // read the heading of the request, which has no content
+      while ((ok = WSResponse::ReadHeaderLine(&sock, "\r\n", line, &len)) && len > 0);
+      if (!ok)
+        break;
+      ++served->requests;
+      const Reply& reply = replies[next++];
+      if (reply.data)
+        sock.SendData(reply.data, strlen(reply.data));
+      if (reply.close)
+        break;
+    }
+    sock.Disconnect();
+  }
+  // a request sent again would open a new connection
+  TcpSocket sock;
+  if (server->AcceptConnection(sock, 1) == TcpServerSocket::ACCEPT_SUCCESS)
+    ++served->connections;
+}
+
+static bool get(unsigned port, int * status)
+{
+  WSRequest request("127.0.0.1", port);
+  request.RequestService("/");
+  WSResponse response(request);
+  *status = response.GetStatusCode();
+  if (!response.IsSuccessful())
+    return false;
+  char buf[4];
+  return (response.ReadContent(buf, sizeof(buf)) == 2);
+}
+
+TEST_CASE("Retry on a persistent connection closed by the server")
+{
+  TcpServerSocket server;
+  unsigned port = BindFreePort(server);
+  REQUIRE( port != 0 );
+  REQUIRE( server.ListenConnection() );
+  // the second request is read, then the connection is closed unanswered
+  std::vector<Reply> replies { { RESPONSE_OK, false }, { nullptr, true }, { RESPONSE_OK, false } };
+  Served served;
+  std::thread serving(serve, &server, replies, &served);
+  int status = 0;
+  REQUIRE( get(port, &status) );
+  REQUIRE( get(port, &status) );
+  serving.join();
+  REQUIRE( served.connections == 2 );
+  REQUIRE( served.requests == 3 );
+  WSConnectionPool::Instance().Clear();
+}
+
+TEST_CASE("Don't retry after a partial response")
+{
+  TcpServerSocket server;
+  unsigned port = BindFreePort(server);
+  REQUIRE( port != 0 );
+  REQUIRE( server.ListenConnection() );
+  // the server began to respond: the request could have been processed
+  std::vector<Reply> replies { { RESPONSE_OK, false }, { "HTTP/1.1 2", true } };
+  Served served;
+  std::thread serving(serve, &server, replies, &served);
+  int status = 0;
+  REQUIRE( get(port, &status) );
+  REQUIRE( !get(port, &status) );
+  REQUIRE( status == 0 );
+  serving.join();
+  REQUIRE( served.connections == 1 );
+  REQUIRE( served.requests == 2 );
+  WSConnectionPool::Instance().Clear();
+}
@@ -0,0 +1,100 @@
+#include <string>
+
+#include <test.h>
+
+#include <noson/zonegrouptopology.h>
+
+using namespace NSROOT;
+
+static std::string member(const char * uuid, const char * name, const char * version = "70.3-35220")
+{
+  return std::string("<ZoneGroupMember UUID=\"").append(uuid).append("\" Location=\"http://192.168.1.10:1400/xml/device_description.xml\"")
+          .append(" ZoneName=\"").append(name).append("\" Icon=\"x-rincon-roomicon:living\" SoftwareVersion=\"").append(version)
+          .append("\" BootSeq=\"42\"/>");
+}
+
+static std::string state(const std::string& groups)
+{
+  return std::string("<ZoneGroupState><ZoneGroups>").append(groups).append("</ZoneGroups><VanishedDevices/></ZoneGroupState>");
+}
+
+static void notify(ZoneGroupTopology& topology, unsigned seq, const std::string& xml)
+{
+  EventMessage * msg = new EventMessage();
+  msg->event = EVENT_UPNP_PROPCHANGE;
+  msg->subject.push_back("");
+  msg->subject.push_back(std::to_string(seq));
+  msg->subject.push_back("PROPERTY");
+  msg->subject.push_back("ZoneGroupState");
+  msg->subject.push_back(xml);
+  msg->Index();
+  topology.HandleEventMessage(EventMessagePtr(msg));
+}
+
+TEST_CASE("Update the zone groups incrementally")
+{
+  ZoneGroupTopology topology("127.0.0.1", 1400);
+  const std::string groupA("<ZoneGroup Coordinator=\"RINCON_A\" ID=\"RINCON_A:1\">" + member("RINCON_A", "Living") + "</ZoneGroup>");
+  const std::string groupB("<ZoneGroup Coordinator=\"RINCON_B\" ID=\"RINCON_B:1\">" + member("RINCON_B", "Kitchen") + "</ZoneGroup>");
+  const std::string groupC("<ZoneGroup Coordinator=\"RINCON_C\" ID=\"RINCON_C:1\">" + member("RINCON_C", "Office")
+                           + member("RINCON_D", "Hidden").replace(0, 16, "<ZoneGroupMember Invisible=\"1\"") + "</ZoneGroup>");
+
+  notify(topology, 1, state(groupA + groupB + groupC));
+  ZoneList zones = *(topology.GetZoneList().Get());
+  REQUIRE( zones.size() == 3 );
+  REQUIRE( topology.GetZonePlayerList().Get()->size() == 3 );
+  REQUIRE( zones["RINCON_C:1"]->size() == 1 );
+  REQUIRE( zones["RINCON_A:1"]->GetCoordinator()->GetUUID() == "RINCON_A" );
+  REQUIRE( topology.GetLastChanges().added.size() == 3 );
+
+  // the same state again: nothing changes
+  notify(topology, 2, state(groupA + groupB + groupC));
+  REQUIRE( topology.GetZoneList().Get()->at("RINCON_A:1").get() == zones["RINCON_A:1"].get() );
+
+  // a member is updated, a group is removed
+  const std::string groupB2("<ZoneGroup Coordinator=\"RINCON_B\" ID=\"RINCON_B:1\">" + member("RINCON_B", "Kitchen", "71.1-10000") + "</ZoneGroup>");
+  notify(topology, 3, state(groupA + groupB2));
+  ZoneListChanges changes = topology.GetLastChanges();
+  REQUIRE( changes.added.empty() );
+  REQUIRE( changes.modified.size() == 1 );
+  REQUIRE( changes.modified[0] == "RINCON_B:1" );
+  REQUIRE( changes.removed.size() == 1 );
+  REQUIRE( changes.removed[0] == "RINCON_C:1" );
+  {
+    Locked<ZoneList>::pointer next = topology.GetZoneList().Get();
+    REQUIRE( next->size() == 2 );
+    REQUIRE( next->at("RINCON_A:1").get() == zones["RINCON_A:1"].get() );
+    REQUIRE( next->at("RINCON_B:1").get() != zones["RINCON_B:1"].get() );
+    REQUIRE( next->at("RINCON_B:1")->at(0)->GetAttribut(ZP_VERSION) == "71.1-10000" );
+  }
+
+  // the coordinator is kept when joining a group, the member is renewed
+  const std::string groupAB("<ZoneGroup Coordinator=\"RINCON_A\" ID=\"RINCON_A:1\">" + member("RINCON_A", "Living")
+                            + member("RINCON_B", "Kitchen", "71.1-10000") + "</ZoneGroup>");
+  ZonePlayerPtr living = zones["RINCON_A:1"]->at(0);
+  ZonePlayerPtr kitchen = topology.GetZoneList().Get()->at("RINCON_B:1")->at(0);
+  notify(topology, 4, state(groupAB));
+  {
+    Locked<ZoneList>::pointer next = topology.GetZoneList().Get();
+    REQUIRE( next->size() == 1 );
+    REQUIRE( next->at("RINCON_A:1")->size() == 2 );
+    REQUIRE( next->at("RINCON_A:1")->at(0).get() == living.get() );
+    REQUIRE( next->at("RINCON_A:1")->at(1).get() != kitchen.get() );
+    REQUIRE( next->at("RINCON_A:1")->at(1)->GetAttribut(ZP_COORDINATOR) == "false" );
+  }
+}
+
+TEST_CASE("Ignore the attributes not retained")
+{
+  ZoneGroupTopology topology("127.0.0.1", 1400);
+  const std::string groups("<ZoneGroup Coordinator=\"RINCON_A\" ID=\"RINCON_A:1\">" + member("RINCON_A", "Living") + "</ZoneGroup>");
+  notify(topology, 1, state(groups));
+  unsigned key = topology.GetTopologyKey();
+  REQUIRE( key != 0 );
+  // a state only different by an attribute which is not retained
+  std::string other = state(groups);
+  other.replace(other.find("BootSeq=\"42\""), 12, "BootSeq=\"43\"");
+  notify(topology, 2, other);
+  REQUIRE( topology.GetLastChanges().empty() );
+  REQUIRE( topology.GetTopologyKey() == key );
+}